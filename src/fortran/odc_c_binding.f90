@@ -192,6 +192,13 @@ interface
      type(C_PTR)                          :: odb_select_iterator_new_from_file
    end function odb_select_iterator_new_from_file
 
+   function odb_select_bind(odb, filename) bind(C, name="odb_select_bind")
+     use, intrinsic                       :: iso_c_binding
+     type(C_PTR), VALUE                   :: odb
+     character(kind=C_CHAR),dimension(*)  :: filename
+     integer(kind=C_INT)                  :: odb_select_bind
+   end function odb_select_bind
+
    function odb_select_iterator_delete(odb_iterator) bind(C, name="odb_select_iterator_destroy")
      use, intrinsic                       :: iso_c_binding
      type(C_PTR), VALUE                   :: odb_iterator
@@ -8,14 +8,24 @@
  * does it submit to any jurisdiction.
  */
 
+#include <algorithm>
+#include <exception>
+#include <future>
+#include <mutex>
+
 #include "eckit/config/Resource.h"
 #include "eckit/exception/Exceptions.h"
 #include "eckit/filesystem/PathName.h"
+#include "eckit/io/Buffer.h"
 #include "eckit/log/Log.h"
 
+#include "odc/api/StridedData.h"
 #include "odc/Comparator.h"
 #include "odc/core/Column.h"
+#include "odc/core/DecodeTarget.h"
 #include "odc/core/MetaData.h"
+#include "odc/core/Table.h"
+#include "odc/core/TablesReader.h"
 #include "odc/LibOdc.h"
 #include "odc/Reader.h"
 #include "odc/StringTool.h"
@@ -224,6 +234,295 @@ void Comparator::compare(int nCols,
 }
 
 
+namespace {
+
+/// Decode the (non-skipped) columns of a table into one contiguous array per column
+
+std::vector<std::vector<double>> decodeColumns(Table& table, const std::vector<char>& skip) {
+
+    const MetaData& md(table.columns());
+    size_t nrows = table.rowCount();
+
+    std::vector<std::vector<double>> values(md.size());
+    std::vector<std::string> names;
+    std::vector<StridedData> facades;
+
+    for (size_t i = 0; i < md.size(); ++i) {
+        if (skip[i]) continue;
+        size_t width = md[i]->dataSizeDoubles() * sizeof(double);
+        values[i].resize(nrows * md[i]->dataSizeDoubles());
+        names.push_back(md[i]->name());
+        facades.emplace_back(&values[i][0], nrows, width, width);
+    }
+
+    DecodeTarget target(names, std::move(facades));
+    table.decode(target);
+    return values;
+}
+
+bool identicalEncoding(Table& table1, Table& table2) {
+
+    if (table1.nextPosition() - table1.startPosition() != table2.nextPosition() - table2.startPosition())
+        return false;
+
+    const Buffer encoded1(table1.readEncodedData(true));
+    const Buffer encoded2(table2.readEncodedData(true));
+    return encoded1.size() == encoded2.size() && ::memcmp(encoded1, encoded2, encoded1.size()) == 0;
+}
+
+/// Can the frames be decoded, and compared, column by column?
+
+bool columnwiseComparable(const Table& table1, const Table& table2) {
+
+    const MetaData& md1(table1.columns());
+    const MetaData& md2(table2.columns());
+    if (table1.rowCount() != table2.rowCount() || md1.size() != md2.size()) return false;
+
+    std::set<std::string> names;
+    for (size_t i = 0; i < md1.size(); ++i) {
+        if (md1[i]->type() != md2[i]->type()) return false;
+        if (md1[i]->type() != STRING && (md1[i]->dataSizeDoubles() != 1 || md2[i]->dataSizeDoubles() != 1)) return false;
+        if (!names.insert(md1[i]->name()).second) return false;
+    }
+    return true;
+}
+
+}
+
+
+size_t Comparator::firstDifference(const Column& column1, const Column& column2,
+                                   const double* data1, const double* data2, size_t nrows) const {
+
+    const size_t width1 = column1.dataSizeDoubles();
+    const size_t width2 = column2.dataSizeDoubles();
+
+    // n.b. Exactly the same tests as the row-wise comparison above
+
+    const bool testMissing1 = column1.hasMissing() || skipTestingHaveMissing_;
+    const bool testMissing2 = column2.hasMissing() || skipTestingHaveMissing_;
+    double missing1 = column1.missingValue();
+    double missing2 = column2.missingValue();
+    uint64_t missingBits1;
+    uint64_t missingBits2;
+    ::memcpy(&missingBits1, &missing1, sizeof(missingBits1));
+    ::memcpy(&missingBits2, &missing2, sizeof(missingBits2));
+
+    // Identical columns need no further inspection
+
+    if (width1 == width2 && testMissing1 == testMissing2 && (!testMissing1 || missingBits1 == missingBits2) &&
+        ::memcmp(data1, data2, nrows * width1 * sizeof(double)) == 0) {
+        return nrows;
+    }
+
+    if (column1.type() == STRING) {
+        for (size_t row = 0; row < nrows; ++row) {
+            const char* s1 = reinterpret_cast<const char*>(&data1[row * width1]);
+            const char* s2 = reinterpret_cast<const char*>(&data2[row * width2]);
+            uint64_t bits1;
+            uint64_t bits2;
+            ::memcpy(&bits1, s1, sizeof(bits1));
+            ::memcpy(&bits2, s2, sizeof(bits2));
+            bool isMissing1 = testMissing1 && bits1 == missingBits1;
+            bool isMissing2 = testMissing2 && bits2 == missingBits2;
+            if (isMissing1 != isMissing2) return row;
+            if (isMissing1) continue;
+            size_t len1 = ::strnlen(s1, width1 * sizeof(double));
+            size_t len2 = ::strnlen(s2, width2 * sizeof(double));
+            if (len1 != len2 || ::strncmp(s1, s2, len1)) return row;
+        }
+        return nrows;
+    }
+
+    const bool isReal = (column1.type() == REAL);
+    const bool nanIsOK = NaN_isOK_;
+
+    auto equal = [&](size_t row) -> bool {
+        double d1 = data1[row];
+        double d2 = data2[row];
+        uint64_t bits1;
+        uint64_t bits2;
+        ::memcpy(&bits1, &d1, sizeof(bits1));
+        ::memcpy(&bits2, &d2, sizeof(bits2));
+        bool isMissing1 = testMissing1 & (bits1 == missingBits1);
+        bool isMissing2 = testMissing2 & (bits2 == missingBits2);
+        bool sameValue = isReal ? same(float(d1), float(d2)) : same(d1, d2);
+        sameValue |= nanIsOK & ::isnan(d1) & ::isnan(d2);
+        return (isMissing1 == isMissing2) & (isMissing1 | sameValue);
+    };
+
+    // Test blocks of rows without branching on each result, so the loop can be vectorised. Only
+    // search for the exact row in a block containing a difference.
+
+    const size_t blockSize = 1024;
+    for (size_t start = 0; start < nrows; start += blockSize) {
+        size_t end = std::min(nrows, start + blockSize);
+        bool allEqual = true;
+        for (size_t row = start; row < end; ++row) {
+            allEqual &= equal(row);
+        }
+        if (!allEqual) {
+            for (size_t row = start; row < end; ++row) {
+                if (!equal(row)) return row;
+            }
+        }
+    }
+
+    return nrows;
+}
+
+
+void Comparator::compareTables(const PathName& p1, const PathName& p2,
+                               const std::vector<std::string>& excludedColumnsTypes,
+                               const std::vector<std::string>& excludedColumns,
+                               size_t nthreads)
+{
+    Tracer t(Log::debug<LibOdc>(), std::string("Comparator::compareTables: ") + p1 + ", " + p2);
+
+    std::vector<Table> tables1;
+    std::vector<Table> tables2;
+
+    TablesReader reader1(p1);
+    TablesReader reader2(p2);
+    for (auto it = reader1.begin(); it != reader1.end(); ++it) tables1.emplace_back(*it);
+    for (auto it = reader2.begin(); it != reader2.end(); ++it) tables2.emplace_back(*it);
+
+    bool matchingFrames = (!tables1.empty() && tables1.size() == tables2.size());
+    for (size_t i = 0; matchingFrames && i < tables1.size(); ++i) {
+        matchingFrames = columnwiseComparable(tables1[i], tables2[i]);
+    }
+
+    if (!matchingFrames) {
+        LOG_DEBUG_LIB(LibOdc) << "Comparator::compareTables: frames do not correspond. Comparing row by row" << std::endl;
+        compare(p1, p2, excludedColumnsTypes, excludedColumns);
+        return;
+    }
+
+    Log::info() << "Comparator::compare: (1) " << p1 << " to (2) " << p2 << std::endl;
+
+    std::set<std::string> excludedColumnsTypesSet(excludedColumnsTypes.begin(), excludedColumnsTypes.end());
+    std::set<std::string> excludedColumnsSet(excludedColumns.begin(), excludedColumns.end());
+
+    // Check the column definitions in order. Only the frames before any incompatible pair need
+    // their data comparing (as rows are compared before the next frame's columns).
+
+    std::vector<std::vector<int>> skipCols(tables1.size());
+    std::vector<std::vector<char>> skip(tables1.size());
+    std::exception_ptr incompatibleColumns;
+    size_t ntables = 0;
+
+    for (; ntables < tables1.size(); ++ntables) {
+        try {
+            compare(tables1[ntables].columns(), tables2[ntables].columns(), excludedColumnsTypesSet,
+                    excludedColumnsSet, skipCols[ntables]);
+        } catch (...) {
+            incompatibleColumns = std::current_exception();
+            break;
+        }
+        skip[ntables].resize(tables1[ntables].columnCount(), false);
+        for (int col : skipCols[ntables]) skip[ntables][col] = true;
+    }
+
+    // Find the first differing row in each pair of frames. Once a difference is found, later
+    // frames are irrelevant.
+
+    auto compareFrames = [&](size_t i) -> size_t {
+
+        Table& table1(tables1[i]);
+        Table& table2(tables2[i]);
+        size_t nrows = table1.rowCount();
+
+        if (nrows == 0 || identicalEncoding(table1, table2)) return nrows;
+
+        std::vector<std::vector<double>> values1(decodeColumns(table1, skip[i]));
+        std::vector<std::vector<double>> values2(decodeColumns(table2, skip[i]));
+
+        size_t first = nrows;
+        for (size_t col = 0; col < table1.columnCount(); ++col) {
+            if (skip[i][col]) continue;
+            first = std::min(first, firstDifference(*table1.columns()[col], *table2.columns()[col],
+                                                    &values1[col][0], &values2[col][0], first));
+        }
+        return first;
+    };
+
+    std::vector<size_t> firstDifferences(ntables);
+    size_t firstDifferentFrame = ntables;
+
+    nthreads = std::max<size_t>(1, std::min(nthreads, ntables));
+    std::mutex guard_mutex;
+    std::vector<std::future<void>> threads;
+    size_t next_frame = 0;
+
+    for (size_t i = 0; i < nthreads; i++) {
+        threads.emplace_back(std::async(std::launch::async, [&] {
+            while (true) {
+                size_t frame;
+
+                {
+                    std::lock_guard<std::mutex> guard(guard_mutex);
+                    if (next_frame < firstDifferentFrame) {
+                        frame = next_frame++;
+                    } else {
+                        return;
+                    }
+                }
+
+                size_t first = compareFrames(frame);
+                firstDifferences[frame] = first;
+
+                if (first != tables1[frame].rowCount()) {
+                    std::lock_guard<std::mutex> guard(guard_mutex);
+                    firstDifferentFrame = std::min(firstDifferentFrame, frame);
+                }
+            }
+        }));
+    }
+
+    // Waits for the threads. If any exceptions have been thrown, they get thrown into
+    // the main thread here.
+    for (auto& thread : threads) {
+        thread.get();
+    }
+
+    // Report the first difference as the row-wise comparison would
+
+    nRow_ = 0;
+    for (size_t i = 0; i < firstDifferentFrame; ++i) nRow_ += tables1[i].rowCount();
+
+    if (firstDifferentFrame < ntables) {
+
+        size_t i = firstDifferentFrame;
+        size_t row = firstDifferences[i];
+        nRow_ += row + 1;
+
+        std::vector<std::vector<double>> values1(decodeColumns(tables1[i], skip[i]));
+        std::vector<std::vector<double>> values2(decodeColumns(tables2[i], skip[i]));
+
+        const MetaData& md1(tables1[i].columns());
+        const MetaData& md2(tables2[i].columns());
+
+        std::vector<double> data1;
+        std::vector<double> data2;
+        for (size_t col = 0; col < md1.size(); ++col) {
+            size_t width1 = md1[col]->dataSizeDoubles();
+            size_t width2 = md2[col]->dataSizeDoubles();
+            if (skip[i][col]) {
+                data1.insert(data1.end(), width1, 0);
+                data2.insert(data2.end(), width2, 0);
+            } else {
+                data1.insert(data1.end(), &values1[col][row * width1], &values1[col][(row + 1) * width1]);
+                data2.insert(data2.end(), &values2[col][row * width2], &values2[col][(row + 1) * width2]);
+            }
+        }
+
+        compare(md1.size(), &data1[0], &data2[0], md1, md2, skipCols[i]);
+        throw SeriousBug("Frame comparison found a difference not confirmed row-wise", Here());
+    }
+
+    if (incompatibleColumns) std::rethrow_exception(incompatibleColumns);
+}
+
+
 void Comparator::compare(const MetaData& metaData1, const MetaData& metaData2,
                          const std::set<std::string>& excludedColumnsTypes,
                          const std::set<std::string>& excludedColumns,
@@ -61,6 +61,17 @@ public:
                  const std::vector<std::string>& excludedColumnsTypes,
                  const std::vector<std::string>& excludedcolumns);
 
+    /// Compare two files frame by frame. Pairs of frames whose encoded form (header and data) is
+    /// byte-identical are equal without being decoded. Other pairs are decoded column-wise, and
+    /// compared on up to nthreads threads. The first differing row is reported exactly as by the
+    /// row-wise comparison. If the files are not divided into frames of the same sizes, falls back
+    /// to comparing row by row.
+    void compareTables(const eckit::PathName& pathName1,
+                       const eckit::PathName& pathName2,
+                       const std::vector<std::string>& excludedColumnsTypes,
+                       const std::vector<std::string>& excludedColumns,
+                       size_t nthreads=1);
+
     void compare(const core::MetaData& metaData1, const core::MetaData& metaData2,
                  const std::set<std::string>& excludedColumnsTypes,
                  const std::set<std::string>& excludedColumns,
@@ -97,6 +108,11 @@ public:
     void raiseNotEqual(const core::Column&, double, double);
 
 private:
+
+    /// The first row at which two decoded columns differ, or nrows if they are the same
+    size_t firstDifference(const core::Column& column1, const core::Column& column2,
+                           const double* data1, const double* data2, size_t nrows) const;
+
     bool skipTestingHaveMissing_;
 	long nRow_;
 	bool NaN_isOK_;
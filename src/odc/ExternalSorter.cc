@@ -0,0 +1,526 @@
+/*
+ * (C) Copyright 1996-2018 ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <numeric>
+#include <thread>
+
+#include "eckit/exception/Exceptions.h"
+#include "eckit/io/DataHandle.h"
+#include "eckit/log/Log.h"
+
+#include "odc/core/TablesReader.h"
+#include "odc/ExternalSorter.h"
+#include "odc/LibOdc.h"
+#include "odc/ODBAPISettings.h"
+#include "odc/Writer.h"
+
+using namespace eckit;
+using namespace odc::api;
+
+namespace odc {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+std::vector<ExternalSorter::KeyColumn> keyColumns(const core::MetaData& columns,
+                                                  const std::vector<std::string>& keys,
+                                                  const size_t* offsets) {
+
+    std::vector<ExternalSorter::KeyColumn> keyColumns;
+    keyColumns.reserve(keys.size());
+
+    for (const std::string& key : keys) {
+        if (!columns.hasColumn(key)) throw UserError("Sort key column '" + key + "' not found", Here());
+        size_t idx = columns.columnIndex(key);
+        keyColumns.emplace_back(ExternalSorter::KeyColumn{offsets[idx], columns[idx]->dataSizeDoubles(), columns[idx]->type()});
+    }
+
+    return keyColumns;
+}
+
+
+/// Find a column by its exact name (not resolving names without a table)
+
+bool findColumn(const core::MetaData& columns, const std::string& name, size_t& idx) {
+    for (idx = 0; idx < columns.size(); ++idx) {
+        if (columns[idx]->name() == name) return true;
+    }
+    return false;
+}
+
+
+/// Three way comparison of the sort keys of two rows, which may have different layouts
+
+int compareRows(const std::vector<ExternalSorter::KeyColumn>& lhsKeys, const double* lhs,
+                const std::vector<ExternalSorter::KeyColumn>& rhsKeys, const double* rhs,
+                bool integersAsDoubles) {
+
+    ASSERT(lhsKeys.size() == rhsKeys.size());
+
+    for (size_t i = 0; i < lhsKeys.size(); ++i) {
+
+        const ExternalSorter::KeyColumn& lk(lhsKeys[i]);
+        const ExternalSorter::KeyColumn& rk(rhsKeys[i]);
+
+        if (lk.type == STRING || rk.type == STRING) {
+            ASSERT(lk.type == STRING && rk.type == STRING);
+            const char* ls = reinterpret_cast<const char*>(&lhs[lk.offset]);
+            const char* rs = reinterpret_cast<const char*>(&rhs[rk.offset]);
+            size_t llen = ::strnlen(ls, lk.sizeDoubles * sizeof(double));
+            size_t rlen = ::strnlen(rs, rk.sizeDoubles * sizeof(double));
+            int c = ::memcmp(ls, rs, std::min(llen, rlen));
+            if (c != 0) return c;
+            if (llen != rlen) return (llen < rlen) ? -1 : 1;
+            continue;
+        }
+
+        double lv = lhs[lk.offset];
+        double rv = rhs[rk.offset];
+
+        if (!integersAsDoubles) {
+            if (lk.type == INTEGER || lk.type == BITFIELD) lv = reinterpret_cast<const int64_t&>(lhs[lk.offset]);
+            if (rk.type == INTEGER || rk.type == BITFIELD) rv = reinterpret_cast<const int64_t&>(rhs[rk.offset]);
+        }
+
+        if (lv < rv) return -1;
+        if (rv < lv) return 1;
+    }
+
+    return 0;
+}
+
+
+/// A run of rows held in memory, all with the same column layout.
+
+struct Run {
+
+    Run(const core::MetaData& md, size_t rowSize) : columns(md), rowSizeDoubles(rowSize) {}
+
+    size_t rowCount() const { return data.size() / rowSizeDoubles; }
+    const double* row(size_t i) const { return &data[i * rowSizeDoubles]; }
+
+    core::MetaData columns;
+    size_t rowSizeDoubles;
+    std::vector<double> data;
+    std::vector<size_t> order;
+};
+
+
+/// Iterates over a sorted in-memory run, in the form needed by WriterBufferingIterator::pass1
+
+class RunIterator {
+public:
+    RunIterator(const Run* run=nullptr) : run_(run), pos_(0) {}
+    bool operator!=(const RunIterator&) const { return run_ && pos_ < run_->order.size(); }
+    RunIterator& operator++() { ++pos_; return *this; }
+    const RunIterator* operator->() const { return this; }
+
+    const core::MetaData& columns() const { return run_->columns; }
+    bool isNewDataset() const { return pos_ == 0; }
+    const double* data() const { return run_->row(run_->order[pos_]); }
+
+private:
+    const Run* run_;
+    size_t pos_;
+};
+
+
+void sortAndSpill(Run& run, const std::vector<std::string>& keys, const PathName& path, bool integersAsDoubles) {
+
+    // Settings are thread specific
+
+    ODBAPISettings::instance().treatIntegersAsDoubles(integersAsDoubles);
+
+    std::vector<size_t> offsets(run.columns.size());
+    size_t offset = 0;
+    for (size_t i = 0; i < run.columns.size(); ++i) {
+        offsets[i] = offset;
+        offset += run.columns[i]->dataSizeDoubles();
+    }
+    ASSERT(offset == run.rowSizeDoubles);
+
+    std::vector<ExternalSorter::KeyColumn> keyCols(keyColumns(run.columns, keys, &offsets[0]));
+
+    run.order.resize(run.rowCount());
+    std::iota(run.order.begin(), run.order.end(), 0);
+    std::stable_sort(run.order.begin(), run.order.end(), [&](size_t lhs, size_t rhs) {
+        return compareRows(keyCols, run.row(lhs), keyCols, run.row(rhs), integersAsDoubles) < 0;
+    });
+
+    LOG_DEBUG_LIB(LibOdc) << "ExternalSorter: spilling " << run.order.size() << " rows to " << path << std::endl;
+
+    Writer<> writer(path);
+    writer.frameIndex(false);
+    Writer<>::iterator outIt(writer.begin());
+    RunIterator it(&run);
+    RunIterator end;
+    outIt->pass1(it, end);
+}
+
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+ExternalSorter::iterator::iterator(std::shared_ptr<MergeState> state) :
+    state_(state) {}
+
+bool ExternalSorter::iterator::operator!=(const iterator&) const {
+    return state_ && !state_->noMore();
+}
+
+ExternalSorter::iterator& ExternalSorter::iterator::operator++() {
+    state_->next();
+    return *this;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+ExternalSorter::ExternalSorter(const std::vector<std::string>& keys,
+                               size_t maxMemory,
+                               const PathName& tmpDir,
+                               size_t maxFanIn,
+                               size_t sortThreads) :
+    keys_(keys),
+    maxMemory_(maxMemory),
+    tmpDir_(tmpDir),
+    maxFanIn_(maxFanIn),
+    sortThreads_(sortThreads),
+    rowCount_(0) {
+
+    if (keys_.empty()) throw UserError("No sort keys specified", Here());
+    ASSERT(maxFanIn_ >= 2);
+
+    if (sortThreads_ == 0) {
+        sortThreads_ = std::max<size_t>(1, std::min<size_t>(4, std::thread::hardware_concurrency()));
+    }
+
+    if (tmpDir_.asString().empty()) {
+        const char* tmp = ::getenv("TMPDIR");
+        tmpDir_ = (tmp && *tmp) ? tmp : "/tmp";
+    }
+}
+
+ExternalSorter::~ExternalSorter() {
+    for (const PathName& run : runs_) {
+        if (run.exists()) run.unlink();
+    }
+}
+
+PathName ExternalSorter::newRunPath() {
+    PathName path(PathName::unique(tmpDir_ / "odc-sort-run"));
+    return path + ".odb";
+}
+
+void ExternalSorter::sort(const PathName& input) {
+    Reader reader(input);
+    sort(reader);
+}
+
+void ExternalSorter::sort(DataHandle& input) {
+    Reader reader(input);
+    sort(reader);
+}
+
+void ExternalSorter::sort(Reader& reader) {
+
+    const bool integersAsDoubles = ODBAPISettings::instance().integersAsDoubles();
+
+    // The memory is shared between the run being read, and up to sortThreads_ runs being sorted
+
+    const size_t maxRunSize = std::max<size_t>(maxMemory_ / (sortThreads_ + 1), sizeof(double));
+
+    std::unique_ptr<Run> run;
+    std::deque<std::future<void>> sorting;
+
+    // Hand the current run over to be sorted and spilled in the background, once one of the workers
+    // (and its share of the memory) is free. The runs are of similar sizes, so wait for the oldest.
+
+    auto spill = [&]() {
+        if (!run || run->data.empty()) return;
+        if (sorting.size() == sortThreads_) {
+            sorting.front().get();
+            sorting.pop_front();
+        }
+        std::shared_ptr<Run> spilling(std::move(run));
+        runs_.push_back(newRunPath());
+        PathName path(runs_.back());
+        const std::vector<std::string>& keys(keys_);
+        sorting.emplace_back(std::async(std::launch::async, [spilling, &keys, path, integersAsDoubles]() {
+            sortAndSpill(*spilling, keys, path, integersAsDoubles);
+        }));
+    };
+
+    Reader::iterator it = reader.begin();
+    Reader::iterator end = reader.end();
+
+    for (; it != end; ++it) {
+
+        if (!run || (it->isNewDataset() && run->columns != it->columns())) {
+            spill();
+            run.reset(new Run(it->columns(), (**it).rowDataSizeDoubles()));
+        }
+
+        // Grow the run geometrically, rather than reserving the maximum run size up front (which may
+        // be much larger than the input).
+
+        if (run->data.size() + run->rowSizeDoubles > run->data.capacity()) {
+            size_t limit = maxRunSize / sizeof(double) + run->rowSizeDoubles;
+            size_t capacity = std::max(2 * run->data.capacity(), size_t(64 * 1024));
+            run->data.reserve(std::max(std::min(capacity, limit), run->data.size() + run->rowSizeDoubles));
+        }
+
+        const double* data = it->data();
+        run->data.insert(run->data.end(), data, data + run->rowSizeDoubles);
+        ++rowCount_;
+
+        if (run->data.size() * sizeof(double) >= maxRunSize) {
+            spill();
+        }
+    }
+
+    spill();
+    while (!sorting.empty()) {
+        sorting.front().get();
+        sorting.pop_front();
+    }
+}
+
+void ExternalSorter::mergePasses() {
+
+    while (runs_.size() > maxFanIn_) {
+
+        std::vector<PathName> merged;
+
+        for (size_t start = 0; start < runs_.size(); start += maxFanIn_) {
+
+            std::vector<PathName> group(runs_.begin() + start,
+                                        runs_.begin() + std::min(start + maxFanIn_, runs_.size()));
+
+            if (group.size() == 1) {
+                merged.push_back(group.front());
+                continue;
+            }
+
+            PathName path(newRunPath());
+
+            {
+                Writer<> writer(path);
+                writer.frameIndex(false);
+                Writer<>::iterator outIt(writer.begin());
+                iterator it(std::make_shared<MergeState>(group, keys_));
+                iterator end;
+                outIt->pass1(it, end);
+            }
+
+            for (const PathName& run : group) run.unlink();
+            merged.push_back(path);
+        }
+
+        runs_.swap(merged);
+    }
+}
+
+ExternalSorter::iterator ExternalSorter::begin() {
+    mergePasses();
+    return iterator(std::make_shared<MergeState>(runs_, keys_));
+}
+
+ExternalSorter::iterator ExternalSorter::end() {
+    return iterator();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+ExternalSorter::MergeState::Cursor::Cursor(const PathName& path) :
+    reader(new Reader(path)),
+    it(reader->begin()),
+    end(reader->end()) {}
+
+
+ExternalSorter::MergeState::MergeState(const std::vector<PathName>& runs, const std::vector<std::string>& keys) :
+    keyNames_(keys),
+    current_(0),
+    newDataset_(true),
+    unified_(false),
+    integersAsDoubles_(ODBAPISettings::instance().integersAsDoubles()) {
+
+    unified_ = unifyColumns(runs);
+
+    cursors_.reserve(runs.size());
+    for (const PathName& run : runs) {
+        cursors_.emplace_back(new Cursor(run));
+        Cursor& cursor(*cursors_.back());
+        if (cursor.it != cursor.end) {
+            updateLayout(cursor);
+            heap_.push_back(cursors_.size()-1);
+        }
+    }
+
+    std::make_heap(heap_.begin(), heap_.end(), [this](size_t l, size_t r) { return greater(l, r); });
+
+    if (!heap_.empty()) {
+        current_ = heap_.front();
+        lastColumns_ = columns();
+        fillRow();
+    }
+}
+
+ExternalSorter::MergeState::~MergeState() {}
+
+bool ExternalSorter::MergeState::unifyColumns(const std::vector<PathName>& runs) {
+
+    // Only the frame headers are read here
+
+    bool first = true;
+    for (const PathName& run : runs) {
+        core::TablesReader reader(run);
+        for (auto it = reader.begin(); it != reader.end(); ++it) {
+
+            const core::MetaData& columns(it->columns());
+
+            if (first) {
+                unifiedColumns_ = columns;
+                first = false;
+                continue;
+            }
+
+            if (columns.size() != unifiedColumns_.size()) return false;
+
+            for (const core::Column* column : columns) {
+                size_t idx;
+                if (!findColumn(unifiedColumns_, column->name(), idx)) return false;
+                core::Column& unified(*unifiedColumns_[idx]);
+                if (unified.type() != column->type() || unified.bitfieldDef() != column->bitfieldDef()) return false;
+                if (column->dataSizeDoubles() != unified.dataSizeDoubles()) {
+                    if (column->type() != STRING) return false;
+                    unified.dataSizeDoubles(std::max(column->dataSizeDoubles(), unified.dataSizeDoubles()));
+                }
+            }
+        }
+    }
+
+    if (first) return false;
+
+    size_t offset = 0;
+    unifiedOffsets_.clear();
+    for (const core::Column* column : unifiedColumns_) {
+        unifiedOffsets_.push_back(offset);
+        offset += column->dataSizeDoubles();
+    }
+    row_.resize(offset);
+
+    return true;
+}
+
+void ExternalSorter::MergeState::updateLayout(Cursor& cursor) {
+
+    ReaderIterator& ri(**cursor.it);
+    std::vector<size_t> offsets(ri.columns().size());
+    for (size_t i = 0; i < offsets.size(); ++i) offsets[i] = ri.dataOffset(i);
+    cursor.keys = keyColumns(ri.columns(), keyNames_, offsets.empty() ? nullptr : &offsets[0]);
+
+    if (unified_) {
+        cursor.sources.clear();
+        for (const core::Column* column : unifiedColumns_) {
+            size_t idx;
+            if (!findColumn(ri.columns(), column->name(), idx)) {
+                throw SeriousBug("Column '" + column->name() + "' missing from sorted run", Here());
+            }
+            cursor.sources.emplace_back(ColumnSource{offsets[idx], ri.columns()[idx]->dataSizeDoubles()});
+        }
+    }
+}
+
+void ExternalSorter::MergeState::fillRow() {
+
+    if (!unified_) return;
+
+    const Cursor& cursor(*cursors_[heap_.front()]);
+    const double* data = cursor.it->data();
+
+    for (size_t i = 0; i < cursor.sources.size(); ++i) {
+        const ColumnSource& source(cursor.sources[i]);
+        double* target = &row_[unifiedOffsets_[i]];
+        size_t targetSize = unifiedColumns_[i]->dataSizeDoubles();
+        size_t size = std::min(source.sizeDoubles, targetSize);
+        ::memcpy(target, &data[source.offset], size * sizeof(double));
+        if (size < targetSize) {
+            ::memset(&target[size], 0, (targetSize - size) * sizeof(double));
+        }
+    }
+}
+
+bool ExternalSorter::MergeState::greater(size_t lhs, size_t rhs) const {
+
+    const Cursor& l(*cursors_[lhs]);
+    const Cursor& r(*cursors_[rhs]);
+
+    int c = compareRows(l.keys, l.it->data(), r.keys, r.it->data(), integersAsDoubles_);
+
+    // Runs are produced in input order, so tie-breaking on the run index keeps the sort stable
+    return (c > 0) || (c == 0 && lhs > rhs);
+}
+
+void ExternalSorter::MergeState::next() {
+
+    ASSERT(!heap_.empty());
+
+    auto comp = [this](size_t l, size_t r) { return greater(l, r); };
+
+    std::pop_heap(heap_.begin(), heap_.end(), comp);
+    Cursor& cursor(*cursors_[heap_.back()]);
+
+    ++cursor.it;
+    if (cursor.it != cursor.end) {
+        if (cursor.it->isNewDataset()) updateLayout(cursor);
+        std::push_heap(heap_.begin(), heap_.end(), comp);
+    } else {
+        heap_.pop_back();
+    }
+
+    if (heap_.empty()) return;
+
+    // We only need to check the column layout if we have switched source, or the source has
+    // changed its layout. In the common layout, it never changes.
+
+    size_t front = heap_.front();
+    newDataset_ = false;
+    fillRow();
+    if (!unified_ && (front != current_ || cursors_[front]->it->isNewDataset())) {
+        if (columns() != lastColumns_) {
+            lastColumns_ = columns();
+            newDataset_ = true;
+        }
+    }
+
+    current_ = front;
+}
+
+const core::MetaData& ExternalSorter::MergeState::columns() const {
+    ASSERT(!heap_.empty());
+    if (unified_) return unifiedColumns_;
+    return cursors_[heap_.front()]->it->columns();
+}
+
+const double* ExternalSorter::MergeState::data() const {
+    ASSERT(!heap_.empty());
+    if (unified_) return &row_[0];
+    return cursors_[heap_.front()]->it->data();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace odc
@@ -0,0 +1,191 @@
+/*
+ * (C) Copyright 1996-2018 ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+#ifndef odc_ExternalSorter_H
+#define odc_ExternalSorter_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "eckit/filesystem/PathName.h"
+#include "eckit/memory/NonCopyable.h"
+
+#include "odc/api/ColumnType.h"
+#include "odc/Reader.h"
+
+namespace odc {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/// Sorts the rows of ODB data by a list of key columns, without requiring the decoded data to fit
+/// in memory.
+///
+/// The input is read into runs of bounded (decoded) size. Each run is handed to one of a bounded
+/// number of background workers, which sort the runs in parallel whilst the next is read, and spill
+/// them to temporary ODB files. The runs are then k-way merged, with intermediate merge passes if
+/// there are more runs than can be merged at once.
+///
+/// The sort is stable. Strings compare as strings (ignoring trailing NULs), all other columns
+/// numerically. Missing values sort according to their (sentinel) values.
+///
+/// Usage:
+///
+///     ExternalSorter sorter({"statid", "date"});
+///     sorter.sort(inFile);
+///     outIt->pass1(sorter.begin(), sorter.end());
+
+class ExternalSorter : private eckit::NonCopyable {
+
+public: // types
+
+    struct KeyColumn {
+        size_t offset;
+        size_t sizeDoubles;
+        api::ColumnType type;
+    };
+
+    class MergeState;
+
+    /// Iterates over the merged output. Models the (minimal) iterator interface required by the
+    /// writers' pass1() functions.
+
+    class iterator {
+    public:
+        iterator(std::shared_ptr<MergeState> state = std::shared_ptr<MergeState>());
+        bool operator!=(const iterator& other) const;
+        iterator& operator++();
+        MergeState* operator->() const { return state_.get(); }
+    private:
+        std::shared_ptr<MergeState> state_;
+    };
+
+public: // methods
+
+    /// @param maxMemory   Upper limit on the decoded size of the rows held in memory. It is shared
+    ///                    equally between the run being read and the runs being sorted, so each run
+    ///                    holds at most maxMemory / (sortThreads + 1).
+    /// @param tmpDir      Where to store the spilled runs. Defaults to $TMPDIR, or /tmp.
+    /// @param maxFanIn    Maximum number of runs that are merged (and held open) at once.
+    /// @param sortThreads Number of runs sorted and spilled in parallel. Defaults to the number of
+    ///                    hardware threads, up to 4.
+
+    ExternalSorter(const std::vector<std::string>& keys,
+                   size_t maxMemory=512*1024*1024,
+                   const eckit::PathName& tmpDir="",
+                   size_t maxFanIn=64,
+                   size_t sortThreads=0);
+    ~ExternalSorter();
+
+    /// Read, sort and spill the input data. May be called multiple times, with the same sort keys.
+    void sort(const eckit::PathName& input);
+    void sort(eckit::DataHandle& input);
+
+    iterator begin();
+    iterator end();
+
+    unsigned long long rowCount() const { return rowCount_; }
+
+private: // methods
+
+    void sort(Reader& reader);
+    eckit::PathName newRunPath();
+
+    /// Reduce the number of runs to no more than the maximum fan-in
+    void mergePasses();
+
+private: // members
+
+    std::vector<std::string> keys_;
+
+    size_t maxMemory_;
+    eckit::PathName tmpDir_;
+    size_t maxFanIn_;
+    size_t sortThreads_;
+
+    std::vector<eckit::PathName> runs_;
+
+    unsigned long long rowCount_;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/// The state of a k-way merge of sorted runs.
+
+class ExternalSorter::MergeState : private eckit::NonCopyable {
+
+public: // methods
+
+    MergeState(const std::vector<eckit::PathName>& runs, const std::vector<std::string>& keys);
+    ~MergeState();
+
+    bool noMore() const { return heap_.empty(); }
+    void next();
+
+    const core::MetaData& columns() const;
+    const double* data() const;
+    bool isNewDataset() const { return newDataset_; }
+
+private: // types
+
+    /// Where a column of the common output layout is found in the current row of a cursor
+    struct ColumnSource {
+        size_t offset;
+        size_t sizeDoubles;
+    };
+
+    struct Cursor {
+        Cursor(const eckit::PathName& path);
+        std::unique_ptr<Reader> reader;
+        Reader::iterator it;
+        Reader::iterator end;
+        std::vector<KeyColumn> keys;
+        std::vector<ColumnSource> sources;
+    };
+
+private: // methods
+
+    /// Determine if the frames of all the runs can be output with one column layout
+    bool unifyColumns(const std::vector<eckit::PathName>& runs);
+
+    void updateLayout(Cursor& cursor);
+    void fillRow();
+    bool greater(size_t lhs, size_t rhs) const;
+
+private: // members
+
+    std::vector<std::string> keyNames_;
+    std::vector<std::unique_ptr<Cursor>> cursors_;
+
+    /// Min-heap of indexes into cursors_, ordered by their current rows. The current output row is
+    /// at the front of the heap.
+    std::vector<size_t> heap_;
+
+    /// The source of the current output row, and the layout of the last dataset reported
+    size_t current_;
+    core::MetaData lastColumns_;
+    bool newDataset_;
+
+    /// If all the runs have the same columns, differing only in their order or the widths of the
+    /// strings, each row is copied into one common layout. Otherwise, rows from runs with different
+    /// layouts would break the output into many small frames.
+    bool unified_;
+    core::MetaData unifiedColumns_;
+    std::vector<size_t> unifiedOffsets_;
+    std::vector<double> row_;
+
+    bool integersAsDoubles_;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace odc
+
+#endif
@@ -180,7 +180,7 @@ public:
 			delete iter_;
 
 		iter_ = other.iter_;
-		++iter_->refCount_;
+		if (iter_) ++iter_->refCount_;
 		return *this;
 	}
 
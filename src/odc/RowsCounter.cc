@@ -8,7 +8,14 @@
  * does it submit to any jurisdiction.
  */
 
+#include <memory>
+
 #include "eckit/eckit.h"
+#include "eckit/filesystem/PathName.h"
+#include "eckit/io/DataHandle.h"
+
+#include "odc/core/Exceptions.h"
+#include "odc/core/Header.h"
 #include "odc/core/MetaData.h"
 #include "odc/core/TablesReader.h"
 #include "odc/Reader.h"
@@ -31,6 +38,32 @@ unsigned long long RowsCounter::fastRowCount(const PathName &db)
 	return n;
 }
 
+unsigned long long RowsCounter::headerRowCount(const PathName &db)
+{
+	unsigned long long n = 0;
+
+	std::unique_ptr<DataHandle> dh(db.fileHandle());
+	dh->openForRead();
+	AutoClose closer(*dh);
+
+	unsigned long long length = dh->estimate();
+	unsigned long long position = 0;
+
+	while (core::Header::readMagic(*dh))
+	{
+		size_t rows;
+		size_t frameSize;
+		core::Header::peekAfterMagic(*dh, rows, frameSize);
+
+		position += frameSize;
+		if (length != 0 && position > length) throw core::ODBIncomplete(dh->title(), Here());
+
+		n += rows;
+		ASSERT(dh->seek(Offset(position)) == Offset(position));
+	}
+	return n;
+}
+
 
 } // namespace odc 
 
@@ -17,6 +17,10 @@ class RowsCounter {
 public:
 	static unsigned long long fastRowCount(const eckit::PathName &);
 
+	/// Counts the rows reading only the start of each frame header. Header digests are not
+	/// verified, and no metadata or codecs are constructed.
+	static unsigned long long headerRowCount(const eckit::PathName &);
+
 private:
 // No copy allowed
     RowsCounter(const RowsCounter&);
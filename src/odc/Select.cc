@@ -15,10 +15,14 @@
 #include "eckit/io/DataHandle.h"
 #include "eckit/filesystem/PathName.h"
 
+#include "odc/core/MetaData.h"
+#include "odc/core/TablesReader.h"
+#include "odc/Reader.h"
 #include "odc/Select.h"
 #include "odc/SelectIterator.h"
 #include "odc/sql/SQLOutputConfig.h"
 #include "odc/sql/SQLSelectOutput.h"
+#include "odc/sql/TablePredicate.h"
 #include "odc/sql/TODATable.h"
 
 using namespace eckit;
@@ -29,20 +33,46 @@ namespace odc {
 
 // TODO: Select should BE a SelectIterator, not posess one.
 
+namespace {
+
+/// Read the columns of the first frame of a (seekable) input, leaving it positioned where it was.
+/// Only the header of the frame is read.
+
+bool firstFrameColumns(DataHandle& dh, core::MetaData& columns) {
+
+    Offset start = dh.position();
+    bool found = false;
+    {
+        core::TablesReader reader(dh);
+        auto it = reader.begin();
+        if (it != reader.end()) {
+            columns = it->columns();
+            found = true;
+        }
+    }
+    dh.seek(start);
+    return found;
+}
+
+}
+
 Select::Select(const std::string& selectStatement, bool manageOwnBuffer) :
     selectStatement_(selectStatement),
-    session_(std::unique_ptr<eckit::sql::SQLOutput>(new sql::SQLSelectOutput(manageOwnBuffer)),
-             std::unique_ptr<eckit::sql::SQLOutputConfig>(new odc::sql::SQLOutputConfig)),
+    manageOwnBuffer_(manageOwnBuffer),
+    implicitTable_(nullptr),
+    prepared_(nullptr),
     initted_(false),
-    it_(nullptr) {}
+    it_(nullptr) {
+
+    resetSession();
+}
 
 
 Select::Select(const std::string& selectStatement, DataHandle& dh, bool /* manageOwnBuffer */) :
     Select(selectStatement, true) {
 
     dh.openForRead();
-    eckit::sql::SQLDatabase& db(session_.currentDatabase());
-    db.addImplicitTable(new odc::sql::ODATable(db, dh));
+    addImplicitTable(dh);
 }
 
 
@@ -51,8 +81,7 @@ Select::Select(const std::string& selectStatement, const eckit::PathName& path,
 
     ownDH_.reset(path.fileHandle());
     ownDH_->openForRead();
-    eckit::sql::SQLDatabase& db(session_.currentDatabase());
-    db.addImplicitTable(new odc::sql::ODATable(db, *ownDH_));
+    addImplicitTable(*ownDH_);
 }
 
 Select::Select(const std::string &selectStatement, const char *path, bool manageOwnBuffer) :
@@ -66,16 +95,101 @@ Select::~Select() noexcept(false) {
 }
 
 eckit::sql::SQLDatabase& Select::database() {
-    return session_.currentDatabase();
+    return session_->currentDatabase();
+}
+
+
+void Select::resetSession() {
+
+    // n.b. The statement, and the tables, are owned by the session
+
+    prepared_ = nullptr;
+    preparedSql_.clear();
+    implicitTable_ = nullptr;
+
+    session_.reset(new eckit::sql::SQLSession(
+                       std::unique_ptr<eckit::sql::SQLOutput>(new sql::SQLSelectOutput(manageOwnBuffer_)),
+                       std::unique_ptr<eckit::sql::SQLOutputConfig>(new odc::sql::SQLOutputConfig)));
+}
+
+
+void Select::addImplicitTable(DataHandle& dh) {
+    eckit::sql::SQLDatabase& db(session_->currentDatabase());
+    implicitTable_ = new odc::sql::ODATable(db, dh);
+    db.addImplicitTable(implicitTable_);
+}
+
+
+void Select::rebind(DataHandle& dh) {
+
+    // Complete any iteration in progress, so that its statement can be executed again, and release
+    // the iterator before the session it belongs to may be replaced.
+
+    if (initted_) {
+        (*(*it_)).finish();
+        it_ = iterator(nullptr);
+        initted_ = false;
+    }
+
+    // Checking that the columns are compatible requires the header to be read twice, so the input
+    // must be seekable to reuse the prepared statement.
+
+    core::MetaData columns;
+    if (prepared_ && implicitTable_ && dh.canSeek() &&
+            firstFrameColumns(dh, columns) && columns.compatible(implicitTable_->inputColumns())) {
+        implicitTable_->rebind(Reader(dh));
+    } else {
+        resetSession();
+        addImplicitTable(dh);
+    }
+}
+
+
+void Select::bind(DataHandle& dh) {
+
+    dh.openForRead();
+    rebind(dh);
+
+    if (ownDH_) {
+        ownDH_->close();
+        ownDH_.reset();
+    }
+}
+
+
+void Select::bind(const eckit::PathName& path) {
+
+    std::unique_ptr<DataHandle> dh(path.fileHandle());
+    dh->openForRead();
+    rebind(*dh);
+
+    if (ownDH_) ownDH_->close();
+    ownDH_ = std::move(dh);
 }
 
 
 SelectIterator* Select::createSelectIterator(const std::string& sql) {
 
-    sql::SQLSelectOutput* output = dynamic_cast<sql::SQLSelectOutput*>(&session_.output());
+    sql::SQLSelectOutput* output = dynamic_cast<sql::SQLSelectOutput*>(&session_->output());
     ASSERT(output);
 
-    return new SelectIterator(sql, session_, *output);
+    // Pure projections of the table we created can be copied straight from its rows
+
+    output->rowSource((implicitTable_ && sql::TablePredicate::isProjection(sql)) ? implicitTable_ : nullptr);
+
+    // Reuse the parsed statement if the SQL is unchanged (see bind())
+
+    SelectIterator* it;
+    if (prepared_ && sql == preparedSql_) {
+        it = new SelectIterator(sql, *session_, *output, *prepared_);
+    } else {
+        prepared_ = nullptr;
+        it = new SelectIterator(sql, *session_, *output);
+        prepared_ = &it->statement();
+        preparedSql_ = sql;
+    }
+
+    return it;
 }
 
 const Select::iterator Select::end() { return iterator(nullptr); }
@@ -25,6 +25,7 @@
 
 namespace eckit { class PathName; }
 namespace eckit { class DataHandle; }
+namespace odc { namespace sql { struct ODATable; } }
 
 namespace odc {
 
@@ -56,8 +57,19 @@ public:
 
     SelectIterator* createSelectIterator(const std::string&);
 
+    /// Run the select over a new input. If the columns of the new input are compatible with those
+    /// of the current one (see MetaData::compatible), a statement that has already been parsed and
+    /// planned is reused rather than parsed again. Otherwise a new session is started, and the
+    /// statement is parsed on the next iteration. Existing iterators are invalidated.
+    void bind(eckit::DataHandle& dh);
+    void bind(const eckit::PathName& path);
+
 private:
 
+    void resetSession();
+    void addImplicitTable(eckit::DataHandle& dh);
+    void rebind(eckit::DataHandle& dh);
+
 
     friend class odc::IteratorProxy<odc::SelectIterator, odc::Select, const double>;
 
@@ -68,7 +80,16 @@ private:
 	std::string selectStatement_;
 	std::string delimiter_;
 
-    eckit::sql::SQLSession session_;
+    bool manageOwnBuffer_;
+
+    std::unique_ptr<eckit::sql::SQLSession> session_;
+
+    /// The table created from the DataHandle or path supplied, if any. n.b. non-owning
+    sql::ODATable* implicitTable_;
+
+    /// The most recently parsed statement, keyed by its SQL. n.b. owned by the session
+    std::string preparedSql_;
+    eckit::sql::SQLSelect* prepared_;
 
     // This is horrible, but the TextReader, and any stream based iteraton, can only
     // iterate once, so we MUST NOT create two iterators if begin() is called twice.
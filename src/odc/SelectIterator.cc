@@ -34,6 +34,18 @@ SelectIterator::SelectIterator(const std::string& select, eckit::sql::SQLSession
     parse();
 }
 
+SelectIterator::SelectIterator(const std::string& select, eckit::sql::SQLSession& s, sql::SQLSelectOutput& output,
+                               eckit::sql::SQLSelect& prepared) :
+    select_(select),
+    output_(output),
+    selectStmt_(&prepared),
+    session_(s),
+    noMore_(false),
+    refCount_(0) {
+
+    selectStmt_->prepareExecute();
+}
+
 SelectIterator::~SelectIterator() {}
 
 
@@ -63,6 +75,13 @@ bool SelectIterator::next() {
 }
 
 
+void SelectIterator::finish() {
+    if (noMore_) return;
+    selectStmt_->postExecute();
+    noMore_ = true;
+}
+
+
 void SelectIterator::setOutputRowBuffer(double* data, size_t count) {
     output_.resetBuffer(data, count);
 }
@@ -46,8 +46,16 @@ class SelectIterator : private eckit::NonCopyable {
 public:
 	
     SelectIterator (const std::string& select, eckit::sql::SQLSession& session, sql::SQLSelectOutput& output);
+
+    /// Execute a statement that has already been parsed (from the same SQL) in this session, without
+    /// parsing it again.
+    SelectIterator (const std::string& select, eckit::sql::SQLSession& session, sql::SQLSelectOutput& output,
+                    eckit::sql::SQLSelect& prepared);
 	~SelectIterator();
 
+    /// The parsed statement. n.b. owned by the session
+    eckit::sql::SQLSelect& statement() { return *selectStmt_; }
+
     // TODO: New dataset
     bool isNewDataset() { return output_.isNewDataset(); }
     const double* data() const { return output_.data(); }
@@ -77,6 +85,9 @@ public:
 
     bool next();
 
+    /// Complete the execution of the statement, even if not all its rows have been read
+    void finish();
+
 private:
 
     void parse();
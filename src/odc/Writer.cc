@@ -29,6 +29,7 @@ using namespace std;
 #include "eckit/filesystem/PathName.h"
 #include "eckit/io/FileDescHandle.h"
 #include "eckit/config/Resource.h"
+#include "eckit/utils/StringTools.h"
 
 #include "odc/codec/CodecOptimizer.h"
 #include "odc/core/Codec.h"
@@ -48,7 +49,8 @@ Writer<ITERATOR>::Writer()
   dataHandle_(0),
   rowsBufferSize_(eckit::Resource<long>("$ODB_ROWS_BUFFER_SIZE;-rowsBufferSize;rowsBufferSize", DEFAULT_ROWS_BUFFER_SIZE)),
   openDataHandle_(true),
-  deleteDataHandle_(true)
+  deleteDataHandle_(true),
+  frameIndex_(eckit::Resource<bool>("$ODC_WRITE_FRAME_INDEX", false))
 {} 
 
 template <typename ITERATOR>
@@ -57,7 +59,8 @@ Writer<ITERATOR>::Writer(const eckit::PathName& path)
   dataHandle_(0),
   rowsBufferSize_(eckit::Resource<long>("$ODB_ROWS_BUFFER_SIZE;-rowsBufferSize;rowsBufferSize", DEFAULT_ROWS_BUFFER_SIZE)),
   openDataHandle_(true),
-  deleteDataHandle_(true)
+  deleteDataHandle_(true),
+  frameIndex_(eckit::Resource<bool>("$ODC_WRITE_FRAME_INDEX", false))
 {
     if (path_ == "/dev/stdout" || path_ == "stdout")
     {
@@ -73,7 +76,8 @@ Writer<ITERATOR>::Writer(eckit::DataHandle *dh, bool openDataHandle, bool delete
   dataHandle_(dh),
   rowsBufferSize_(eckit::Resource<long>("$ODB_ROWS_BUFFER_SIZE;-rowsBufferSize;rowsBufferSize", DEFAULT_ROWS_BUFFER_SIZE)),
   openDataHandle_(openDataHandle),
-  deleteDataHandle_(deleteDataHandle)
+  deleteDataHandle_(deleteDataHandle),
+  frameIndex_(false)
 {}
 
 template <typename ITERATOR>
@@ -82,7 +86,8 @@ Writer<ITERATOR>::Writer(eckit::DataHandle &dh, bool openDataHandle)
   dataHandle_(&dh),
   rowsBufferSize_(eckit::Resource<long>("$ODB_ROWS_BUFFER_SIZE;-rowsBufferSize;rowsBufferSize", DEFAULT_ROWS_BUFFER_SIZE)),
   openDataHandle_(openDataHandle),
-  deleteDataHandle_(false)
+  deleteDataHandle_(false),
+  frameIndex_(false)
 {}
 
 template <typename ITERATOR>
@@ -95,7 +100,14 @@ typename Writer<ITERATOR>::iterator Writer<ITERATOR>::begin(bool openDataHandle)
 	if (dataHandle_ == 0)
     {
 		dh = ODBAPISettings::instance().writeToFile(path_, eckit::Length(0), false);
-        return typename Writer::iterator(new ITERATOR(*this, dh, openDataHandle));
+        ITERATOR* it = new ITERATOR(*this, dh, openDataHandle);
+        if (frameIndex_) {
+            core::FrameIndex::BloomOptions bloom;
+            bloom.columns = eckit::StringTools::split(",", eckit::Resource<std::string>("$ODC_FRAME_INDEX_BLOOM_COLUMNS", ""));
+            bloom.falsePositiveRate = eckit::Resource<double>("$ODC_FRAME_INDEX_BLOOM_FPR", 0.01);
+            it->writeFrameIndex(core::FrameIndex::indexPath(path_), bloom);
+        }
+        return typename Writer::iterator(it);
     }
 	else
 	{
@@ -47,7 +47,12 @@ public:
 	ITERATOR* createWriteIterator(eckit::PathName, bool append = false);
 
 	unsigned long rowsBufferSize() { return rowsBufferSize_; }
-	Writer& rowsBufferSize(unsigned long n) { rowsBufferSize_ = n; }
+	Writer& rowsBufferSize(unsigned long n) { rowsBufferSize_ = n; return *this; }
+
+    /// Whether a frame index is saved alongside the output file (see $ODC_WRITE_FRAME_INDEX).
+    /// Writers of temporary files should disable it.
+    bool frameIndex() const { return frameIndex_; }
+    Writer& frameIndex(bool b) { frameIndex_ = b; return *this; }
 
 	const eckit::PathName path() { return path_; }
 
@@ -62,6 +67,7 @@ private:
 
 	bool openDataHandle_;
 	bool deleteDataHandle_;
+    bool frameIndex_;
 };
 
 } // namespace odc
@@ -13,12 +13,16 @@
 ///
 /// @author Piotr Kuchta, Feb 2009
 
+#include <cstring>
+#include <unordered_set>
+
 #include "eckit/exception/Exceptions.h"
 #include "eckit/io/DataHandle.h"
 #include "eckit/log/Log.h"
 
 #include "odc/core/Header.h"
 #include "odc/LibOdc.h"
+#include "odc/ODBAPISettings.h"
 #include "odc/WriterBufferingIterator.h"
 #include "odc/Writer.h"
 
@@ -47,6 +51,10 @@ WriterBufferingIterator::WriterBufferingIterator(Owner &owner, DataHandle *dh, b
     nextRowInBuffer_(0),
     rowsBufferSize_(owner.rowsBufferSize()),
     tableDef_(tableDef),
+    frameIndex_(),
+    frameIndexPath_(),
+    frameIndexBloom_(),
+    bytesWritten_(0),
     openDataHandle_(openDataHandle)
 {
 	if (openDataHandle)
@@ -70,6 +78,10 @@ WriterBufferingIterator::WriterBufferingIterator(Owner &owner, DataHandle &dh, b
     nextRowInBuffer_(0),
     rowsBufferSize_(owner.rowsBufferSize()),
     tableDef_(tableDef),
+    frameIndex_(),
+    frameIndexPath_(),
+    frameIndexBloom_(),
+    bytesWritten_(0),
     openDataHandle_(openDataHandle)
 {
     if (openDataHandle)
@@ -354,6 +366,12 @@ void WriterBufferingIterator::flush()
     ASSERT(dataHandle().write(encodedHeader.first, encodedHeader.second) == long(encodedHeader.second)); // Write header
     ASSERT(dataHandle().write(encodedBuffer, encodedStream.position()) == encodedStream.position()); // Write encoded data
 
+    size_t frameLength = encodedHeader.second + encodedStream.position();
+    if (frameIndex_) {
+        indexFrame(FrameIndex::headerHash(encodedHeader.first, encodedHeader.second), frameLength, rowsWritten);
+    }
+    bytesWritten_ += frameLength;
+
     LOG_DEBUG_LIB(LibOdc) << "WriterBufferingIterator::flush: flushed " << rowsWritten << " rows." << std::endl;
 
     // Reset the write buffers
@@ -376,6 +394,12 @@ int WriterBufferingIterator::close()
 {
     if (initialisedColumns_) flush();
 
+    if (frameIndex_) {
+        frameIndex_->dataSize(Length(bytesWritten_));
+        frameIndex_->save(frameIndexPath_);
+        frameIndex_.reset();
+    }
+
     if (!openDataHandle_)
 	{
         handle().close();
@@ -383,6 +407,55 @@ int WriterBufferingIterator::close()
 	return 0;
 }
 
+void WriterBufferingIterator::writeFrameIndex(const PathName& indexFile, const FrameIndex::BloomOptions& bloom)
+{
+    ASSERT(bytesWritten_ == 0);
+    frameIndex_.reset(new FrameIndex);
+    frameIndexPath_ = indexFile;
+    frameIndexBloom_ = bloom;
+}
+
+void WriterBufferingIterator::indexFrame(uint64_t headerHash, size_t frameLength, size_t rowsWritten)
+{
+    ASSERT(frameIndex_);
+    FrameIndex::Frame& frame(frameIndex_->addFrame(Offset(bytesWritten_), Length(frameLength), rowsWritten, columns()));
+    frame.headerHash = headerHash;
+
+    // The (unencoded) rows are still in the rows buffer. Integers are held as int64_t bits unless
+    // they are being treated as doubles, and are indexed (like their statistics) by value.
+
+    const bool integersAsDoubles = ODBAPISettings::instance().integersAsDoubles();
+
+    for (size_t i = 0; i < columns_.size(); ++i) {
+
+        const Column& column(*columns_[i]);
+        if (!frameIndexBloom_.selects(column)) continue;
+
+        size_t width = column.dataSizeDoubles();
+        double missing = column.missingValue();
+        bool hasMissing = column.hasMissing();
+        bool asInteger = !integersAsDoubles && (column.type() == INTEGER || column.type() == BITFIELD);
+
+        std::unordered_set<uint64_t> hashes;
+        for (const unsigned char* p = reinterpret_cast<const unsigned char*>(rowsBuffer_.data()); p < nextRowInBuffer_; p += rowByteSize_) {
+            const double* v = reinterpret_cast<const double*>(p) + columnOffsets_[i];
+            if (column.type() == STRING) {
+                if (hasMissing && ::memcmp(v, &missing, sizeof(double)) == 0) continue;
+                const char* s = reinterpret_cast<const char*>(v);
+                hashes.insert(FrameIndex::BloomFilter::hash(s, ::strnlen(s, width * sizeof(double))));
+            } else {
+                double value = asInteger ? double(reinterpret_cast<const int64_t&>(*v)) : *v;
+                if (hasMissing && value == missing) continue;
+                hashes.insert(FrameIndex::BloomFilter::hash(value));
+            }
+        }
+
+        FrameIndex::BloomFilter filter(hashes.size(), frameIndexBloom_.falsePositiveRate, frameIndexBloom_.maxBytes);
+        for (uint64_t h : hashes) filter.insert(h);
+        frame.columns[i].bloom = std::move(filter);
+    }
+}
+
 std::vector<eckit::PathName> WriterBufferingIterator::outputFiles()
 {
     std::vector<eckit::PathName> r;
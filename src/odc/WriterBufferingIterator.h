@@ -16,11 +16,14 @@
 #ifndef odc_WriterBufferingIterator_H
 #define odc_WriterBufferingIterator_H
 
+#include <memory>
+
 #include "eckit/filesystem/PathName.h"
 #include "eckit/io/HandleHolder.h"
 #include "eckit/log/Log.h"
 
 #include "odc/codec/CodecOptimizer.h"
+#include "odc/core/FrameIndex.h"
 #include "odc/IteratorProxy.h"
 #include "odc/LibOdc.h"
 
@@ -95,6 +98,11 @@ public:
 
 	void flush();
 
+    /// Record the frames as they are written, and save a frame index to indexFile on close.
+    /// n.b. Only valid if the output is written from its start, and only by this iterator.
+    void writeFrameIndex(const eckit::PathName& indexFile,
+                         const core::FrameIndex::BloomOptions& bloom=core::FrameIndex::BloomOptions());
+
     std::vector<eckit::PathName> outputFiles();
     bool next();
 
@@ -128,6 +136,9 @@ private:
 
     void allocBuffers();
 	void allocRowsBuffer();
+
+    /// Add the frame held in the rows buffer to the frame index
+    void indexFrame(uint64_t headerHash, size_t frameLength, size_t rowsWritten);
 	void resetColumnsBuffer();
 
     int doWriteRow(core::DataStream<core::SameByteOrder>& stream, const double* values);
@@ -146,6 +157,11 @@ private:
 
     const odc::sql::TableDef* tableDef_;
 
+    std::unique_ptr<core::FrameIndex> frameIndex_;
+    eckit::PathName frameIndexPath_;
+    core::FrameIndex::BloomOptions frameIndexBloom_;
+    unsigned long long bytesWritten_;
+
 private:
     bool openDataHandle_;
 
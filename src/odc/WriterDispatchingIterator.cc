@@ -59,6 +59,7 @@ WriterDispatchingIterator<WRITE_ITERATOR, OWNER>::WriterDispatchingIterator(OWNE
   values2iteratorIndex_(),
   lastDispatch_(maxOpenFiles, -1),
   iteratorIndex2fileName_(maxOpenFiles),
+  iteratorIndex2values_(maxOpenFiles),
   lastDispatchedValues_(),
   lastIndex_(),
   initialized_(false),
@@ -151,13 +152,21 @@ WRITE_ITERATOR& WriterDispatchingIterator<WRITE_ITERATOR, OWNER>::dispatch(const
 template <typename WRITE_ITERATOR, typename OWNER>
 int WriterDispatchingIterator<WRITE_ITERATOR, OWNER>::dispatchIndex(const double* values, unsigned long count)
 {
+    // Fast path. Consecutive rows commonly dispatch to the same place.
+
+    if (lastDispatchedValues_.size() == dispatchedIndexes_.size()) {
+        size_t i = 0;
+        for (; i < dispatchedIndexes_.size(); ++i) {
+            if (!(values[dispatchedIndexes_[i]] == lastDispatchedValues_[i])) break;
+        }
+        if (i == dispatchedIndexes_.size()) return lastIndex_;
+    }
+
     Values dispatchedValues;
+    dispatchedValues.reserve(dispatchedIndexes_.size());
     for (size_t i (0); i < dispatchedIndexes_.size(); ++i)
         dispatchedValues.push_back(values[dispatchedIndexes_[i]]);
 
-    if (dispatchedValues == lastDispatchedValues_)
-        return lastIndex_;
-
     Values2IteratorIndex::iterator p (values2iteratorIndex_.find(dispatchedValues));
     size_t iteratorIndex ((p != values2iteratorIndex_.end())
                            ? p->second
@@ -196,11 +205,7 @@ int WriterDispatchingIterator<WRITE_ITERATOR, OWNER>::createIterator(const Value
         delete iterators_[iteratorIndex];
         iterators_[iteratorIndex] = 0;
 
-        Values2IteratorIndex::iterator vit (values2iteratorIndex_.begin());
-        for (; vit != values2iteratorIndex_.end(); ++vit)
-            if (vit->second == iteratorIndex)
-                break;
-        values2iteratorIndex_.erase(vit);
+        values2iteratorIndex_.erase(iteratorIndex2values_[iteratorIndex]);
     }
 
     std::string operation;
@@ -238,6 +243,7 @@ int WriterDispatchingIterator<WRITE_ITERATOR, OWNER>::createIterator(const Value
     }
     values2iteratorIndex_[dispatchedValues] = iteratorIndex;
     iteratorIndex2fileName_[iteratorIndex] = fileName;
+    iteratorIndex2values_[iteratorIndex] = dispatchedValues;
 
     // Prop. metadata
     iterators_[iteratorIndex]->columns(columns());
@@ -356,6 +362,43 @@ int WriterDispatchingIterator<WRITE_ITERATOR, OWNER>::writeRow(const double* val
     return rc;
 }
 
+template <typename WRITE_ITERATOR, typename OWNER>
+void WriterDispatchingIterator<WRITE_ITERATOR, OWNER>::resetColumns(const MetaData& md)
+{
+    if (initialized_ && columns() == md)
+        return;
+
+    columns(md);
+    parseTemplateParameters();
+
+    // The dispatch columns may have moved
+    lastDispatchedValues_.clear();
+
+    for (size_t i = 0; i < iterators_.size(); ++i)
+    {
+        iterators_[i]->flush();
+        iterators_[i]->columns(columns());
+        iterators_[i]->writeHeader();
+    }
+}
+
+template <typename WRITE_ITERATOR, typename OWNER>
+void WriterDispatchingIterator<WRITE_ITERATOR, OWNER>::writeEncoded(const double* values, unsigned long count,
+                                                                    const void* data, size_t length,
+                                                                    unsigned long long rows)
+{
+    if (!initialized_)
+        parseTemplateParameters();
+
+    WRITE_ITERATOR& wi = dispatch(values, count);
+
+    // Rows buffered for this output precede the frame in the input
+    wi.flush();
+    ASSERT(wi.dataHandle().write(data, length) == long(length));
+
+    nrows_ += rows;
+}
+
 template <typename WRITE_ITERATOR, typename OWNER>
 int WriterDispatchingIterator<WRITE_ITERATOR, OWNER>::open() { return 0; }
 
@@ -447,18 +490,8 @@ unsigned long WriterDispatchingIterator<WriterBufferingIterator,DispatchingWrite
 	nrows_  = 0;
 	for (; it != end; ++it)
 	{
-		if (it->isNewDataset() && columns() != it->columns() )
-		{
-			columns(it->columns());
-			parseTemplateParameters();
-
-			for (size_t i = 0; i < iterators_.size(); ++i)
-			{
-				iterators_[i]->flush();
-				iterators_[i]->columns(columns());
-				iterators_[i]->writeHeader();
-			}
-        }
+		if (it->isNewDataset())
+			resetColumns(it->columns());
 
 		const double* data (it->data());
 		size_t size (it->columns().size());
@@ -18,6 +18,8 @@
 
 #include <map>
 #include <cstdint>
+#include <cstring>
+#include <unordered_map>
 
 #include "eckit/sql/SQLTypedefs.h"
 
@@ -32,11 +34,27 @@ namespace odc {
 
 class TemplateParameters;
 
+/// Hash of the values of the dispatch columns for a row. Consistent with element-wise equality
+/// of the values (n.b. -0.0 == 0.0).
+
+struct DispatchValuesHash {
+    size_t operator()(const std::vector<double>& values) const {
+        size_t h = values.size();
+        for (double v : values) {
+            v += 0.0;
+            uint64_t bits;
+            ::memcpy(&bits, &v, sizeof(bits));
+            h ^= std::hash<uint64_t>()(bits) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+        }
+        return h;
+    }
+};
+
 template <typename WRITE_ITERATOR, typename OWNER >
 class WriterDispatchingIterator 
 {
 	typedef std::vector<double> Values;
-	typedef std::map<Values,int> Values2IteratorIndex;
+	typedef std::unordered_map<Values,int,DispatchValuesHash> Values2IteratorIndex;
 	typedef std::vector<WRITE_ITERATOR *> Iterators;
 public:
 	WriterDispatchingIterator (OWNER &owner, int maxOpenFiles, bool append = false);
@@ -86,6 +104,14 @@ public:
 
 	int writeRow(const double* values, unsigned long count);
 
+    /// Switch to a new set of input columns, if they differ from the current ones. Rows already
+    /// buffered in the outputs are flushed with the old columns.
+    void resetColumns(const core::MetaData& md);
+
+    /// Append an already encoded frame (including its header) without decoding it. Every row in
+    /// the frame must dispatch to the same output, selected by values.
+    void writeEncoded(const double* values, unsigned long count, const void* data, size_t length, unsigned long long rows);
+
     // If we are encoding strings, and the relevant string column size changes, we need
     // to restart the encoding process
     void flushAndResetColumnSizes(const std::map<std::string, size_t>& resetColumnSizeDoubles);
@@ -115,6 +141,7 @@ protected:
 	Values2IteratorIndex values2iteratorIndex_;
 	std::vector<unsigned long long> lastDispatch_;
 	std::vector<std::string> iteratorIndex2fileName_;
+	std::vector<Values> iteratorIndex2values_;
 
 	Values lastDispatchedValues_;
 	int lastIndex_;
@@ -0,0 +1,503 @@
+/*
+ * (C) Copyright 2019- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+/// Conversion between frames and the Apache Arrow C data interface
+
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+#include "eckit/exception/Exceptions.h"
+#include "eckit/io/DataHandle.h"
+
+#include "odc/api/Odb.h"
+#include "odc/ODBAPISettings.h"
+
+using namespace eckit;
+
+namespace odc {
+namespace api {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+/// The memory referenced by an exported schema, freed by its release callback
+
+struct ExportedSchema {
+    std::string format;
+    std::string name;
+    std::string metadata;
+    std::vector<ArrowSchema> children;
+    std::vector<ArrowSchema*> childPointers;
+    ArrowSchema dictionary {};
+};
+
+void releaseSchema(ArrowSchema* schema) {
+    ExportedSchema* exported = static_cast<ExportedSchema*>(schema->private_data);
+    for (ArrowSchema& child : exported->children) {
+        if (child.release) child.release(&child);
+    }
+    if (exported->dictionary.release) exported->dictionary.release(&exported->dictionary);
+    delete exported;
+    schema->release = nullptr;
+}
+
+ExportedSchema* initSchema(ArrowSchema& schema, const char* format, const std::string& name,
+                           int64_t flags, size_t nchildren=0) {
+
+    ExportedSchema* exported = new ExportedSchema;
+    exported->format = format;
+    exported->name = name;
+    exported->children.resize(nchildren);
+    for (ArrowSchema& child : exported->children) exported->childPointers.push_back(&child);
+
+    schema.format = exported->format.c_str();
+    schema.name = exported->name.c_str();
+    schema.metadata = nullptr;
+    schema.flags = flags;
+    schema.n_children = nchildren;
+    schema.children = nchildren ? &exported->childPointers[0] : nullptr;
+    schema.dictionary = nullptr;
+    schema.release = releaseSchema;
+    schema.private_data = exported;
+    return exported;
+}
+
+/// The buffers of an exported array, freed by its release callback
+
+struct ExportedArray {
+    std::vector<std::unique_ptr<char[]>> buffers;
+    std::vector<const void*> bufferPointers;
+    std::vector<ArrowArray> children;
+    std::vector<ArrowArray*> childPointers;
+    ArrowArray dictionary {};
+
+    /// Only the validity bitmaps need zeroing. The values are all written by decoding.
+    char* allocate(size_t index, size_t size, bool zero=false) {
+        size = std::max(size, size_t(1));
+        buffers.emplace_back(zero ? new char[size]() : new char[size]);
+        bufferPointers[index] = buffers.back().get();
+        return buffers.back().get();
+    }
+};
+
+void releaseArray(ArrowArray* array) {
+    ExportedArray* exported = static_cast<ExportedArray*>(array->private_data);
+    for (ArrowArray& child : exported->children) {
+        if (child.release) child.release(&child);
+    }
+    if (exported->dictionary.release) exported->dictionary.release(&exported->dictionary);
+    delete exported;
+    array->release = nullptr;
+}
+
+ExportedArray* initArray(ArrowArray& array, size_t length, size_t nbuffers, size_t nchildren=0) {
+
+    ExportedArray* exported = new ExportedArray;
+    exported->bufferPointers.resize(nbuffers, nullptr);
+    exported->children.resize(nchildren);
+    for (ArrowArray& child : exported->children) exported->childPointers.push_back(&child);
+
+    array.length = length;
+    array.null_count = 0;
+    array.offset = 0;
+    array.n_buffers = nbuffers;
+    array.n_children = nchildren;
+    array.buffers = &exported->bufferPointers[0];
+    array.children = nchildren ? &exported->childPointers[0] : nullptr;
+    array.dictionary = nullptr;
+    array.release = releaseArray;
+    array.private_data = exported;
+    return exported;
+}
+
+/// The key/value pairs of the schema metadata are encoded as a count, followed by the (length
+/// prefixed) keys and values, in native byte order
+
+std::string encodeMetadata(const std::map<std::string, std::string>& properties) {
+
+    std::string metadata;
+    auto append = [&metadata](int32_t n) { metadata.append(reinterpret_cast<const char*>(&n), sizeof(n)); };
+
+    append(properties.size());
+    for (const auto& kv : properties) {
+        append(kv.first.size());
+        metadata += kv.first;
+        append(kv.second.size());
+        metadata += kv.second;
+    }
+    return metadata;
+}
+
+std::map<std::string, std::string> decodeMetadata(const char* metadata) {
+
+    std::map<std::string, std::string> properties;
+    if (!metadata) return properties;
+
+    auto read = [&metadata]() {
+        int32_t n;
+        ::memcpy(&n, metadata, sizeof(n));
+        metadata += sizeof(n);
+        return n;
+    };
+
+    int32_t npairs = read();
+    for (int32_t i = 0; i < npairs; ++i) {
+        int32_t len = read();
+        std::string key(metadata, len);
+        metadata += len;
+        len = read();
+        properties[key] = std::string(metadata, len);
+        metadata += len;
+    }
+    return properties;
+}
+
+/// As for decoding, columns are matched on their full names, and then without the table name
+
+std::vector<const ColumnInfo*> exportedColumns(const std::vector<ColumnInfo>& info, const std::vector<std::string>& names) {
+
+    std::vector<const ColumnInfo*> columns;
+
+    if (names.empty()) {
+        for (const ColumnInfo& ci : info) columns.push_back(&ci);
+        return columns;
+    }
+
+    for (const std::string& name : names) {
+        auto it = std::find_if(info.begin(), info.end(), [&name](const ColumnInfo& ci) { return ci.name == name; });
+        if (it == info.end()) {
+            it = std::find_if(info.begin(), info.end(), [&name](const ColumnInfo& ci) {
+                return ci.name.substr(0, ci.name.find('@')) == name;
+            });
+        }
+        if (it == info.end()) throw UserError("Column '" + name + "' not found in frame", Here());
+        columns.push_back(&*it);
+    }
+
+    return columns;
+}
+
+size_t countNulls(const unsigned char* bitmap, size_t nrows) {
+    size_t valid = 0;
+    for (size_t byte = 0; byte < nrows / 8; ++byte) valid += std::bitset<8>(bitmap[byte]).count();
+    for (size_t row = nrows - nrows % 8; row < nrows; ++row) valid += (bitmap[row / 8] >> (row % 8)) & 1;
+    return nrows - valid;
+}
+
+/// The strings are padded with NULs in ODB-2, which do not belong in utf8
+
+void exportDictionary(ArrowSchema& schema, ArrowArray& array, const std::vector<std::string>& strings) {
+
+    ExportedSchema* exportedSchema = static_cast<ExportedSchema*>(schema.private_data);
+    initSchema(exportedSchema->dictionary, "u", "", 0);
+    schema.dictionary = &exportedSchema->dictionary;
+
+    ExportedArray* exportedArray = static_cast<ExportedArray*>(array.private_data);
+    ExportedArray* dictionary = initArray(exportedArray->dictionary, strings.size(), 3);
+    array.dictionary = &exportedArray->dictionary;
+
+    std::vector<size_t> lengths;
+    lengths.reserve(strings.size());
+    size_t total = 0;
+    for (const std::string& s : strings) {
+        size_t last = s.find_last_not_of('\0');
+        lengths.push_back(last == std::string::npos ? 0 : last + 1);
+        total += lengths.back();
+    }
+
+    if (total > size_t(std::numeric_limits<int32_t>::max())) {
+        throw UserError("Dictionary of column '" + std::string(schema.name) + "' too large to export", Here());
+    }
+
+    int32_t* offsets = reinterpret_cast<int32_t*>(dictionary->allocate(1, (strings.size() + 1) * sizeof(int32_t)));
+    char* data = dictionary->allocate(2, total);
+
+    offsets[0] = 0;
+    for (size_t i = 0; i < strings.size(); ++i) {
+        ::memcpy(&data[offsets[i]], strings[i].c_str(), lengths[i]);
+        offsets[i+1] = offsets[i] + lengths[i];
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/// Import. Columns whose values are not already in the 8-byte representation used by the encoder
+/// are converted, a column at a time.
+
+template <typename T, typename Out>
+const char* convert(const ArrowArray& array, size_t offset, size_t nrows, std::vector<std::unique_ptr<char[]>>& owned) {
+
+    const T* in = static_cast<const T*>(array.buffers[1]) + offset;
+    owned.emplace_back(new char[nrows * sizeof(Out)]);
+    Out* out = reinterpret_cast<Out*>(owned.back().get());
+    for (size_t row = 0; row < nrows; ++row) out[row] = static_cast<Out>(in[row]);
+    return owned.back().get();
+}
+
+template <typename T>
+const char* integers(const ArrowArray& array, size_t offset, size_t nrows, std::vector<std::unique_ptr<char[]>>& owned) {
+
+    if (ODBAPISettings::instance().integersAsDoubles()) return convert<T, double>(array, offset, nrows, owned);
+    if (std::is_same<T, int64_t>::value) return static_cast<const char*>(array.buffers[1]) + offset * sizeof(T);
+    return convert<T, int64_t>(array, offset, nrows, owned);
+}
+
+/// The strings of a utf8 (int32 offsets) or large utf8 (int64 offsets) array
+
+template <typename OffsetType>
+struct Utf8Strings {
+    Utf8Strings(const ArrowArray& array, size_t offset) :
+        offsets(static_cast<const OffsetType*>(array.buffers[1]) + offset),
+        data(static_cast<const char*>(array.buffers[2])) {}
+
+    const char* str(size_t i) const { return data + offsets[i]; }
+    size_t length(size_t i) const { return offsets[i+1] - offsets[i]; }
+
+    const OffsetType* offsets;
+    const char* data;
+};
+
+/// Rows of strings are packed into fixed width (multiple of 8 byte) elements, padded with NULs.
+/// Null rows are left empty.
+
+template <typename Strings, typename Index>
+const char* packStrings(const Strings& strings, const Index& index, size_t nrows, const ConstValidityBitmap& validity,
+                        size_t& width, std::vector<std::unique_ptr<char[]>>& owned) {
+
+    size_t maxLength = 1;
+    for (size_t row = 0; row < nrows; ++row) {
+        if (!validity || validity.valid(row)) maxLength = std::max(maxLength, strings.length(index(row)));
+    }
+    width = ((maxLength + 7) / 8) * 8;
+
+    owned.emplace_back(new char[nrows * width]());
+    char* out = owned.back().get();
+    for (size_t row = 0; row < nrows; ++row) {
+        if (!validity || validity.valid(row)) {
+            size_t i = index(row);
+            ::memcpy(&out[row * width], strings.str(i), strings.length(i));
+        }
+    }
+    return out;
+}
+
+template <typename OffsetType>
+const char* utf8(const ArrowArray& array, size_t offset, size_t nrows, const ConstValidityBitmap& validity,
+                 size_t& width, std::vector<std::unique_ptr<char[]>>& owned) {
+
+    Utf8Strings<OffsetType> strings(array, offset);
+    return packStrings(strings, [](size_t row) { return row; }, nrows, validity, width, owned);
+}
+
+template <typename IndexType>
+const char* dictionaryStrings(const ArrowSchema& schema, const ArrowArray& array, size_t offset, size_t nrows,
+                              const ConstValidityBitmap& validity, size_t& width,
+                              std::vector<std::unique_ptr<char[]>>& owned) {
+
+    const IndexType* indices = static_cast<const IndexType*>(array.buffers[1]) + offset;
+    auto index = [indices](size_t row) { return size_t(indices[row]); };
+
+    ASSERT(array.dictionary);
+    const ArrowArray& dictionary(*array.dictionary);
+    const std::string format(schema.dictionary->format);
+    if (format == "u") return packStrings(Utf8Strings<int32_t>(dictionary, dictionary.offset), index, nrows, validity, width, owned);
+    if (format == "U") return packStrings(Utf8Strings<int64_t>(dictionary, dictionary.offset), index, nrows, validity, width, owned);
+
+    throw UserError("Arrow dictionaries of format '" + format + "' cannot be encoded, in column '" +
+                    schema.name + "'", Here());
+}
+
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Frame::exportArrow(ArrowSchema* schema, ArrowArray* array, const std::vector<std::string>& columns, size_t nthreads) const {
+
+    ASSERT(schema);
+    ASSERT(array);
+
+    std::vector<const ColumnInfo*> selected(exportedColumns(columnInfo(), columns));
+    size_t ncols = selected.size();
+    size_t nrows = rowCount();
+
+    // Build the arrays locally, so that everything allocated is released if decoding fails
+
+    ArrowSchema structSchema;
+    ArrowArray structArray;
+    ExportedSchema* exportedSchema = initSchema(structSchema, "+s", "", 0, ncols);
+    ExportedArray* exportedArray = initArray(structArray, nrows, 1, ncols);
+
+    try {
+
+        const std::map<std::string, std::string>& props(properties());
+        if (!props.empty()) {
+            exportedSchema->metadata = encodeMetadata(props);
+            structSchema.metadata = exportedSchema->metadata.data();
+        }
+
+        std::vector<std::string> names;
+        std::vector<StridedData> facades;
+        std::vector<DecodedType> types;
+        std::vector<unsigned char*> validity(ncols, nullptr);
+
+        for (size_t i = 0; i < ncols; ++i) {
+
+            const ColumnInfo& ci(*selected[i]);
+            ExportedArray* child = initArray(exportedArray->children[i], nrows, 2);
+
+            const char* format;
+            DecodedType type;
+            switch (ci.type) {
+                case INTEGER:
+                case BITFIELD: format = "l"; type = DECODE_INT64; break;
+                case REAL:     format = "f"; type = DECODE_FLOAT32; break;
+                case DOUBLE:   format = "g"; type = DECODE_FLOAT64; break;
+                case STRING:   format = "i"; type = DECODE_INT32; break;
+                default: {
+                    std::stringstream ss;
+                    ss << "Column '" << ci.name << "' of type " << columnTypeName(ci.type) << " cannot be exported to Arrow";
+                    throw UserError(ss.str(), Here());
+                }
+            }
+
+            // Strings are never missing. The validity of the other columns is recorded in bitmaps.
+
+            bool nullable = (ci.type != STRING);
+            initSchema(exportedSchema->children[i], format, ci.name, nullable ? ARROW_FLAG_NULLABLE : 0);
+
+            size_t size = decodedTypeSize(type);
+            names.push_back(ci.name);
+            types.push_back(type);
+            facades.emplace_back(child->allocate(1, nrows * size), nrows, size, size);
+            if (nullable) validity[i] = reinterpret_cast<unsigned char*>(child->allocate(0, (nrows + 7) / 8, true));
+        }
+
+        Decoder decoder(names, facades);
+        for (size_t i = 0; i < ncols; ++i) {
+            decoder.setType(i, types[i]);
+            if (selected[i]->type == STRING) decoder.decodeCodes(i);
+            if (validity[i]) decoder.setValidity(i, ValidityBitmap(validity[i]));
+        }
+
+        if (nrows > 0) decoder.decode(*this, nthreads);
+
+        for (size_t i = 0; i < ncols; ++i) {
+            if (validity[i]) exportedArray->children[i].null_count = countNulls(validity[i], nrows);
+            if (selected[i]->type == STRING) {
+                exportDictionary(exportedSchema->children[i], exportedArray->children[i], decoder.dictionary(i));
+            }
+        }
+
+    } catch (...) {
+        structSchema.release(&structSchema);
+        structArray.release(&structArray);
+        throw;
+    }
+
+    *schema = structSchema;
+    *array = structArray;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void encodeArrow(DataHandle& out,
+                 const ArrowSchema& schema,
+                 const ArrowArray& array,
+                 const std::map<std::string, std::string>& properties,
+                 size_t maxRowsPerFrame) {
+
+    if (!schema.release || !array.release) throw UserError("Arrow schema or array has been released", Here());
+
+    if (std::string(schema.format) != "+s") {
+        throw UserError("Only Arrow struct arrays can be encoded, not format '" + std::string(schema.format) + "'", Here());
+    }
+
+    if (schema.n_children != array.n_children || schema.n_children == 0) {
+        throw UserError("Arrow struct array must have a child array for each column of the schema", Here());
+    }
+
+    if (array.null_count != 0 && array.n_buffers > 0 && array.buffers[0]) {
+        throw UserError("Arrow struct arrays with null rows cannot be encoded", Here());
+    }
+
+    size_t ncols = schema.n_children;
+    size_t nrows = array.length;
+
+    std::map<std::string, std::string> props(decodeMetadata(schema.metadata));
+    for (const auto& kv : properties) props[kv.first] = kv.second;
+
+    std::vector<ColumnInfo> columns;
+    std::vector<ConstStridedData> data;
+    std::vector<ConstValidityBitmap> validity(ncols);
+    std::vector<std::unique_ptr<char[]>> owned;
+
+    for (size_t i = 0; i < ncols; ++i) {
+
+        const ArrowSchema& cs(*schema.children[i]);
+        const ArrowArray& ca(*array.children[i]);
+
+        const std::string name(cs.name ? cs.name : "");
+        const std::string format(cs.format);
+        if (name.empty()) throw UserError("Arrow columns must be named to be encoded", Here());
+        ASSERT(size_t(ca.length) >= array.offset + nrows);
+
+        // The offset of the struct array applies to its children
+
+        size_t offset = array.offset + ca.offset;
+        if (ca.null_count != 0 && ca.n_buffers > 0 && ca.buffers[0]) {
+            validity[i] = ConstValidityBitmap(ca.buffers[0], offset);
+        }
+
+        ColumnType type;
+        size_t width = sizeof(double);
+        const char* values;
+
+        if (cs.dictionary) {
+            type = STRING;
+            if (format == "c")      values = dictionaryStrings<int8_t>(cs, ca, offset, nrows, validity[i], width, owned);
+            else if (format == "C") values = dictionaryStrings<uint8_t>(cs, ca, offset, nrows, validity[i], width, owned);
+            else if (format == "s") values = dictionaryStrings<int16_t>(cs, ca, offset, nrows, validity[i], width, owned);
+            else if (format == "S") values = dictionaryStrings<uint16_t>(cs, ca, offset, nrows, validity[i], width, owned);
+            else if (format == "i") values = dictionaryStrings<int32_t>(cs, ca, offset, nrows, validity[i], width, owned);
+            else if (format == "I") values = dictionaryStrings<uint32_t>(cs, ca, offset, nrows, validity[i], width, owned);
+            else if (format == "l") values = dictionaryStrings<int64_t>(cs, ca, offset, nrows, validity[i], width, owned);
+            else if (format == "L") values = dictionaryStrings<uint64_t>(cs, ca, offset, nrows, validity[i], width, owned);
+            else throw UserError("Arrow dictionary indices of format '" + format + "' cannot be encoded, in column '" + name + "'", Here());
+        } else if (format == "c") { type = INTEGER; values = integers<int8_t>(ca, offset, nrows, owned);
+        } else if (format == "C") { type = INTEGER; values = integers<uint8_t>(ca, offset, nrows, owned);
+        } else if (format == "s") { type = INTEGER; values = integers<int16_t>(ca, offset, nrows, owned);
+        } else if (format == "S") { type = INTEGER; values = integers<uint16_t>(ca, offset, nrows, owned);
+        } else if (format == "i") { type = INTEGER; values = integers<int32_t>(ca, offset, nrows, owned);
+        } else if (format == "I") { type = INTEGER; values = integers<uint32_t>(ca, offset, nrows, owned);
+        } else if (format == "l") { type = INTEGER; values = integers<int64_t>(ca, offset, nrows, owned);
+        } else if (format == "L") { type = INTEGER; values = integers<uint64_t>(ca, offset, nrows, owned);
+        } else if (format == "f") { type = REAL; values = convert<float, double>(ca, offset, nrows, owned);
+        } else if (format == "g") { type = DOUBLE; values = static_cast<const char*>(ca.buffers[1]) + offset * sizeof(double);
+        } else if (format == "u") { type = STRING; values = utf8<int32_t>(ca, offset, nrows, validity[i], width, owned);
+        } else if (format == "U") { type = STRING; values = utf8<int64_t>(ca, offset, nrows, validity[i], width, owned);
+        } else {
+            throw UserError("Arrow arrays of format '" + format + "' cannot be encoded, in column '" + name + "'", Here());
+        }
+
+        columns.emplace_back(ColumnInfo {name, type, width});
+        data.emplace_back(values, nrows, width, width);
+    }
+
+    encode(out, columns, data, props, maxRowsPerFrame, validity);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace api
+} // namespace odc
@@ -48,6 +48,27 @@ struct ColumnInfo {
     std::vector<Bit> bitfield;
 };
 
+/** Describes the range of the values in a column, as recorded in the frame headers. These statistics
+ *  are available without decoding the data. */
+struct ColumnStatistics {
+
+    /** Column name */
+    std::string name;
+    /** Column data type */
+    ColumnType type;
+    /** Smallest non-missing value, as decoded. The missing value if there are no non-missing values */
+    double min;
+    /** Largest non-missing value, as decoded. The missing value if there are no non-missing values */
+    double max;
+    /** Whether any of the values are missing */
+    bool hasMissing;
+    /** The (numerical) missing value of the column */
+    double missingValue;
+    /** Whether all the values are equal to min. For a string column, min and max then hold the (up to
+     *  8 byte) string. They are otherwise zero for string columns */
+    bool isConstant;
+};
+
 //----------------------------------------------------------------------------------------------------------------------
 
 } // namespace api
@@ -43,6 +43,37 @@ enum ColumnType {
 
 constexpr int NUM_TYPES = 6;
 
+/** Identifies the representation in which the Decoder writes the values of a column */
+enum DecodedType {
+    /** 8-byte values. Integers are written as doubles or as 64-bit integers, according to the settings */
+    DECODE_DEFAULT = 0,
+    /** 8-bit signed integers */
+    DECODE_INT8    = 1,
+    /** 16-bit signed integers */
+    DECODE_INT16   = 2,
+    /** 32-bit signed integers */
+    DECODE_INT32   = 3,
+    /** 64-bit signed integers */
+    DECODE_INT64   = 4,
+    /** 32-bit floating point values */
+    DECODE_FLOAT32 = 5,
+    /** 64-bit floating point values */
+    DECODE_FLOAT64 = 6
+};
+
+constexpr int NUM_DECODED_TYPES = 7;
+
+/** Returns the size in bytes of a value decoded with the given representation */
+inline size_t decodedTypeSize(DecodedType type) {
+    switch (type) {
+        case DECODE_INT8:    return sizeof(int8_t);
+        case DECODE_INT16:   return sizeof(int16_t);
+        case DECODE_INT32:   return sizeof(int32_t);
+        case DECODE_FLOAT32: return sizeof(float);
+        default:             return sizeof(double);
+    }
+}
+
 template <ColumnType ty> struct OdbTypes{};
 
 // Specialisations
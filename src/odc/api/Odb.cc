@@ -11,20 +11,26 @@
 #include "odc/api/Odb.h"
 
 #include <algorithm>
+#include <cstring>
 #include <numeric>
 #include <mutex>
 #include <future>
+#include <set>
 
 #include "eckit/filesystem/PathName.h"
+#include "eckit/io/FileHandle.h"
 #include "eckit/io/HandleBuf.h"
 #include "eckit/io/MemoryHandle.h"
 #include "eckit/io/BufferList.h"
 #include "eckit/log/Log.h"
 #include "eckit/utils/StringTools.h"
 
+#include "odc/codec/CodecOptimizer.h"
 #include "odc/core/Column.h"
 #include "odc/core/DecodeTarget.h"
 #include "odc/core/Encoder.h"
+#include "odc/core/FileRangeCopier.h"
+#include "odc/core/FrameIndex.h"
 #include "odc/core/Table.h"
 #include "odc/core/TablesReader.h"
 #include "odc/csv/TextReader.h"
@@ -34,6 +40,7 @@
 #include "odc/ODBAPISettings.h"
 #include "odc/Writer.h"
 #include "odc/Select.h"
+#include "odc/sql/TablePredicate.h"
 
 using namespace eckit;
 
@@ -47,16 +54,88 @@ namespace api {
 
 struct DecoderImpl;
 
+/// The rows selected from the tables of a frame by an SQL filter, held as decoded columns. The
+/// values are those that would be decoded had the rows been encoded into a new frame, including
+/// the loss of precision where odc::Writer would choose one of the short_real codecs.
+
+class FilteredColumns {
+
+public: // methods
+
+    FilteredColumns();
+
+    /// Returns false if the result cannot be held as a single set of columns, stopping at the first
+    /// table (or block of rows from the SQL engine) that does not fit. An empty result has no rows.
+    bool filter(const std::string& sql, std::vector<core::Table>& tables);
+
+    const core::MetaData& columns() const { return columns_; }
+    size_t rowCount() const { return rowCount_; }
+
+    /// Copies the rows into the target. Returns false if the target requires anything other than
+    /// the default representation of the values.
+    bool decode(core::DecodeTarget& target, size_t firstRow, size_t nrows, size_t stride) const;
+
+    /// Encode the rows as encodedFilter would, from the same (filtered) tables: those accepted
+    /// wholesale are copied verbatim, and the other rows are encoded by odc::Writer.
+    void encode(std::vector<core::Table>& tables, eckit::DataHandle& out) const;
+
+    /// The properties of the encoded frame, which are those of the tables copied verbatim
+    void properties(std::vector<core::Table>& tables, std::map<std::string, std::string>& properties) const;
+
+private: // types
+
+    /// A contribution to the result. Either a table copied wholesale (by its index in the filtered
+    /// tables), or rows that are encoded by odc::Writer (table < 0).
+    struct Segment {
+        long table;
+        size_t firstRow;
+        size_t rowCount;
+    };
+
+    class RowIterator;
+
+private: // methods
+
+    /// Can tables with these columns contribute to the result?
+    bool fits(const core::MetaData& columns) const;
+    bool initColumns(const core::MetaData& columns);
+
+    bool append(core::Table& table, long index);
+    bool append(core::Table& table, const std::vector<char>& selected);
+    bool append(odc::Select::iterator& it, const odc::Select::iterator& end);
+
+    /// Add a row, with the values of each column, as odc::Writer would buffer it
+    void appendRow(core::MetaData& stats, size_t& firstRow, const std::vector<const double*>& values);
+
+    /// Replace the values of the rows from firstRow with those that would be decoded once encoded
+    /// with the codecs that odc::Writer chooses from the statistics
+    void encodedValues(core::MetaData& stats, size_t firstRow);
+
+private: // members
+
+    core::MetaData columns_;
+    std::vector<size_t> widths_;   // in doubles
+    std::vector<size_t> offsets_;  // in doubles, within a row supplied by the SQL engine
+    std::vector<std::vector<double>> data_;
+    std::vector<Segment> segments_;
+    size_t rowCount_;
+    size_t rowsBufferSize_;
+};
+
+
 class FrameImpl {
 
 public: // methods
 
     FrameImpl(std::vector<core::Table>&& tables);
+    FrameImpl(const std::string& sql, const std::vector<core::Table>& source,
+              std::shared_ptr<const FilteredColumns> filtered);
 
     // Moves this frame onwards
     bool next(bool aggregated, long rowlimit);
 
     const std::vector<ColumnInfo>& columnInfo() const;
+    const std::vector<ColumnStatistics>& columnStatistics() const;
     bool hasColumn(const std::string& column) const;
 
     size_t rowCount() const;
@@ -66,19 +145,37 @@ public: // methods
     eckit::Length length() const;
 
     void decode(DecoderImpl& target, size_t nthreads);
-    Span span(const std::vector<std::string>& columns, bool onlyConstantValues);
+    void decode(DecoderImpl& target, size_t firstRow, size_t nrows, size_t stride);
+    Span span(const std::vector<std::string>& columns, bool onlyConstantValues, size_t nthreads);
 
     Frame filter(const std::string& sql);
     Buffer encodedData();
 
     const std::map<std::string, std::string>& properties() const;
 
+private: // methods
+
+    const core::MetaData& columns() const;
+
+    /// A filtered frame is held as decoded columns until something requires the encoded tables.
+    /// They are then produced, once, by encoding those columns (see FilteredColumns::encode).
+    /// Anything that uses tables_ must call this first. It may be called from several threads.
+    void materialise() const;
+
 private: // members
 
     mutable std::vector<ColumnInfo> columnInfo_;
-    std::vector<core::Table> tables_;
+    mutable std::vector<ColumnStatistics> columnStatistics_;
+    mutable std::vector<core::Table> tables_;
     mutable bool propertiesRetrieved_;
     mutable std::map<std::string, std::string> properties_;
+
+    // n.b. The filtered columns are kept once the tables are materialised, and continue to
+    //      describe (and decode) the frame. Only tables_ and filterSource_ are changed.
+    std::string filterSQL_;
+    mutable std::vector<core::Table> filterSource_;
+    std::shared_ptr<const FilteredColumns> filtered_;
+    std::shared_ptr<std::mutex> materialiseMutex_;
 };
 
 
@@ -171,6 +268,8 @@ Frame ReaderImpl::next() {
 
 Buffer FrameImpl::encodedData() {
 
+    materialise();
+
     eckit::BufferList buffers;
     const bool includeHeader = true;
 
@@ -183,18 +282,28 @@ Buffer FrameImpl::encodedData() {
 
 const std::map<std::string, std::string>& FrameImpl::properties() const {
 
-    ASSERT(!tables_.empty());
-
     // Properties are memoised, so only filled in once
-    if (!propertiesRetrieved_) {
+    if (propertiesRetrieved_) return properties_;
+
+    // Those of a filtered frame are known without encoding it
 
-        for (auto& t : tables_) {
-            properties_.insert(t.properties().begin(), t.properties().end());
+    if (filtered_) {
+        std::lock_guard<std::mutex> lock(*materialiseMutex_);
+        if (tables_.empty()) {
+            filtered_->properties(filterSource_, properties_);
+            propertiesRetrieved_ = true;
+            return properties_;
         }
+    }
 
-        propertiesRetrieved_ = true;
+    materialise();
+    ASSERT(!tables_.empty());
+
+    for (auto& t : tables_) {
+        properties_.insert(t.properties().begin(), t.properties().end());
     }
 
+    propertiesRetrieved_ = true;
     return properties_;
 }
 
@@ -230,6 +339,9 @@ Decoder::Decoder(const std::vector<std::string>& columns,
                            std::vector<StridedData>& columnFacades) :
     impl_(new DecoderImpl(columns, columnFacades)) {}
 
+Decoder::Decoder(Decoder&& rhs) :
+    impl_(std::move(rhs.impl_)) {}
+
 Decoder::~Decoder() {}
 
 void Decoder::decode(const Frame& frame, size_t nthreads) {
@@ -238,10 +350,44 @@ void Decoder::decode(const Frame& frame, size_t nthreads) {
     frame.impl_->decode(*impl_, nthreads);
 }
 
+void Decoder::decode(const Frame& frame, size_t firstRow, size_t nrows, size_t stride) {
+    ASSERT(impl_);
+    ASSERT(frame.impl_);
+    frame.impl_->decode(*impl_, firstRow, nrows, stride);
+}
+
+void Decoder::setType(size_t column, DecodedType type) {
+    ASSERT(impl_);
+    impl_->type(column, type);
+}
+
+void Decoder::decodeCodes(size_t column) {
+    ASSERT(impl_);
+    impl_->decodeCodes(column);
+}
+
+void Decoder::setValidity(size_t column, const ValidityBitmap& bitmap) {
+    ASSERT(impl_);
+    impl_->validity(column, bitmap);
+}
+
+const std::vector<std::string>& Decoder::dictionary(size_t column) const {
+    ASSERT(impl_);
+    core::DecodeTarget::Dictionary* dictionary = impl_->dictionary(column);
+    if (!dictionary) {
+        std::stringstream ss;
+        ss << "Column " << column << " is not decoded as dictionary codes";
+        throw UserError(ss.str(), Here());
+    }
+    return dictionary->strings();
+}
+
 Decoder Decoder::slice(size_t rowOffset, size_t nrows) const {
     ASSERT(impl_);
     core::DecodeTarget&& sliced = impl_->slice(rowOffset, nrows);
-    return {sliced.columns(), sliced.dataFacades()};
+    Decoder decoder(sliced.columns(), sliced.dataFacades());
+    static_cast<core::DecodeTarget&>(*decoder.impl_) = sliced;
+    return decoder;
 }
 
 
@@ -308,9 +454,23 @@ FrameImpl::FrameImpl(std::vector<core::Table>&& tables) :
     tables_(std::move(tables)),
     propertiesRetrieved_(false) {}
 
-const std::vector<ColumnInfo>& FrameImpl::columnInfo() const {
+FrameImpl::FrameImpl(const std::string& sql, const std::vector<core::Table>& source,
+                     std::shared_ptr<const FilteredColumns> filtered) :
+    propertiesRetrieved_(false),
+    filterSQL_(sql),
+    filterSource_(source),
+    filtered_(filtered),
+    materialiseMutex_(std::make_shared<std::mutex>()) {
+    ASSERT(filtered_->rowCount() > 0);
+}
 
+const core::MetaData& FrameImpl::columns() const {
+    if (filtered_) return filtered_->columns();
     ASSERT(!tables_.empty());
+    return tables_.front().columns();
+}
+
+const std::vector<ColumnInfo>& FrameImpl::columnInfo() const {
 
     // ColumnInfo is memoised, so only constructed once
 
@@ -318,7 +478,7 @@ const std::vector<ColumnInfo>& FrameImpl::columnInfo() const {
 
         columnInfo_.reserve(columnCount());
 
-        for (const core::Column* col : tables_.begin()->columns()) {
+        for (const core::Column* col : columns()) {
 
             // Extract any bitfield details
 
@@ -352,23 +512,114 @@ const std::vector<ColumnInfo>& FrameImpl::columnInfo() const {
     return columnInfo_;
 }
 
-bool FrameImpl::hasColumn(const std::string& column) const {
+namespace {
+
+/// The columns of the tables of an aggregated frame are not necessarily in the same order
+
+const core::Column& tableColumn(const core::Table& table, size_t index, const std::string& name) {
+
+    const core::MetaData& md(table.columns());
+    if (index < md.size() && md[index]->name() == name) return *md[index];
+
+    for (const core::Column* col : md) {
+        if (col->name() == name) return *col;
+    }
+
+    throw SeriousBug("Column '" + name + "' not found in aggregated frame", Here());
+}
+
+}
+
+const std::vector<ColumnStatistics>& FrameImpl::columnStatistics() const {
+
+    materialise();
     ASSERT(!tables_.empty());
-    return tables_.front().columns().hasColumn(column);
+
+    // ColumnStatistics are memoised, so only constructed once. They are combined from the statistics
+    // in the headers of the (non-empty) tables.
+
+    if (columnStatistics_.empty()) {
+
+        const core::MetaData& columns(tables_.front().columns());
+
+        for (size_t c = 0; c < columns.size(); ++c) {
+
+            const core::Column* col = columns[c];
+            double missing = col->coder().rawMissingValue();
+            ColumnStatistics stats {col->name(), col->type(), missing, missing, false, missing, true};
+            bool hasValues = false;
+
+            for (const core::Table& table : tables_) {
+
+                if (table.rowCount() == 0) continue;
+
+                const core::Column& column(tableColumn(table, c, col->name()));
+                const std::string& codec(column.coder().name());
+                double min = column.min();
+                double max = column.max();
+
+                if (column.hasMissing()) {
+                    stats.hasMissing = true;
+                    stats.isConstant = false;
+
+                    // n.b. Missing values are excluded from the ranges gathered by the codecs
+                    if (min == column.coder().rawMissingValue() && max == min) continue;
+                }
+
+                // The short_real codecs round the values to single precision. This preserves their order.
+
+                if (codec == "short_real" || codec == "short_real2") {
+                    min = static_cast<float>(min);
+                    max = static_cast<float>(max);
+                }
+
+                bool constant = (codec == "constant" || codec == "constant_string");
+
+                if (!hasValues) {
+                    stats.min = min;
+                    stats.max = max;
+                    hasValues = true;
+                    if (!constant) stats.isConstant = false;
+                } else if (col->type() == STRING) {
+                    if (!constant || ::memcmp(&min, &stats.min, sizeof(min)) != 0) stats.isConstant = false;
+                } else {
+                    if (!constant || min != stats.min) stats.isConstant = false;
+                    stats.min = std::min(stats.min, min);
+                    stats.max = std::max(stats.max, max);
+                }
+            }
+
+            if (!hasValues) stats.isConstant = false;
+            if (col->type() == STRING && !stats.isConstant) stats.min = stats.max = 0;
+
+            columnStatistics_.emplace_back(std::move(stats));
+        }
+    }
+
+    return columnStatistics_;
+}
+
+bool FrameImpl::hasColumn(const std::string& column) const {
+    return columns().hasColumn(column);
 }
 
 size_t FrameImpl::rowCount() const {
+    if (filtered_) return filtered_->rowCount();
     return std::accumulate(tables_.begin(), tables_.end(), size_t(0),
                            [](size_t n, const core::Table& t) { return n + t.rowCount(); });
 }
 
 size_t FrameImpl::columnCount() const {
+    if (filtered_) return filtered_->columns().size();
     ASSERT_MSG(!tables_.empty(), "No tables. Have you remembered to call odc_next_frame() on frame?");
     return tables_[0].columnCount();
 }
 
 void FrameImpl::decode(DecoderImpl& target, size_t nthreads) {
 
+    if (filtered_ && filtered_->decode(target, 0, filtered_->rowCount(), 1)) return;
+    materialise();
+
     if (tables_.size() == 1) {
         tables_[0].decode(target);
     } else {
@@ -388,6 +639,12 @@ void FrameImpl::decode(DecoderImpl& target, size_t nthreads) {
         }
 
         if (nthreads > 1) {
+
+            // Assign any dictionary codes in table order, irrespective of the decoding order
+            for (size_t i = 0; i < tables_.size(); ++i) {
+                tables_[i].mergeDictionaries(targets[i]);
+            }
+
             std::mutex guard_mutex;
             std::vector<std::future<void>> threads;
             size_t next_frame = 0;
@@ -420,6 +677,44 @@ void FrameImpl::decode(DecoderImpl& target, size_t nthreads) {
     }
 }
 
+void FrameImpl::decode(DecoderImpl& target, size_t firstRow, size_t nrows, size_t stride) {
+
+    ASSERT(stride > 0);
+    if (nrows == 0) return;
+    if (firstRow + (nrows - 1) * stride >= rowCount()) {
+        std::stringstream ss;
+        ss << "Cannot decode " << nrows << " rows from row " << firstRow << " with stride " << stride
+           << ". Frame contains only " << rowCount() << " rows";
+        throw UserError(ss.str(), Here());
+    }
+
+    if (filtered_ && filtered_->decode(target, firstRow, nrows, stride)) return;
+    materialise();
+
+    // Map the rows required onto the underlying tables
+
+    size_t tableStart = 0;
+    size_t decoded = 0;
+
+    for (core::Table& t : tables_) {
+
+        size_t tableEnd = tableStart + t.rowCount();
+        size_t row = firstRow + decoded * stride;
+
+        if (row < tableEnd) {
+            size_t count = std::min(nrows - decoded, ((tableEnd - 1 - row) / stride) + 1);
+            core::DecodeTarget&& subTarget(target.slice(decoded, count));
+            t.decode(subTarget, row - tableStart, count, stride);
+            decoded += count;
+            if (decoded == nrows) break;
+        }
+
+        tableStart = tableEnd;
+    }
+
+    ASSERT(decoded == nrows);
+}
+
 namespace {
 class SerialTableReadHandle : public DataHandle {
 public:
@@ -477,47 +772,644 @@ private:
 };
 }
 
-Frame FrameImpl::filter(const std::string& sql) {
+namespace {
 
-    /// @note The SQL functionality works somewhat differently to the rest of the API.
-    ///       It parses data in a streaming manner from a data handle.
+/// Where the query is a simple conjunction of numeric comparisons (see TablePredicate), the column
+/// ranges in the table headers may show that a table is entirely accepted (and can be copied over
+/// verbatim) or entirely rejected (and can be skipped). Only the remaining tables are decoded and
+/// passed through the SQL engine.
+
+template <typename TABLES>
+size_t filterTables(const std::string& sql, const odc::sql::TablePredicate& predicate, TABLES& tables, DataHandle& out) {
+
+    out.openForWrite(0);
+    AutoClose closer(out);
+
+    const bool includeHeader = true;
+    size_t rowCount = 0;
+
+    for (core::Table& table : tables) {
+
+        switch (predicate.evaluate(table)) {
+
+        case odc::sql::TablePredicate::NONE:
+            break;
+
+        case odc::sql::TablePredicate::ALL: {
+            const Buffer encoded(table.readEncodedData(includeHeader));
+            ASSERT(out.write(encoded, encoded.size()) == static_cast<long>(encoded.size()));
+            rowCount += table.rowCount();
+            break;
+        }
+
+        case odc::sql::TablePredicate::SOME: {
+            const Buffer encoded(table.readEncodedData(includeHeader));
+            MemoryHandle in(encoded);
+            MemoryHandle filtered;
+
+            odc::Select odb(sql, in);
+            odc::Select::iterator it = odb.begin();
+            odc::Select::iterator end = odb.end();
+
+            odc::Writer<> writer(filtered);
+            odc::Writer<>::iterator outit = writer.begin();
+            rowCount += outit->pass1(it, end);
+
+            long length = filtered.position();
+            if (length > 0) {
+                ASSERT(out.write(filtered.data(), length) == length);
+            }
+            break;
+        }
+        }
+    }
+
+    return rowCount;
+}
+
+/// Combine frames holding the same columns, but laid out differently (e.g. with different string
+/// widths), into one frame encoded with the widest layout.
+
+Frame combineFrames(std::vector<Frame>& frames) {
+
+    ASSERT(!frames.empty());
+
+    std::vector<ColumnInfo> columns(frames.front().columnInfo());
+    size_t nrows = 0;
+
+    for (const Frame& frame : frames) {
+        const std::vector<ColumnInfo>& info(frame.columnInfo());
+        ASSERT(info.size() == columns.size());
+        for (size_t i = 0; i < columns.size(); ++i) {
+            ASSERT(info[i].name == columns[i].name && info[i].type == columns[i].type);
+            columns[i].decodedSize = std::max(columns[i].decodedSize, info[i].decodedSize);
+        }
+        nrows += frame.rowCount();
+    }
+
+    if (nrows == 0) return std::move(frames.front());
+
+    // n.b. Narrower strings are decoded into zeroed (padded) elements of the widest size
+
+    std::vector<std::string> names;
+    std::vector<std::vector<char>> buffers;
+    for (const ColumnInfo& column : columns) {
+        names.push_back(column.name);
+        buffers.emplace_back(nrows * column.decodedSize, 0);
+    }
+
+    size_t row = 0;
+    for (Frame& frame : frames) {
+        if (frame.rowCount() == 0) continue;
+        std::vector<StridedData> strides;
+        for (size_t i = 0; i < columns.size(); ++i) {
+            size_t size = columns[i].decodedSize;
+            strides.emplace_back(&buffers[i][row * size], frame.rowCount(), size, size);
+        }
+        Decoder decoder(names, strides);
+        decoder.decode(frame);
+        row += frame.rowCount();
+    }
+
+    std::vector<ConstStridedData> data;
+    for (size_t i = 0; i < columns.size(); ++i) {
+        size_t size = columns[i].decodedSize;
+        data.emplace_back(&buffers[i][0], nrows, size, size);
+    }
 
-    // Input data handle
+    std::unique_ptr<MemoryHandle> combined(new MemoryHandle);
+    {
+        combined->openForWrite(0);
+        AutoClose closer(*combined);
+        encode(*combined, columns, data, frames.front().properties(), nrows);
+    }
 
-    SerialTableReadHandle input_dh(tables_);
+    Reader reader(combined.release());
+    Frame frame = reader.next();
+    ASSERT(frame);
+    ASSERT(!reader.next());
+    return frame;
+}
+
+/// Filter the tables through the SQL engine, encoding the selected rows into a new frame. Whole
+/// tables copied by filterTables keep their layout, and the SQL engine starts a new frame when the
+/// string widths change, so the output frames are combined if they are not compatible.
+
+Frame encodedFilter(const std::string& sql, std::vector<core::Table>& tables) {
+
+    /// @note The SQL functionality works somewhat differently to the rest of the API.
+    ///       It parses data in a streaming manner from a data handle.
 
     // Output data handle
 
     std::unique_ptr<MemoryHandle> output_dh(new MemoryHandle);
 
-    ::odc::api::filter(sql, input_dh, *output_dh);
+    std::unique_ptr<odc::sql::TablePredicate> predicate(odc::sql::TablePredicate::parse(sql));
+    if (predicate) {
+        filterTables(sql, *predicate, tables, *output_dh);
+    } else {
+        SerialTableReadHandle input_dh(tables);
+        ::odc::api::filter(sql, input_dh, *output_dh);
+    }
 
     // Open this output data handle as a 'new' odb, and extract the Frame
-    // There should only be one frame, as it should have a consistent structure from
-    // the SQL select
 
     Reader reader(output_dh.release());
     Frame filtered_frame = reader.next();
+    Frame next = reader.next();
+    if (!next) return filtered_frame;
+
+    std::vector<Frame> frames;
+    frames.emplace_back(std::move(filtered_frame));
+    while (next) {
+        frames.emplace_back(std::move(next));
+        next = reader.next();
+    }
+    return combineFrames(frames);
+}
+
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+FilteredColumns::FilteredColumns() :
+    rowCount_(0),
+    rowsBufferSize_(odc::Writer<>().rowsBufferSize()) {}
+
+bool FilteredColumns::filter(const std::string& sql, std::vector<core::Table>& tables) {
+
+    if (sql.empty()) return false;
+
+    // Follow the same route through the tables as encodedFilter
+
+    std::unique_ptr<odc::sql::TablePredicate> predicate(odc::sql::TablePredicate::parse(sql));
+    if (predicate) {
+
+        for (size_t i = 0; i < tables.size(); ++i) {
+
+            core::Table& table(tables[i]);
+
+            switch (predicate->evaluate(table)) {
+
+            case odc::sql::TablePredicate::NONE:
+                break;
+
+            case odc::sql::TablePredicate::ALL:
+                if (!append(table, long(i))) return false;
+                break;
+
+            case odc::sql::TablePredicate::SOME: {
+
+                // Where the conditions can be evaluated on the decoded columns (e.g. on the codes of
+                // dictionary encoded strings), the SQL engine is not needed
+
+                if (!fits(table.columns())) return false;
+
+                std::vector<char> selected;
+                if (predicate->selectRows(table, selected)) {
+                    if (!append(table, selected)) return false;
+                    break;
+                }
+
+                const bool includeHeader = true;
+                const Buffer encoded(table.readEncodedData(includeHeader));
+                MemoryHandle in(encoded);
+
+                odc::Select odb(sql, in);
+                odc::Select::iterator it = odb.begin();
+                odc::Select::iterator end = odb.end();
+                if (!append(it, end)) return false;
+                break;
+            }
+            }
+        }
+
+    } else {
+
+        SerialTableReadHandle in(tables);
+
+        odc::Select odb(sql, in);
+        odc::Select::iterator it = odb.begin();
+        odc::Select::iterator end = odb.end();
+        if (!append(it, end)) return false;
+    }
+
+    return true;
+}
+
+bool FilteredColumns::fits(const core::MetaData& columns) const {
+
+    if (!data_.empty()) return columns_.equals(columns);
+
+    // Only unambiguous columns can be looked up as core::Table would
+
+    std::set<std::string> names;
+    for (const core::Column* col : columns) {
+        if (!names.insert(col->name()).second) return false;
+    }
+
+    return true;
+}
+
+bool FilteredColumns::initColumns(const core::MetaData& columns) {
+
+    if (!fits(columns)) return false;
+    if (!data_.empty()) return true;
+
+    columns_ = columns;
+    data_.resize(columns_.size());
+
+    size_t offset = 0;
+    for (const core::Column* col : columns_) {
+        widths_.push_back(col->dataSizeDoubles());
+        offsets_.push_back(offset);
+        offset += col->dataSizeDoubles();
+    }
+
+    return true;
+}
+
+bool FilteredColumns::append(core::Table& table, long index) {
+
+    // Tables accepted wholesale are copied into the output verbatim, so decode them as they are.
+    // n.b. The layout (e.g. the widths of the strings) is that of the first table that contributes
+    //      rows. Tables laid out differently are left to be encoded.
+
+    size_t nrows = table.rowCount();
+    if (nrows == 0) return true;
+
+    if (!initColumns(table.columns())) return false;
+
+    std::vector<std::string> names;
+    std::vector<StridedData> facades;
+    for (size_t col = 0; col < columns_.size(); ++col) {
+        size_t width = widths_[col];
+        data_[col].resize((rowCount_ + nrows) * width);
+        names.push_back(columns_[col]->name());
+        facades.emplace_back(data_[col].data() + rowCount_ * width, nrows, width * sizeof(double), width * sizeof(double));
+    }
+
+    core::DecodeTarget target(names, std::move(facades));
+    table.decode(target);
+
+    segments_.push_back(Segment{index, rowCount_, nrows});
+    rowCount_ += nrows;
+    return true;
+}
+
+bool FilteredColumns::append(core::Table& table, const std::vector<char>& selected) {
+
+    // The rows selected from a table are encoded into the output as if the SQL engine had selected them
+
+    if (std::find(selected.begin(), selected.end(), true) == selected.end()) return true;
+    if (!initColumns(table.columns())) return false;
+
+    size_t nrows = table.rowCount();
+
+    std::vector<std::vector<double>> decoded(columns_.size());
+    std::vector<std::string> names;
+    std::vector<StridedData> facades;
+    for (size_t col = 0; col < columns_.size(); ++col) {
+        size_t width = widths_[col];
+        decoded[col].resize(nrows * width);
+        names.push_back(columns_[col]->name());
+        facades.emplace_back(decoded[col].data(), nrows, width * sizeof(double), width * sizeof(double));
+    }
+
+    core::DecodeTarget target(names, std::move(facades));
+    table.decode(target);
+
+    core::MetaData stats(columns_);
+    stats.resetCodecs<core::SameByteOrder>();
+    stats.resetStats();
+
+    size_t segmentStart = rowCount_;
+    size_t firstRow = rowCount_;
+    std::vector<const double*> values(columns_.size());
+    for (size_t row = 0; row < nrows; ++row) {
+        if (!selected[row]) continue;
+        for (size_t col = 0; col < columns_.size(); ++col) values[col] = decoded[col].data() + row * widths_[col];
+        appendRow(stats, firstRow, values);
+    }
+
+    encodedValues(stats, firstRow);
+    segments_.push_back(Segment{-1, segmentStart, rowCount_ - segmentStart});
+    return true;
+}
+
+bool FilteredColumns::append(odc::Select::iterator& it, const odc::Select::iterator& end) {
+
+    // No rows, no output
+
+    if (it == end) return true;
+    if (!initColumns(it->columns())) return false;
+
+    core::MetaData stats(it->columns());
+    stats.resetCodecs<core::SameByteOrder>();
+    stats.resetStats();
+
+    size_t segmentStart = rowCount_;
+    size_t firstRow = rowCount_;
+    std::vector<const double*> values(columns_.size());
+    for ( ; it != end; ++it) {
+
+        // A change of metadata would start a new frame
+        if (it->isNewDataset() && it->columns() != columns_) return false;
+
+        const double* row = it->data();
+        for (size_t col = 0; col < columns_.size(); ++col) values[col] = row + offsets_[col];
+        appendRow(stats, firstRow, values);
+    }
+
+    encodedValues(stats, firstRow);
+    segments_.push_back(Segment{-1, segmentStart, rowCount_ - segmentStart});
+    return true;
+}
+
+void FilteredColumns::appendRow(core::MetaData& stats, size_t& firstRow, const std::vector<const double*>& values) {
+
+    for (size_t col = 0; col < columns_.size(); ++col) {
+        stats[col]->coder().gatherStats(*values[col]);
+        data_[col].insert(data_[col].end(), values[col], values[col] + widths_[col]);
+    }
+
+    // odc::Writer buffers the rows, and chooses the codecs for each block of rows that it flushes
+    // from the statistics gathered over that block (see WriterBufferingIterator)
+
+    if (++rowCount_ - firstRow == rowsBufferSize_) {
+        encodedValues(stats, firstRow);
+        firstRow = rowCount_;
+    }
+}
+
+void FilteredColumns::encodedValues(core::MetaData& stats, size_t firstRow) {
+
+    if (firstRow == rowCount_) return;
+
+    // Choose the codecs as odc::Writer does, and pass the values through them. This has exactly the
+    // effect of encoding (e.g. the loss of precision of short_real), whichever codecs are chosen.
+
+    codec::CodecOptimizer().setOptimalCodecs<core::SameByteOrder>(stats);
+
+    size_t nrows = rowCount_ - firstRow;
+
+    for (size_t col = 0; col < columns_.size(); ++col) {
+
+        core::Codec& codec(stats[col]->coder());
+        size_t width = widths_[col];
+        double* values = data_[col].data() + firstRow * width;
+
+        // n.b. No codec encodes a value into more bytes than it occupies in the row
+
+        std::vector<char> encoded(nrows * width * sizeof(double));
+        char* p = encoded.data();
+        for (size_t row = 0; row < nrows; ++row) {
+            p = codec.encode(p, values[row * width]);
+        }
+        ASSERT(p <= encoded.data() + encoded.size());
+
+        core::GeneralDataStream ds(false, encoded.data(), size_t(p - encoded.data()));
+        codec.setDataStream(ds);
+        for (size_t row = 0; row < nrows; ++row) {
+            codec.decode(values + row * width);
+        }
+        codec.clearDataStream();
+    }
+
+    stats.resetCodecs<core::SameByteOrder>();
+    stats.resetStats();
+}
+
+/// Iterates over a range of the rows, as odc::Writer::pass1 requires
+
+class FilteredColumns::RowIterator {
+public:
+    RowIterator(const FilteredColumns& owner, size_t row, size_t end) :
+        owner_(owner), first_(row), row_(row), end_(end), data_(owner.offsets_.back() + owner.widths_.back()) { fill(); }
+    bool operator!=(const RowIterator&) const { return row_ < end_; }
+    RowIterator& operator++() { ++row_; fill(); return *this; }
+    const RowIterator* operator->() const { return this; }
+
+    const core::MetaData& columns() const { return owner_.columns_; }
+    bool isNewDataset() const { return row_ == first_; }
+    const double* data() const { return data_.data(); }
+
+private:
+    void fill() {
+        if (row_ >= end_) return;
+        for (size_t col = 0; col < owner_.columns_.size(); ++col) {
+            size_t width = owner_.widths_[col];
+            ::memcpy(&data_[owner_.offsets_[col]], owner_.data_[col].data() + row_ * width, width * sizeof(double));
+        }
+    }
+
+    const FilteredColumns& owner_;
+    size_t first_;
+    size_t row_;
+    size_t end_;
+    std::vector<double> data_;
+};
+
+void FilteredColumns::encode(std::vector<core::Table>& tables, DataHandle& out) const {
+
+    const bool includeHeader = true;
+
+    for (const Segment& segment : segments_) {
+
+        if (segment.table >= 0) {
+            const Buffer encoded(tables[segment.table].readEncodedData(includeHeader));
+            ASSERT(out.write(encoded, encoded.size()) == static_cast<long>(encoded.size()));
+            continue;
+        }
+
+        // n.b. The rows are written in the same blocks, so odc::Writer chooses the same codecs as
+        //      the values have already been passed through (see encodedValues)
+
+        MemoryHandle encoded;
+        {
+            size_t last = segment.firstRow + segment.rowCount;
+            RowIterator it(*this, segment.firstRow, last);
+            RowIterator end(*this, last, last);
+
+            odc::Writer<> writer(encoded);
+            odc::Writer<>::iterator outit = writer.begin();
+            outit->pass1(it, end);
+        }
+
+        long length = encoded.position();
+        if (length > 0) {
+            ASSERT(out.write(encoded.data(), length) == length);
+        }
+    }
+}
+
+void FilteredColumns::properties(std::vector<core::Table>& tables, std::map<std::string, std::string>& properties) const {
+
+    // odc::Writer adds no properties to the rows that it encodes
+
+    for (const Segment& segment : segments_) {
+        if (segment.table >= 0) {
+            const core::Properties& p(tables[segment.table].properties());
+            properties.insert(p.begin(), p.end());
+        }
+    }
+}
+
+bool FilteredColumns::decode(core::DecodeTarget& target, size_t firstRow, size_t nrows, size_t stride) const {
+
+    const std::vector<std::string>& names(target.columns());
+    std::vector<StridedData>& facades(target.dataFacades());
+    ASSERT(names.size() == facades.size());
+
+    // Resolve the columns as core::Table does: by their full names, then by the names before the '@'.
+    // Anything unusual is left to the tables to deal with (or to report).
+
+    std::vector<size_t> sources;
+    std::vector<char> used(columns_.size(), false);
+
+    for (size_t i = 0; i < names.size(); ++i) {
+
+        if (target.types()[i] != DECODE_DEFAULT || target.dictionary(i) || target.validity()[i]) return false;
+
+        size_t col = 0;
+        while (col < columns_.size() && columns_[col]->name() != names[i]) ++col;
+        if (col == columns_.size()) {
+            col = 0;
+            while (col < columns_.size() && columns_[col]->name().substr(0, columns_[col]->name().find('@')) != names[i]) ++col;
+            if (col == columns_.size()) return false;
+        }
+
+        if (used[col]) return false;
+        if (facades[i].nelem() < nrows || facades[i].dataSize() < widths_[col] * sizeof(double)) return false;
+
+        used[col] = true;
+        sources.push_back(col);
+    }
+
+    for (size_t i = 0; i < names.size(); ++i) {
+        size_t col = sources[i];
+        size_t width = widths_[col];
+        for (size_t row = 0; row < nrows; ++row) {
+            ::memcpy(facades[i][row], data_[col].data() + (firstRow + row * stride) * width, width * sizeof(double));
+        }
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void FrameImpl::materialise() const {
+
+    if (!filtered_) return;
+
+    std::lock_guard<std::mutex> lock(*materialiseMutex_);
+    if (!tables_.empty()) return;
+
+    // Encode the rows already selected, rather than running the filter again
+
+    std::unique_ptr<MemoryHandle> encoded(new MemoryHandle);
+    {
+        encoded->openForWrite(0);
+        AutoClose closer(*encoded);
+        filtered_->encode(filterSource_, *encoded);
+    }
+
+    // n.b. All the segments have the same columns, so are read as one frame
+
+    Reader reader(encoded.release());
+    Frame frame = reader.next();
+    ASSERT(frame);
     ASSERT(!reader.next());
-    return filtered_frame;
+    ASSERT(!frame.impl_->tables_.empty());
+    tables_ = std::move(frame.impl_->tables_);
+
+    filterSource_.clear();
 }
 
-Span FrameImpl::span(const std::vector<std::string>& columns, bool onlyConstantValues) {
+Frame FrameImpl::filter(const std::string& sql) {
+
+    materialise();
+
+    // Where the rows selected can be held as columns, matching those that would be decoded from the
+    // filtered frame, the encoding is deferred until (if) it is needed.
+
+    std::shared_ptr<FilteredColumns> filtered(new FilteredColumns);
+    if (filtered->filter(sql, tables_)) {
+
+        // Nothing is encoded for an empty result
+        if (filtered->rowCount() == 0) return Frame();
+
+        return Frame(std::unique_ptr<FrameImpl>(new FrameImpl(sql, tables_, filtered)));
+    }
+
+    return encodedFilter(sql, tables_);
+}
+
+Span FrameImpl::span(const std::vector<std::string>& columns, bool onlyConstantValues, size_t nthreads) {
+
+    materialise();
+
+    // The spans of the tables are independent. They are merged in table order, irrespective of
+    // the order in which they are computed.
 
-    std::unique_ptr<SpanImpl> s(new SpanImpl(tables_.front().span(columns, onlyConstantValues)));
+    std::vector<std::unique_ptr<core::Span>> spans(tables_.size());
+    auto tableSpan = [&](size_t i) {
+        spans[i].reset(new core::Span(tables_[i].span(columns, onlyConstantValues)));
+    };
+
+    nthreads = std::max<size_t>(1, std::min(nthreads, tables_.size()));
+
+    if (nthreads == 1) {
+        for (size_t i = 0; i < tables_.size(); ++i) tableSpan(i);
+    } else {
+
+        std::mutex guard_mutex;
+        std::vector<std::future<void>> threads;
+        size_t next_frame = 0;
+
+        for (size_t i = 0; i < nthreads; i++) {
+            threads.emplace_back(std::async(std::launch::async, [&] {
+                while (true) {
+                    size_t frame;
+
+                    {
+                        std::lock_guard<std::mutex> guard(guard_mutex);
+                        if (next_frame < tables_.size()) {
+                            frame = next_frame++;
+                        } else {
+                            return;
+                        }
+                    }
+
+                    tableSpan(frame);
+                }
+            }));
+        }
+
+        // Waits for the threads. If any exceptions have been thrown, they get thrown into
+        // the main thread here.
+        for (auto& thread : threads) {
+            thread.get();
+        }
+    }
+
+    std::unique_ptr<SpanImpl> s(new SpanImpl(std::move(*spans.front())));
 
-    for (auto it = tables_.begin() + 1; it != tables_.end(); ++it) {
-        s->extend(it->span(columns, onlyConstantValues));
+    for (size_t i = 1; i < spans.size(); ++i) {
+        s->extend(*spans[i]);
     }
 
     return Span(std::move(s));
 }
 
 eckit::Offset FrameImpl::offset() const {
+    materialise();
     return tables_.front().startPosition();
 }
 
 eckit::Length FrameImpl::length() const {
+    materialise();
     return tables_.back().nextPosition() - tables_.front().startPosition();
 }
 
@@ -567,14 +1459,19 @@ const std::vector<ColumnInfo>& Frame::columnInfo() const {
     return impl_->columnInfo();
 }
 
+const std::vector<ColumnStatistics>& Frame::columnStatistics() const {
+    ASSERT(impl_);
+    return impl_->columnStatistics();
+}
+
 bool Frame::hasColumn(const std::string& column) const {
     ASSERT(impl_);
     return impl_->hasColumn(column);
 }
 
-Span Frame::span(const std::vector<std::string>& columns, bool onlyConstantValues) const {
+Span Frame::span(const std::vector<std::string>& columns, bool onlyConstantValues, size_t nthreads) const {
     ASSERT(impl_);
-    return impl_->span(columns, onlyConstantValues);
+    return impl_->span(columns, onlyConstantValues, nthreads);
 }
 
 eckit::Offset Frame::offset() const {
@@ -688,19 +1585,22 @@ void encode(DataHandle& out,
             const std::vector<ColumnInfo>& columns,
             const std::vector<ConstStridedData>& data,
             const std::map<std::string, std::string>& properties,
-            size_t maxRowsPerFrame) {
+            size_t maxRowsPerFrame,
+            const std::vector<ConstValidityBitmap>& validity) {
 
     ASSERT(columns.size() == data.size());
     ASSERT(data.size() > 0);
+    ASSERT(validity.empty() || validity.size() == data.size());
 
     size_t ncols = data.size();
     size_t nrows = data[0].nelem();
     ASSERT(std::all_of(data.begin(), data.end(), [nrows](const ConstStridedData& d) { return d.nelem() == nrows; }));
 
     if (nrows <= maxRowsPerFrame) {
-        core::encodeFrame(out, columns, data, properties);
+        core::encodeFrame(out, columns, data, properties, validity);
     } else {
         std::vector<ConstStridedData> sliced;
+        std::vector<ConstValidityBitmap> slicedValidity;
         sliced.reserve(ncols);
         size_t start = 0;
         while (start < nrows) {
@@ -708,9 +1608,13 @@ void encode(DataHandle& out,
             for (const ConstStridedData& sd : data) {
                 sliced.emplace_back(sd.slice(start, nelem));
             }
-            core::encodeFrame(out, columns, sliced, properties);
+            for (const ConstValidityBitmap& v : validity) {
+                slicedValidity.emplace_back(v ? v.slice(start) : v);
+            }
+            core::encodeFrame(out, columns, sliced, properties, slicedValidity);
             start += nelem;
             sliced.clear();
+            slicedValidity.clear();
         }
     }
 }
@@ -721,6 +1625,17 @@ size_t filter(const std::string& sql, eckit::DataHandle& in, eckit::DataHandle&
     if (sql.empty()) {
         in.saveInto(out);
     } else {
+
+        // If the whole-table fast path applies, we need to be able to revisit the tables
+
+        std::unique_ptr<odc::sql::TablePredicate> predicate(odc::sql::TablePredicate::parse(sql));
+        if (predicate && in.canSeek()) {
+            in.openForRead();
+            AutoClose closer(in);
+            core::TablesReader tables(in);
+            return filterTables(sql, *predicate, tables, out);
+        }
+
         odc::Select odb(sql, in);
         odc::Select::iterator it = odb.begin();
         odc::Select::iterator end = odb.end();
@@ -732,6 +1647,152 @@ size_t filter(const std::string& sql, eckit::DataHandle& in, eckit::DataHandle&
     return 0;
 }
 
+
+size_t filter(const std::string& sql, const std::string& path, eckit::DataHandle& out) {
+
+    // With a frame index, the frames can be selected without reading their headers
+
+    std::unique_ptr<odc::sql::TablePredicate> predicate(odc::sql::TablePredicate::parse(sql));
+    core::FrameIndex index;
+
+    if (predicate && core::FrameIndex::find(path, index)) {
+
+        std::vector<Offset> frames;
+        for (const core::FrameIndex::Frame& frame : index.frames()) {
+            if (predicate->evaluate(frame) != odc::sql::TablePredicate::NONE) frames.push_back(frame.offset);
+        }
+
+        LOG_DEBUG_LIB(LibOdc) << "filter: frame index selects " << frames.size() << " of "
+                              << index.frames().size() << " frames of " << path << std::endl;
+
+        core::TablesReader tables(path, frames);
+        return filterTables(sql, *predicate, tables, out);
+    }
+
+    FileHandle in(path);
+    AutoClose closer(in);
+    return filter(sql, in, out);
+}
+
+
+namespace {
+
+/// Does the span of the table include one of the given values, for each of the columns?
+
+bool spanSelected(core::Table& table, const std::map<std::string, std::set<std::string>>& spanValues) {
+
+    for (const auto& kv : spanValues) {
+
+        const std::string& name(kv.first);
+        // Frames without the column cannot contain the values
+        const core::Column* column = table.columns().columnByName(name);
+        if (!column) return false;
+
+        core::Span span(table.span({name}, false));
+        bool found = false;
+
+        for (const std::string& value : kv.second) {
+
+            const char* start = value.c_str();
+            char* end;
+
+            switch (column->type()) {
+            case INTEGER:
+            case BITFIELD: {
+                long v = ::strtol(start, &end, 10);
+                if (end == start || *end != '\0') throw UserError("Invalid integer value '" + value + "' for column " + name, Here());
+                found = span.getIntegerValues(name).count(v);
+                break;
+            }
+            case REAL:
+            case DOUBLE: {
+                double v = ::strtod(start, &end);
+                if (end == start || *end != '\0') throw UserError("Invalid real value '" + value + "' for column " + name, Here());
+                if (column->type() == DOUBLE) {
+                    found = span.getRealValues(name).count(v);
+                } else {
+                    // REAL values are held in single precision, so compare them as floats
+                    const std::set<double>& values(span.getRealValues(name));
+                    found = std::any_of(values.begin(), values.end(), [v](double x) {
+                        return static_cast<float>(x) == static_cast<float>(v);
+                    });
+                }
+                break;
+            }
+            case STRING:
+                found = span.getStringValues(name).count(value);
+                break;
+            default:
+                throw UserError("Unsupported column type in span selection: " + name, Here());
+            }
+
+            if (found) break;
+        }
+
+        if (!found) return false;
+    }
+
+    return true;
+}
+
+}
+
+size_t copyFrames(const std::vector<std::string>& inputs,
+                  const std::string& output,
+                  const FrameSelection& selection,
+                  bool append) {
+
+    core::FileRangeCopier copier(output, append);
+    for (const std::string& input : inputs) copier.checkInput(input);
+
+    size_t frameCount = 0;
+    size_t framesCopied = 0;
+    size_t rowsCopied = 0;
+
+    auto complete = [&] {
+        return (selection.maxFrames != 0 && framesCopied >= selection.maxFrames) ||
+               (selection.maxRows != 0 && rowsCopied >= selection.maxRows);
+    };
+
+    for (const std::string& input : inputs) {
+
+        if (complete()) break;
+
+        // Consecutive frames are copied together
+
+        long long rangeStart = 0;
+        long long rangeEnd = 0;
+
+        core::TablesReader reader(input);
+        for (auto it = reader.begin(); it != reader.end() && !complete(); ++it) {
+
+            if (frameCount++ < selection.firstFrame) continue;
+            if (!selection.spanValues.empty() && !spanSelected(*it, selection.spanValues)) continue;
+
+            long long start = it->startPosition();
+            long long next = it->nextPosition();
+
+            if (start != rangeEnd) {
+                copier.copy(input, rangeStart, rangeEnd - rangeStart);
+                rangeStart = start;
+            }
+            rangeEnd = next;
+
+            ++framesCopied;
+            rowsCopied += it->rowCount();
+        }
+
+        copier.copy(input, rangeStart, rangeEnd - rangeStart);
+    }
+
+    copier.close();
+
+    LOG_DEBUG_LIB(LibOdc) << "copyFrames: copied " << framesCopied << " frames (" << rowsCopied << " rows, "
+                          << copier.bytesWritten() << " bytes) to " << output << std::endl;
+
+    return rowsCopied;
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 
 } // namespace api
@@ -31,6 +31,7 @@
 #include "eckit/io/Length.h"
 #include "eckit/io/Offset.h"
 
+#include "odc/api/ArrowCData.h"
 #include "odc/api/ColumnType.h"
 #include "odc/api/ColumnInfo.h"
 #include "odc/api/StridedData.h"
@@ -223,6 +224,13 @@ public: // methods
      */
     const std::vector<ColumnInfo>& columnInfo() const;
 
+    /** Returns the range of the values in each column of the current frame, from the frame headers and
+     *  without decoding the data. For an aggregated frame, the statistics of the underlying frames are
+     *  combined
+     * \returns Column statistics, in the same order as the column information
+     */
+    const std::vector<ColumnStatistics>& columnStatistics() const;
+
     /** Checks if frame has a named column
      * \param name Column name
      * \returns *True* if named column exists, *false* otherwise
@@ -230,8 +238,9 @@ public: // methods
     bool hasColumn(const std::string& name) const;
 
     /** Filters current frame according to an SQL-like query and returns another frame object
-     *  (which owns its own attached memory buffer)
-     *  buffer
+     *  (which owns its own attached memory buffer). Where possible, the selected rows are held as
+     *  decoded columns, and are only encoded (once, from those columns) if the encoded data, offset,
+     *  length, span or column statistics of the filtered frame are requested
      * \param sql SQL query
      * \returns Frame object attached to a memory buffer
      */
@@ -242,13 +251,29 @@ public: // methods
      */
     eckit::Buffer encodedData();
 
+    /** Decodes the frame into a struct array of the Apache Arrow C data interface, with one child array
+     *  per column. Integer and bitfield columns become 64-bit integers, real columns 32-bit and double
+     *  columns 64-bit floating point values, with missing values marked in the validity bitmaps. String
+     *  columns are dictionary encoded, with 32-bit indices into utf8 dictionaries. The properties of the
+     *  frame are exported as the metadata of the schema.
+     *
+     *  The arrays own their buffers, which are freed by their release callbacks.
+     * \param schema Schema structure to fill
+     * \param array Array structure to fill
+     * \param columns (*optional*) Names of the columns to export. By default, all the columns
+     * \param nthreads Number of threads with which to decode an aggregated frame
+     */
+    void exportArrow(ArrowSchema* schema, ArrowArray* array,
+                     const std::vector<std::string>& columns = {}, size_t nthreads=1) const;
+
     /** Returns a Span object describing the range of values in the Frame associated with the specified columns,
      *  without decoding the frame.
      * \param columns List of column names
      * \param onlyConstantValues Introduces a constraint that a frame must have constant values in a column if *true*
+     * \param nthreads Number of threads with which to process the tables of an aggregated frame
      * \returns Span object
      */
-    Span span(const std::vector<std::string>& columns, bool onlyConstantValues) const;
+    Span span(const std::vector<std::string>& columns, bool onlyConstantValues, size_t nthreads=1) const;
 
     /** Returns key/value properties encoded in the current frame
      * \returns Map object
@@ -260,6 +285,7 @@ private: // members
     std::unique_ptr<FrameImpl> impl_;
 
     friend class Decoder;
+    friend class FrameImpl;
 };
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -319,6 +345,7 @@ public: // methods
      */
     Decoder(const std::vector<std::string>& columns,
             std::vector<StridedData>& columnFacades);
+    Decoder(Decoder&&);
     ~Decoder();
 
     /** Obtain a sub-decoder associated with a contiguous subset of the rows reference by
@@ -329,12 +356,52 @@ public: // methods
      */
     Decoder slice(size_t rowOffset, size_t nrows) const;
 
+    /** Sets the representation in which the values of a column are written. By default, all
+     *  columns are decoded into 8-byte values. Integer columns may be decoded into narrower
+     *  integers, and integer and real columns into 32- or 64-bit floating point values. Missing
+     *  values become the missing value converted to the requested type, or the largest value of
+     *  an integer type too narrow to hold it.
+     * \param column Index of the column in the decoder
+     * \param type Representation of the decoded values
+     */
+    void setType(size_t column, DecodedType type);
+
+    /** Decodes a string column as integer codes, indexing a dictionary of the strings, rather than
+     *  as the strings themselves. The codes are written as 64-bit integers, or as the integer type
+     *  set for the column. Where frames are aggregated, their dictionaries are merged.
+     * \param column Index of the column in the decoder
+     */
+    void decodeCodes(size_t column);
+
+    /** The dictionary of a column decoded as codes. This is populated by decoding.
+     * \param column Index of the column in the decoder
+     * \returns The strings indexed by the codes
+     */
+    const std::vector<std::string>& dictionary(size_t column) const;
+
+    /** Records which rows of a column are valid (not missing) in a packed bitmap, as well as
+     *  decoding the values. The bitmap must hold a bit for every row decoded.
+     * \param column Index of the column in the decoder
+     * \param bitmap Bitmap to fill, least significant bit first
+     */
+    void setValidity(size_t column, const ValidityBitmap& bitmap);
+
     /** Decodes passed frame according to current configuration
      * \param frame Frame object
      * \param nthreads Number of threads
      */
     void decode(const Frame& frame, size_t nthreads=1);
 
+    /** Decodes a subset of the rows of the passed frame. Only the rows from the nearest point
+     *  at which decoding can start need be read and decoded. These points are recorded as the
+     *  frame is decoded, so subsequent calls for rows later in the frame are cheaper.
+     * \param frame Frame object
+     * \param firstRow Index of the first row to decode
+     * \param nrows Number of rows to decode
+     * \param stride Decode every stride'th row, starting from firstRow
+     */
+    void decode(const Frame& frame, size_t firstRow, size_t nrows, size_t stride=1);
+
 private: // members
 
     std::unique_ptr<DecoderImpl> impl_;
@@ -356,18 +423,44 @@ const char* columnTypeName(const ColumnType& type);
  * \param data Description of the periodic data layout for each column to encode
  * \param properties Dictionary of key/value properties to encode
  * \param maxRowsPerFrame Maximum number of rows per frame
+ * \param validity (*optional*) Bitmaps of the valid rows of each column. Rows that are not valid are
+ *                 encoded as missing, irrespective of the data. Columns may have no bitmap.
  */
 void encode(eckit::DataHandle& out,
             const std::vector<ColumnInfo>& columns,
             const std::vector<ConstStridedData>& data,
             const std::map<std::string, std::string>& properties = {},
-            size_t maxRowsPerFrame=10000);
+            size_t maxRowsPerFrame=10000,
+            const std::vector<ConstValidityBitmap>& validity = {});
+
+/** Encodes a struct array of the Apache Arrow C data interface into ODB-2, with a column for each child
+ *  array. Integer arrays become integer columns, 32-bit floating point arrays real columns, and 64-bit
+ *  floating point arrays double columns. Utf8 arrays, and arrays dictionary encoded with utf8
+ *  dictionaries, become string columns. Null values are encoded as missing values (or empty strings).
+ * \note Where the values are already in the representation used by the encoder (64-bit floating point
+ *       values, or 64-bit integers if integers are not treated as doubles), they are encoded directly from
+ *       the Arrow buffers. Other columns are converted a column at a time.
+ * \param out Data handle (eckit)
+ * \param schema Schema of the struct array
+ * \param array Struct array to encode. This is not released.
+ * \param properties Dictionary of key/value properties to encode, in addition to any in the schema metadata
+ * \param maxRowsPerFrame Maximum number of rows per frame
+ */
+void encodeArrow(eckit::DataHandle& out,
+                 const ArrowSchema& schema,
+                 const ArrowArray& array,
+                 const std::map<std::string, std::string>& properties = {},
+                 size_t maxRowsPerFrame=10000);
 
 //----------------------------------------------------------------------------------------------------------------------
 
 /** Filters ODB-2 data according to an SQL-like query and writes result into another data handle
  * \note Depending on the query, SQL filtering may not be appropriate to do on a per-Frame basis, as aggregate
  *       values won't behave properly. This function allows filtering of an entire data stream.
+ * \note Where the query is a simple filter on column values, frames whose headers show that all their rows
+ *       are selected are copied unchanged (with their codecs and properties), frames with no selected rows
+ *       are skipped, and each remaining frame is filtered and encoded on its own. The output frames then
+ *       follow the frames of the input, rather than being re-encoded as a single stream.
  * \param sql SQL query
  * \param in Source data handle
  * \param out Target data handle
@@ -375,6 +468,50 @@ void encode(eckit::DataHandle& out,
  */
 size_t filter(const std::string& sql, eckit::DataHandle& in, eckit::DataHandle& out);
 
+/** Filters an ODB-2 file according to an SQL-like query and writes result into a data handle
+ * \note If a frame index exists alongside the file, and the query is a simple filter on column ranges,
+ *       frames that cannot match are skipped without being read. As above, the output frames follow the
+ *       frames of the input.
+ * \param sql SQL query
+ * \param path Source ODB-2 file
+ * \param out Target data handle
+ * \returns Number of rows written
+ */
+size_t filter(const std::string& sql, const std::string& path, eckit::DataHandle& out);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/** Selects which whole frames are copied by copyFrames. By default all frames are selected */
+struct FrameSelection {
+
+    /** Skip this many frames, counted across all the input files */
+    size_t firstFrame = 0;
+
+    /** Copy at most this many frames (0 = no limit) */
+    size_t maxFrames = 0;
+
+    /** Stop once at least this many rows have been copied (0 = no limit) */
+    size_t maxRows = 0;
+
+    /** Only copy frames whose span includes at least one of the given values, for each of the given columns.
+     *  The values are converted according to the type of the column */
+    std::map<std::string, std::set<std::string>> spanValues;
+};
+
+/** Copies whole frames from ODB-2 files into another file, without decoding them
+ * \note The frame headers are read and validated. The data itself is copied within the kernel where
+ *       supported (copy_file_range or sendfile), and otherwise through large buffers.
+ * \param inputs Source ODB-2 files
+ * \param output Target ODB-2 file
+ * \param selection The frames to copy
+ * \param append Append to the output file, rather than replacing it
+ * \returns Number of rows copied
+ */
+size_t copyFrames(const std::vector<std::string>& inputs,
+                  const std::string& output,
+                  const FrameSelection& selection=FrameSelection(),
+                  bool append=false);
+
 //----------------------------------------------------------------------------------------------------------------------
 
 /** Imports CSV from a source data handle into a ODB-2 data handle
@@ -18,6 +18,7 @@
 #include <cstdint>
 #include <string.h>
 #include <algorithm>
+#include <type_traits>
 
 #include "eckit/exception/Exceptions.h"
 
@@ -214,6 +215,53 @@ typedef StridedDataT<const char> ConstStridedData;
 
 //----------------------------------------------------------------------------------------------------------------------
 
+/** A packed bitmap of the rows of a column that hold valid (non-missing) values. There is one bit
+ *  per row, least significant bit first, as used by Apache Arrow. A bitmap with no data is absent. */
+template <typename value_type>
+class ValidityBitmapT {
+
+public: // methods
+
+    using void_arg_t = typename std::conditional<std::is_const<value_type>::value, const void*, void*>::type;
+
+    /** Constructor
+     * \param data Bitmap data
+     * \param offset Bit offset of the first row within the data
+     */
+    ValidityBitmapT(void_arg_t data=0, size_t offset=0) :
+        data_(reinterpret_cast<value_type*>(data)), offset_(offset) {}
+
+    /** Returns a bitmap starting from a later row
+     * \param rowOffset Row at which the new bitmap starts
+     */
+    ValidityBitmapT<value_type> slice(size_t rowOffset) const {
+        return ValidityBitmapT<value_type>(data_, offset_ + rowOffset);
+    }
+
+    explicit operator bool() const { return data_ != 0; }
+
+    value_type* data() const { return data_; }
+    size_t offset() const { return offset_; }
+
+    /** Returns true if the i'th row is valid */
+    bool valid(size_t i) const {
+        size_t bit = offset_ + i;
+        return (data_[bit / 8] >> (bit % 8)) & 1;
+    }
+
+private: // members
+
+    value_type* data_;
+    size_t offset_;
+};
+
+/** A validity bitmap that is filled by decoding */
+typedef ValidityBitmapT<unsigned char> ValidityBitmap;
+/** A validity bitmap supplied for encoding */
+typedef ValidityBitmapT<const unsigned char> ConstValidityBitmap;
+
+//----------------------------------------------------------------------------------------------------------------------
+
 } // namespace api
 } // namespace odc
 
@@ -55,6 +55,9 @@ struct odc_decoder_t {
         size_t elemSize;
         size_t stride;
         bool transpose;
+        DecodedType type;
+        bool codes;
+        void* validity;
     };
 
     odc_decoder_t() : nrows(0), dataWidth(0), dataHeight(0), externalData(0), columnMajor(false), ownedData() {}
@@ -63,6 +66,9 @@ struct odc_decoder_t {
     std::vector<std::string> columnNames;
     std::vector<DecodeColumn> columnData;
 
+    // The dictionaries of the columns decoded as codes, from the last decode
+    std::vector<std::vector<std::string>> dictionaries;
+
     size_t dataWidth;
     size_t dataHeight;
     void* externalData;
@@ -74,11 +80,13 @@ struct odc_decoder_t {
 
 struct odc_encoder_t {
 
-    odc_encoder_t() : arrayData(0), columnMajorWidth(0), nrows(0), arrayWidth(0), arrayHeight(0), maxRowsPerFrame(10000) {}
+    odc_encoder_t() : arrayData(0), columnMajorWidth(0), nrows(0), arrayWidth(0), arrayHeight(0), maxRowsPerFrame(10000),
+        arrowSchema(0), arrowArray(0) {}
 
     struct EncodeColumn {
         const void* data;
         size_t stride;
+        const void* validity;
     };
 
     const void* arrayData;
@@ -91,6 +99,10 @@ struct odc_encoder_t {
     std::vector<ColumnInfo> columnInfo;
     std::vector<EncodeColumn> columnData;
     std::map<std::string, std::string> properties;
+
+    // Alternatively, encode an Arrow struct array
+    const ArrowSchema* arrowSchema;
+    const ArrowArray* arrowArray;
 };
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -451,6 +463,20 @@ int odc_frame_bitfield_attributes(const odc_frame_t* frame, int col, int field,
     });
 }
 
+int odc_frame_column_range(const odc_frame_t* frame, int col, double* min, double* max, bool* has_missing, bool* is_constant) {
+    return wrapApiFunction([frame, col, min, max, has_missing, is_constant] {
+        ASSERT(frame);
+        const auto& stats(frame->frame_.columnStatistics());
+        ASSERT(col >= 0 && size_t(col) < stats.size());
+        const auto& colStats(stats[col]);
+
+        if (min) (*min) = colStats.min;
+        if (max) (*max) = colStats.max;
+        if (has_missing) (*has_missing) = colStats.hasMissing;
+        if (is_constant) (*is_constant) = colStats.isConstant;
+    });
+}
+
 int odc_frame_properties_count(const odc_frame_t* frame, int* nproperties) {
     return wrapApiFunction([frame, nproperties] {
         ASSERT(frame);
@@ -491,6 +517,19 @@ int odc_frame_property(const odc_frame_t* frame, const char* key, const char** v
     });
 }
 
+int odc_frame_export_arrow(const odc_frame_t* frame, int ncolumns, const char* const* columns, int nthreads,
+                           struct ArrowSchema* schema, struct ArrowArray* array) {
+    return wrapApiFunction([frame, ncolumns, columns, nthreads, schema, array] {
+        ASSERT(frame);
+        ASSERT(ncolumns >= 0);
+        ASSERT(ncolumns == 0 || columns);
+        ASSERT(nthreads > 0);
+
+        std::vector<std::string> names(columns, columns + ncolumns);
+        frame->frame_.exportArrow(schema, array, names, nthreads);
+    });
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 
 /* Decode functionality */
@@ -586,7 +625,7 @@ int odc_decoder_add_column(odc_decoder_t* decoder, const char* name) {
         ASSERT(decoder);
         ASSERT(name);
         decoder->columnNames.emplace_back(name);
-        decoder->columnData.emplace_back(odc_decoder_t::DecodeColumn {0, 0, 0, false});
+        decoder->columnData.emplace_back(odc_decoder_t::DecodeColumn {0, 0, 0, false, DECODE_DEFAULT, false, 0});
     });
 }
 
@@ -620,6 +659,61 @@ int odc_decoder_column_set_data_array(odc_decoder_t* decoder, int col, int eleme
     });
 }
 
+int odc_decoder_column_set_type(odc_decoder_t* decoder, int col, int type) {
+    return wrapApiFunction([decoder, col, type] {
+        ASSERT(decoder);
+        ASSERT(col >= 0 && size_t(col) < decoder->columnData.size());
+        ASSERT(type >= 0 && type < NUM_DECODED_TYPES);
+
+        decoder->columnData[col].type = static_cast<DecodedType>(type);
+    });
+}
+
+int odc_decoder_column_set_codes(odc_decoder_t* decoder, int col) {
+    return wrapApiFunction([decoder, col] {
+        ASSERT(decoder);
+        ASSERT(col >= 0 && size_t(col) < decoder->columnData.size());
+
+        decoder->columnData[col].codes = true;
+    });
+}
+
+int odc_decoder_column_set_validity(odc_decoder_t* decoder, int col, void* bitmap) {
+    return wrapApiFunction([decoder, col, bitmap] {
+        ASSERT(decoder);
+        ASSERT(col >= 0 && size_t(col) < decoder->columnData.size());
+
+        decoder->columnData[col].validity = bitmap;
+    });
+}
+
+int odc_decoder_column_dictionary_size(const odc_decoder_t* decoder, int col, long* size) {
+    return wrapApiFunction([decoder, col, size] {
+        ASSERT(decoder);
+        ASSERT(size);
+        ASSERT(col >= 0 && size_t(col) < decoder->columnData.size());
+        ASSERT(decoder->columnData[col].codes);
+        ASSERT(size_t(col) < decoder->dictionaries.size());
+
+        (*size) = decoder->dictionaries[col].size();
+    });
+}
+
+int odc_decoder_column_dictionary_entry(const odc_decoder_t* decoder, int col, long index, const char** value, int* length) {
+    return wrapApiFunction([decoder, col, index, value, length] {
+        ASSERT(decoder);
+        ASSERT(col >= 0 && size_t(col) < decoder->columnData.size());
+        ASSERT(decoder->columnData[col].codes);
+        ASSERT(size_t(col) < decoder->dictionaries.size());
+
+        const std::vector<std::string>& dictionary(decoder->dictionaries[col]);
+        ASSERT(index >= 0 && size_t(index) < dictionary.size());
+
+        if (value) (*value) = dictionary[index].c_str();
+        if (length) (*length) = dictionary[index].length();
+    });
+}
+
 int odc_decoder_column_data_array(const odc_decoder_t* decoder, int col, int* element_size, int* stride, const void** data) {
     return wrapApiFunction([decoder, col, element_size, stride, data] {
         ASSERT(decoder);
@@ -632,10 +726,10 @@ int odc_decoder_column_data_array(const odc_decoder_t* decoder, int col, int* el
     });
 }
 
-static void fill_in_decoder(odc_decoder_t* decoder, const odc_frame_t* frame) {
+static void fill_in_decoder(odc_decoder_t* decoder, const odc_frame_t* frame, size_t nrows) {
 
     if (decoder->nrows == 0) {
-        decoder->nrows = frame->frame_.rowCount();
+        decoder->nrows = nrows;
     }
 
     size_t height = decoder->nrows;  // in rows
@@ -646,7 +740,9 @@ static void fill_in_decoder(odc_decoder_t* decoder, const odc_frame_t* frame) {
         odc_decoder_t::DecodeColumn& col(decoder->columnData[i]);
 
         if (col.elemSize == 0) {
-            if (col.data) {
+            if (col.type != DECODE_DEFAULT || col.codes) {
+                col.elemSize = decodedTypeSize(col.type);
+            } else if (col.data) {
                 col.elemSize = sizeof(double); // backwards compatible default
             } else {
                 const std::string& colName(decoder->columnNames[i]);
@@ -697,74 +793,117 @@ static void fill_in_decoder(odc_decoder_t* decoder, const odc_frame_t* frame) {
 }
 
 
-int odc_decode_threaded(odc_decoder_t* decoder, const odc_frame_t* frame, long* rows_decoded, int nthreads) {
-    return wrapApiFunction([decoder, frame, rows_decoded, nthreads] {
+/// Decode the rows firstRow, firstRow + stride, ... (nrows of them) of the frame. If nrows is negative,
+/// all of the rows from firstRow onwards (with the given stride) are decoded.
 
-        ASSERT(decoder);
-        ASSERT(frame);
+static void decode_rows(odc_decoder_t* decoder, const odc_frame_t* frame, long* rows_decoded, int nthreads,
+                        long firstRow, long nrows, long stride) {
 
-        // Sanity checking
+    ASSERT(decoder);
+    ASSERT(frame);
+    ASSERT(firstRow >= 0);
+    ASSERT(stride > 0);
 
-        size_t frame_rows = frame->frame_.rowCount();
-        size_t frame_cols = frame->frame_.columnCount();
+    // Sanity checking
 
-        ASSERT(decoder->columnData.size() == decoder->columnNames.size());
-        ASSERT(decoder->columnNames.size() <= frame_cols);
-        ASSERT(decoder->nrows >= frame_rows);
+    size_t frame_rows = frame->frame_.rowCount();
+    size_t frame_cols = frame->frame_.columnCount();
 
-        // Fill in and allocate decode target as required
+    // The rows that are available
 
-        fill_in_decoder(decoder, frame);
+    size_t available = (size_t(firstRow) < frame_rows) ? ((frame_rows - 1 - firstRow) / stride) + 1 : 0;
+    size_t rows = (nrows < 0) ? available : std::min(available, size_t(nrows));
+    bool wholeFrame = (firstRow == 0 && stride == 1 && rows == frame_rows);
 
-        // Store of column index/temporary data for column-major columns wider than 8-bytes that
-        // need to be transposed (i.e. part of an output array).
-        std::vector<std::pair<size_t, std::unique_ptr<double[]>>> temporaryTransposeData;
+    ASSERT(decoder->columnData.size() == decoder->columnNames.size());
+    ASSERT(decoder->columnNames.size() <= frame_cols);
 
-        // Construct C++ API adapter
+    // Fill in and allocate decode target as required
 
-        std::vector<StridedData> dataFacade;
-        dataFacade.reserve(decoder->columnNames.size());
+    fill_in_decoder(decoder, frame, rows);
 
-        for (size_t i = 0; i < decoder->columnData.size(); ++i) {
-            const auto& col = decoder->columnData[i];
+    ASSERT(decoder->nrows >= rows);
 
-            void* data = col.data;
-            if (col.transpose) {
-                ASSERT(col.elemSize % sizeof(double) == 0);
-                ASSERT(col.stride == col.elemSize);
-                size_t cols = col.elemSize / sizeof(double);
-                temporaryTransposeData.emplace_back(i, std::unique_ptr<double[]>(new double[frame_rows * cols]));
-                data = temporaryTransposeData.back().second.get();
-            }
-            dataFacade.emplace_back(StridedData{data, size_t(decoder->nrows), size_t(col.elemSize), size_t(col.stride)});
+    // Store of column index/temporary data for column-major columns wider than 8-bytes that
+    // need to be transposed (i.e. part of an output array).
+    std::vector<std::pair<size_t, std::unique_ptr<double[]>>> temporaryTransposeData;
+
+    // Construct C++ API adapter
+
+    std::vector<StridedData> dataFacade;
+    dataFacade.reserve(decoder->columnNames.size());
+
+    for (size_t i = 0; i < decoder->columnData.size(); ++i) {
+        const auto& col = decoder->columnData[i];
+
+        void* data = col.data;
+        if (col.transpose) {
+            ASSERT(col.elemSize % sizeof(double) == 0);
+            ASSERT(col.stride == col.elemSize);
+            size_t cols = col.elemSize / sizeof(double);
+            temporaryTransposeData.emplace_back(i, std::unique_ptr<double[]>(new double[rows * cols]));
+            data = temporaryTransposeData.back().second.get();
         }
+        dataFacade.emplace_back(StridedData{data, size_t(decoder->nrows), size_t(col.elemSize), size_t(col.stride)});
+    }
 
-        Decoder target(decoder->columnNames, dataFacade);
+    Decoder target(decoder->columnNames, dataFacade);
+    for (size_t i = 0; i < decoder->columnData.size(); ++i) {
+        target.setType(i, decoder->columnData[i].type);
+        if (decoder->columnData[i].codes) target.decodeCodes(i);
+        if (decoder->columnData[i].validity) target.setValidity(i, ValidityBitmap(decoder->columnData[i].validity));
+    }
 
-        // Do the decoder
+    // Do the decoder
 
-        ASSERT(nthreads >= 1);
+    ASSERT(nthreads >= 1);
+    if (wholeFrame) {
         target.decode(frame->frame_, static_cast<size_t>(nthreads));
+    } else {
+        target.decode(frame->frame_, size_t(firstRow), rows, size_t(stride));
+    }
 
-        // For the cases where needed, reorder the data
-
-        for (const auto& kv : temporaryTransposeData) {
-            size_t colIndex = kv.first;
-            const double* tmpArray = kv.second.get();
-            double* output = static_cast<double*>(decoder->columnData[colIndex].data);
-            size_t rows = decoder->nrows;
-            size_t cols = decoder->columnData[colIndex].elemSize / sizeof(double);
-            for (size_t row = 0; row < frame_rows; row++) {
-                for (size_t col = 0; col < cols; col++) {
-                    output[row + (col * rows)] = tmpArray[col + (row * cols)];
-                }
+    decoder->dictionaries.clear();
+    decoder->dictionaries.resize(decoder->columnData.size());
+    for (size_t i = 0; i < decoder->columnData.size(); ++i) {
+        if (decoder->columnData[i].codes) decoder->dictionaries[i] = target.dictionary(i);
+    }
+
+    // For the cases where needed, reorder the data
+
+    for (const auto& kv : temporaryTransposeData) {
+        size_t colIndex = kv.first;
+        const double* tmpArray = kv.second.get();
+        double* output = static_cast<double*>(decoder->columnData[colIndex].data);
+        size_t height = decoder->nrows;
+        size_t cols = decoder->columnData[colIndex].elemSize / sizeof(double);
+        for (size_t row = 0; row < rows; row++) {
+            for (size_t col = 0; col < cols; col++) {
+                output[row + (col * height)] = tmpArray[col + (row * cols)];
             }
         }
+    }
 
-        // And return the values
+    // And return the values
 
 //        decoder->nrows = frame_rows;
-        if (rows_decoded) *(rows_decoded) = frame_rows;
+    if (rows_decoded) *(rows_decoded) = rows;
+}
+
+
+int odc_decode_threaded(odc_decoder_t* decoder, const odc_frame_t* frame, long* rows_decoded, int nthreads) {
+    return wrapApiFunction([decoder, frame, rows_decoded, nthreads] {
+        ASSERT(frame);
+        ASSERT(decoder);
+        ASSERT(decoder->nrows >= frame->frame_.rowCount());
+        decode_rows(decoder, frame, rows_decoded, nthreads, 0, -1, 1);
+    });
+}
+
+int odc_decode_range(odc_decoder_t* decoder, const odc_frame_t* frame, long first_row, long nrows, long stride,
+                     long* rows_decoded) {
+    return wrapApiFunction([decoder, frame, first_row, nrows, stride, rows_decoded] {
+        decode_rows(decoder, frame, rows_decoded, 1, first_row, nrows, stride);
     });
 }
 
@@ -835,8 +974,9 @@ int odc_encoder_set_data_array(odc_encoder_t* encoder, const void* data, long wi
 int odc_encoder_add_column(odc_encoder_t* encoder, const char* name, int type) {
     return wrapApiFunction([encoder, name, type] {
         ASSERT(encoder);
+        ASSERT(!encoder->arrowSchema);
         encoder->columnInfo.emplace_back(ColumnInfo{std::string(name), ColumnType(type)});
-        encoder->columnData.emplace_back(odc_encoder_t::EncodeColumn {0, 0});
+        encoder->columnData.emplace_back(odc_encoder_t::EncodeColumn {0, 0, 0});
     });
 }
 
@@ -861,6 +1001,25 @@ int odc_encoder_column_set_data_array(odc_encoder_t* encoder, int col, int eleme
     });
 }
 
+int odc_encoder_column_set_validity(odc_encoder_t* encoder, int col, const void* bitmap) {
+    return wrapApiFunction([encoder, col, bitmap] {
+        ASSERT(encoder);
+        ASSERT(col >= 0 && size_t(col) < encoder->columnInfo.size());
+        encoder->columnData[col].validity = bitmap;
+    });
+}
+
+int odc_encoder_set_arrow(odc_encoder_t* encoder, const struct ArrowSchema* schema, const struct ArrowArray* array) {
+    return wrapApiFunction([encoder, schema, array] {
+        ASSERT(encoder);
+        ASSERT(schema);
+        ASSERT(array);
+        ASSERT(encoder->columnInfo.empty());
+        encoder->arrowSchema = schema;
+        encoder->arrowArray = array;
+    });
+}
+
 int odc_encoder_column_add_bitfield(odc_encoder_t* encoder, int col, const char* name, int nbits) {
     return wrapApiFunction([encoder, col, name, nbits] {
         ASSERT(encoder);
@@ -978,6 +1137,13 @@ void fill_in_encoder(odc_encoder_t* encoder, std::vector<std::unique_ptr<char[]>
 void odc_encode_to_data_handle(odc_encoder_t* encoder, eckit::DataHandle& dh) {
 
     ASSERT(encoder);
+
+    if (encoder->arrowSchema) {
+        ASSERT(encoder->maxRowsPerFrame > 0);
+        ::odc::api::encodeArrow(dh, *encoder->arrowSchema, *encoder->arrowArray, encoder->properties, encoder->maxRowsPerFrame);
+        return;
+    }
+
     ASSERT(encoder->nrows > 0);
     ASSERT(encoder->columnData.size() == encoder->columnInfo.size());
     ASSERT(encoder->maxRowsPerFrame > 0);
@@ -993,13 +1159,19 @@ void odc_encode_to_data_handle(odc_encoder_t* encoder, eckit::DataHandle& dh) {
     stridedData.reserve(ncolumns);
 
 
+    std::vector<ConstValidityBitmap> validity;
+
     for (size_t i = 0; i < ncolumns; i++) {
         const ColumnInfo& info{encoder->columnInfo[i]};
         const odc_encoder_t::EncodeColumn& c{encoder->columnData[i]};
         stridedData.emplace_back(ConstStridedData {c.data, encoder->nrows, info.decodedSize, c.stride});
+        if (c.validity) {
+            validity.resize(ncolumns);
+            validity[i] = ConstValidityBitmap(c.validity);
+        }
     }
 
-    ::odc::api::encode(dh, encoder->columnInfo, stridedData, encoder->properties, encoder->maxRowsPerFrame);
+    ::odc::api::encode(dh, encoder->columnInfo, stridedData, encoder->properties, encoder->maxRowsPerFrame, validity);
 }
 
 
@@ -13,6 +13,16 @@ module odc
     integer(c_int), public, parameter :: ODC_BITFIELD = 4
     integer(c_int), public, parameter :: ODC_DOUBLE = 5
 
+    ! Decoded types
+
+    integer(c_int), public, parameter :: ODC_DECODE_DEFAULT = 0
+    integer(c_int), public, parameter :: ODC_DECODE_INT8 = 1
+    integer(c_int), public, parameter :: ODC_DECODE_INT16 = 2
+    integer(c_int), public, parameter :: ODC_DECODE_INT32 = 3
+    integer(c_int), public, parameter :: ODC_DECODE_INT64 = 4
+    integer(c_int), public, parameter :: ODC_DECODE_FLOAT32 = 5
+    integer(c_int), public, parameter :: ODC_DECODE_FLOAT64 = 6
+
     ! Error values
 
     integer, public, parameter :: ODC_SUCCESS = 0
@@ -49,6 +59,7 @@ module odc
         procedure :: column_count => frame_column_count
         procedure :: column_attributes => frame_column_attributes
         procedure :: bitfield_attributes => frame_bitfield_attributes
+        procedure :: column_range => frame_column_range
         procedure :: properties_count => frame_properties_count
         procedure :: property_idx => frame_property_idx
         procedure :: property => frame_property
@@ -68,8 +79,10 @@ module odc
         procedure :: column_count => decoder_column_count
         procedure :: column_set_data_size => decoder_column_set_data_size
         procedure :: column_set_data_array => decoder_column_set_data_array
+        procedure :: column_set_type => decoder_column_set_type
         procedure :: column_data_array => decoder_column_data_array
         procedure :: decode => decoder_decode
+        procedure :: decode_range => decoder_decode_range
     end type
 
 
@@ -329,6 +342,19 @@ module odc
             integer(c_int) :: err
         end function
 
+        function odc_frame_column_range(frame, col, min, max, has_missing, is_constant) result(err) bind(c)
+            ! n.b. 0-indexed column (C API)
+            use, intrinsic :: iso_c_binding
+            implicit none
+            type(c_ptr), intent(in), value :: frame
+            integer(c_int), intent(in), value :: col
+            real(c_double), intent(out) :: min
+            real(c_double), intent(out) :: max
+            logical(c_bool), intent(out) :: has_missing
+            logical(c_bool), intent(out) :: is_constant
+            integer(c_int) :: err
+        end function
+
         function odc_frame_properties_count(frame, nproperties) result(err) bind(c)
             use, intrinsic :: iso_c_binding
             implicit none
@@ -452,6 +478,16 @@ module odc
             integer(c_int) :: err
         end function
 
+        function odc_decoder_column_set_type(decoder, col, decoded_type) result(err) bind(c)
+            ! n.b. 0-indexed column (C API)
+            use, intrinsic :: iso_c_binding
+            implicit none
+            type(c_ptr), intent(in), value :: decoder
+            integer(c_int), intent(in), value :: col
+            integer(c_int), intent(in), value :: decoded_type
+            integer(c_int) :: err
+        end function
+
         function odc_decoder_column_set_data_array(decoder, col, element_size, stride, data) result(err) bind(c)
             ! n.b. 0-indexed column (C API)
             use, intrinsic :: iso_c_binding
@@ -497,6 +533,18 @@ module odc
             integer(c_int) :: err
         end function
 
+        function odc_decode_range(decoder, frame, first_row, nrows, stride, rows_decoded) result(err) bind(c)
+            use, intrinsic :: iso_c_binding
+            implicit none
+            type(c_ptr), intent(in), value :: decoder
+            type(c_ptr), intent(in), value :: frame
+            integer(c_long), intent(in), value :: first_row
+            integer(c_long), intent(in), value :: nrows
+            integer(c_long), intent(in), value :: stride
+            integer(c_long), intent(out) :: rows_decoded
+            integer(c_int) :: err
+        end function
+
         ! Work with encoders
 
         function odc_new_encoder(encoder) result(err) bind(c)
@@ -811,6 +859,33 @@ contains
 
     end function
 
+    function frame_column_range(frame, col, min, max, has_missing, is_constant) result(err)
+        ! n.b. 1-indexed column (Fortran API)
+        class(odc_frame), intent(in) :: frame
+        integer, intent(in) :: col
+        integer :: err
+
+        real(dp), intent(out), optional :: min
+        real(dp), intent(out), optional :: max
+        logical, intent(out), optional :: has_missing
+        logical, intent(out), optional :: is_constant
+
+        real(c_double) :: min_tmp
+        real(c_double) :: max_tmp
+        logical(c_bool) :: has_missing_tmp
+        logical(c_bool) :: is_constant_tmp
+
+        err = odc_frame_column_range(frame%impl, col-1, min_tmp, max_tmp, has_missing_tmp, is_constant_tmp)
+
+        if (err == ODC_SUCCESS) then
+            if (present(min)) min = min_tmp
+            if (present(max)) max = max_tmp
+            if (present(has_missing)) has_missing = has_missing_tmp
+            if (present(is_constant)) is_constant = is_constant_tmp
+        end if
+
+    end function
+
     function frame_properties_count(frame, nproperties) result(err)
         class(odc_frame), intent(in) :: frame
         integer, intent(out) :: nproperties
@@ -983,6 +1058,16 @@ contains
         err = odc_decoder_column_set_data_size(decoder%impl, col-1, element_size)
     end function
 
+    function decoder_column_set_type(decoder, col, decoded_type) result(err)
+        ! n.b. 1-indexed column (Fortran API)
+        class(odc_decoder), intent(inout) :: decoder
+        integer, intent(in) :: col
+        integer(c_int), intent(in) :: decoded_type
+        integer :: err
+
+        err = odc_decoder_column_set_type(decoder%impl, col-1, decoded_type)
+    end function
+
     function decoder_column_set_data_array(decoder, col, element_size, stride, data) result(err)
         ! n.b. 1-indexed column (Fortran API)
         class(odc_decoder), intent(inout) :: decoder
@@ -1040,6 +1125,21 @@ contains
         end if
     end function
 
+    function decoder_decode_range(decoder, frame, first_row, nrows, rows_decoded, stride) result(err)
+        class(odc_decoder), intent(inout) :: decoder
+        class(odc_frame), intent(inout) :: frame
+        integer(c_long), intent(in) :: first_row
+        integer(c_long), intent(in) :: nrows
+        integer(c_long), intent(out) :: rows_decoded
+        integer(c_long), intent(in), optional :: stride
+        integer(c_long) :: l_stride
+        integer :: err
+
+        l_stride = 1
+        if (present(stride)) l_stride = stride
+        err = odc_decode_range(decoder%impl, frame%impl, first_row-1, nrows, l_stride, rows_decoded)
+    end function
+
     ! Methods for the encoder
 
     function encoder_initialise(encoder) result(err)
@@ -29,6 +29,8 @@ extern "C" {
 
 #include <stdbool.h>
 
+#include "odc/api/ArrowCData.h"
+
 /** \defgroup Initialisation */
 /** @{ */
 
@@ -126,6 +128,24 @@ enum OdcColumnType {
     ODC_DOUBLE   = 5
 };
 
+/** Representations into which the values of a column may be decoded */
+enum OdcDecodedType {
+    /** 8-byte values. Integers are decoded as doubles or longs according to #odc_integer_behaviour */
+    ODC_DECODE_DEFAULT = 0,
+    /** 8-bit signed integers */
+    ODC_DECODE_INT8    = 1,
+    /** 16-bit signed integers */
+    ODC_DECODE_INT16   = 2,
+    /** 32-bit signed integers */
+    ODC_DECODE_INT32   = 3,
+    /** 64-bit signed integers */
+    ODC_DECODE_INT64   = 4,
+    /** 32-bit floating point values */
+    ODC_DECODE_FLOAT32 = 5,
+    /** 64-bit floating point values */
+    ODC_DECODE_FLOAT64 = 6
+};
+
 /** Retrieves number of supported column data types
  * \param count Return variable for number of data types
  * \returns Return code (#OdcErrorValues)
@@ -300,6 +320,18 @@ int odc_frame_column_attributes(const odc_frame_t* frame, int col, const char**
  */
 int odc_frame_bitfield_attributes(const odc_frame_t* frame, int col, int entry, const char** name, int* offset, int* size);
 
+/** Retrieves the range of the values in a column, from the frame headers and without decoding the data. For an
+ *  aggregated frame, the statistics of the underlying frames are combined.
+ * \param frame Frame instance
+ * \param col Target column index
+ * \param min (*optional*) Return variable for the smallest non-missing value, as decoded. The missing value if there are no non-missing values.
+ * \param max (*optional*) Return variable for the largest non-missing value, as decoded. The missing value if there are no non-missing values.
+ * \param has_missing (*optional*) Return variable for whether any of the values are missing
+ * \param is_constant (*optional*) Return variable for whether all the values are equal to the minimum
+ * \returns Return code (#OdcErrorValues)
+ */
+int odc_frame_column_range(const odc_frame_t* frame, int col, double* min, double* max, bool* has_missing, bool* is_constant);
+
 /** Retrieves the number of properties encoded in the frame
  * \param frame Frame instance
  * \param nproperties Return variable for number of properties
@@ -324,6 +356,21 @@ int odc_frame_property_idx(const odc_frame_t* frame, int idx, const char** key,
  */
 int odc_frame_property(const odc_frame_t* frame, const char* key, const char** value);
 
+/** Decodes the frame into a struct array of the Apache Arrow C data interface, with one child array per
+ * column. Integer and bitfield columns become 64-bit integers, real columns 32-bit and double columns 64-bit
+ * floating point values, with missing values marked in the validity bitmaps. String columns are dictionary
+ * encoded, with 32-bit indices into utf8 dictionaries. The frame properties become the schema metadata.
+ * \param frame Frame instance
+ * \param ncolumns Number of columns to export, or zero to export all of the columns
+ * \param columns (*optional*) Names of the columns to export
+ * \param nthreads Number of threads with which to decode an aggregated frame
+ * \param schema Return variable for the schema. Must be released by calling its release callback.
+ * \param array Return variable for the array. Must be released by calling its release callback.
+ * \returns Return code (#OdcErrorValues)
+ */
+int odc_frame_export_arrow(const odc_frame_t* frame, int ncolumns, const char* const* columns, int nthreads,
+                           struct ArrowSchema* schema, struct ArrowArray* array);
+
 /** @} */
 
 
@@ -432,6 +479,59 @@ int odc_decoder_column_set_data_size(odc_decoder_t* decoder, int col, int elemen
  */
 int odc_decoder_column_set_data_array(odc_decoder_t* decoder, int col, int element_size, int stride, void* data);
 
+/**
+ * Sets the representation into which the values of the column are decoded. Integer columns may be
+ * decoded into narrower integers, and integer and real columns into 32- or 64-bit floating point
+ * values. Missing values become the missing value converted to the requested type, or the largest
+ * value of an integer type that is too narrow to hold it. If no element size has been specified
+ * for the column, it is taken from the type.
+ * \param decoder Decoder instance
+ * \param col Column index
+ * \param type Representation of the decoded values (#OdcDecodedType)
+ * \returns Return code (#OdcErrorValues)
+ */
+int odc_decoder_column_set_type(odc_decoder_t* decoder, int col, int type);
+
+/**
+ * Decodes a string column as integer codes, indexing a dictionary of the strings, rather than as the
+ * strings themselves. The codes are written as 64-bit integers, or as the type set with
+ * #odc_decoder_column_set_type.
+ * \param decoder Decoder instance
+ * \param col Column index
+ * \returns Return code (#OdcErrorValues)
+ */
+int odc_decoder_column_set_codes(odc_decoder_t* decoder, int col);
+
+/**
+ * Sets a bitmap in which to record which rows of the column are valid (not missing), in addition to
+ * decoding the values. There is one bit per decoded row, least significant bit first, set for valid rows.
+ * \param decoder Decoder instance
+ * \param col Column index
+ * \param bitmap Bitmap of at least (nrows + 7) / 8 bytes
+ * \returns Return code (#OdcErrorValues)
+ */
+int odc_decoder_column_set_validity(odc_decoder_t* decoder, int col, void* bitmap);
+
+/**
+ * Retrieves the number of entries in the dictionary of a column decoded as codes
+ * \param decoder Decoder instance
+ * \param col Column index
+ * \param size Return variable for the number of dictionary entries
+ * \returns Return code (#OdcErrorValues)
+ */
+int odc_decoder_column_dictionary_size(const odc_decoder_t* decoder, int col, long* size);
+
+/**
+ * Retrieves an entry of the dictionary of a column decoded as codes
+ * \param decoder Decoder instance
+ * \param col Column index
+ * \param index The code of the entry
+ * \param value (*optional*) Return variable for the string. Returned pointer valid until the next decode.
+ * \param length (*optional*) Return variable for the length of the string
+ * \returns Return code (#OdcErrorValues)
+ */
+int odc_decoder_column_dictionary_entry(const odc_decoder_t* decoder, int col, long index, const char** value, int* length);
+
 /**
  * Retrieves the buffer and data layout into which the data has been decoded
  * \param decoder Decoder instance
@@ -465,6 +565,24 @@ int odc_decode(odc_decoder_t* decoder, const odc_frame_t* frame, long* rows_deco
  */
 int odc_decode_threaded(odc_decoder_t* decoder, const odc_frame_t* frame, long* rows_decoded, int nthreads);
 
+/**
+ * Decodes a subset of the rows described by the frame into the configured data array(s): the rows
+ * first_row, first_row + stride, first_row + 2*stride, ... up to a maximum of nrows rows.
+ *
+ * Decoding need only start from the nearest checkpoint before each row. Checkpoints are recorded
+ * as the frame is decoded, so subsequent calls on the same frame are cheaper.
+ *
+ * \param decoder Decoder instance
+ * \param frame Frame instance
+ * \param first_row Index of the first row to decode
+ * \param nrows Maximum number of rows to decode. If negative, all rows up to the end of the frame
+ * \param stride Distance between the decoded rows (1 to decode a contiguous range)
+ * \param rows_decoded (*optional*) Return variable for number of decoded rows
+ * \returns Return code (#OdcErrorValues)
+ */
+int odc_decode_range(odc_decoder_t* decoder, const odc_frame_t* frame, long first_row, long nrows, long stride,
+                     long* rows_decoded);
+
 /** @} */
 
 
@@ -549,6 +667,27 @@ int odc_encoder_column_set_data_size(odc_encoder_t* encoder, int col, int elemen
  */
 int odc_encoder_column_set_data_array(odc_encoder_t* encoder, int col, int element_size, int stride, const void* data);
 
+/**
+ * Sets a bitmap of the rows of the column that are valid. Rows whose bit is clear are encoded as missing
+ * values, irrespective of the data. There is one bit per row, least significant bit first.
+ * \param encoder Encoder instance
+ * \param col Column index
+ * \param bitmap Bitmap of at least (nrows + 7) / 8 bytes
+ * \returns Return code (#OdcErrorValues)
+ */
+int odc_encoder_column_set_validity(odc_encoder_t* encoder, int col, const void* bitmap);
+
+/**
+ * Sets a struct array of the Apache Arrow C data interface as the source of the columns to encode, in place
+ * of columns added with #odc_encoder_add_column. Each child array becomes a column. Null values are encoded
+ * as missing values. The schema metadata is encoded as properties, along with any added to the encoder.
+ * \param encoder Encoder instance
+ * \param schema Schema of the struct array. Must remain valid until encoded.
+ * \param array Struct array. Must remain valid until encoded. It is not released by the encoder.
+ * \returns Return code (#OdcErrorValues)
+ */
+int odc_encoder_set_arrow(odc_encoder_t* encoder, const struct ArrowSchema* schema, const struct ArrowArray* array);
+
 /** Adds a bitfield to a column
  * \param encoder Encoder instance
  * \param col Column index
@@ -15,6 +15,8 @@
 #ifndef odc_core_codec_Constant_H
 #define odc_core_codec_Constant_H
 
+#include <type_traits>
+
 #include "odc/core/Codec.h"
 
 namespace odc {
@@ -37,6 +39,8 @@ public: // methods
     CodecConstant(api::ColumnType type, const std::string& name=codec_name()) : core::DataStreamCodec<ByteOrder>(name, type) {}
     ~CodecConstant() {}
 
+    bool decodesIntegers() const override { return std::is_same<ValueType, int64_t>::value; }
+
 private: // methods
 
     void gatherStats(const double& v) override;
@@ -11,6 +11,8 @@
 #ifndef odc_core_codec_Integer_H
 #define odc_core_codec_Integer_H
 
+#include <type_traits>
+
 #include "odc/core/Codec.h"
 
 /// @note We have some strange behaviour in here. In particular, we support BOTH decoding
@@ -46,6 +48,8 @@ public: // methods
 
     ~BaseCodecInteger() override {}
 
+    bool decodesIntegers() const override { return std::is_same<ValueType, int64_t>::value; }
+
 private: // methods
 
     void missingValue(double v) override {
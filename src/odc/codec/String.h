@@ -81,7 +81,8 @@ public: // methods
 
     IntStringCodecBase(api::ColumnType type, const std::string& name) :
         CodecChars<ByteOrder>(type, name),
-        intCodec_(api::INTEGER) {
+        intCodec_(api::INTEGER),
+        paddedSizeDoubles_(0) {
 
         this->min_ = odc::MDI::integerMDI();
         this->max_ = this->min_;
@@ -133,6 +134,15 @@ private: // methods
     }
 
     void decode(double* out) override {
+        int64_t code = decodeCode();
+        const std::vector<double>& padded(paddedStrings());
+        ::memcpy(out, &padded[code * this->decodedSizeDoubles_], this->decodedSizeDoubles_*sizeof(double));
+    }
+
+    bool hasDictionary() const override { return true; }
+    const std::vector<std::string>& dictionary() const override { return this->strings_; }
+
+    int64_t decodeCode() override {
 
         // n.b. Reinterpret cast is yucky, but is for backward compatibility with old interface.
         // CodecInt*<, int64_t> undoes that internally.
@@ -142,10 +152,24 @@ private: // methods
         static_cast<core::Codec&>(intCodec_).decode(reinterpret_cast<double*>(&i));
 
         ASSERT(i < long(this->strings_.size()));
-        const std::string& s(this->strings_[i]);
+        return i;
+    }
+
+    /// The string table expanded into zero-padded, fixed width entries. This is built once per
+    /// frame (or whenever the decoded width changes), so that decoding a row is a single copy.
+    const std::vector<double>& paddedStrings() {
 
-        ::memset(out, 0, this->decodedSizeDoubles_*sizeof(double));
-        ::memcpy(reinterpret_cast<char*>(out), &s[0], std::min(s.length(), this->decodedSizeDoubles_*sizeof(double)));
+        if (paddedSizeDoubles_ != this->decodedSizeDoubles_) {
+            size_t width = this->decodedSizeDoubles_;
+            paddedStrings_.assign(this->strings_.size() * width, 0);
+            for (size_t i = 0; i < this->strings_.size(); ++i) {
+                const std::string& s(this->strings_[i]);
+                ::memcpy(&paddedStrings_[i * width], s.data(), std::min(s.length(), width*sizeof(double)));
+            }
+            paddedSizeDoubles_ = width;
+        }
+
+        return paddedStrings_;
     }
 
     void skip() override {
@@ -187,6 +211,10 @@ private: // methods
 
         // Ensure that the string lookup is EMPTY. We don't use it after reading
         ASSERT(this->stringLookup_.size() == 0);
+
+        // The padded dictionary will be rebuilt on first decode
+        paddedStrings_.clear();
+        paddedSizeDoubles_ = 0;
     }
 
     using CodecChars<ByteOrder>::save;
@@ -206,6 +234,9 @@ private: // methods
 private: // members
 
     InternalCodec intCodec_;
+
+    std::vector<double> paddedStrings_;
+    size_t paddedSizeDoubles_;
 };
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -14,6 +14,7 @@
 
 #include <cstring>
 #include <limits>
+#include <vector>
 
 #include "odc/api/ColumnType.h"
 #include "odc/core/CodecFactory.h"
@@ -77,6 +78,16 @@ public:
     virtual size_t numStrings() const { NOTIMP; }
     virtual void copyStrings(Codec& rhs) { NOTIMP; }
 
+    // Access to the per-frame dictionary of string codecs. This allows callers to work with
+    // the integer codes directly, rather than materialising a string for every row.
+    virtual bool hasDictionary() const { return false; }
+    virtual const std::vector<std::string>& dictionary() const { NOTIMP; }
+    virtual int64_t decodeCode() { NOTIMP; }
+
+    /// Integer and bitfield columns may be decoded into 64-bit integers, rather than doubles,
+    /// according to the settings in force when the codec was built
+    virtual bool decodesIntegers() const { return false; }
+
     virtual size_t dataSizeDoubles() const { return 1; }
     virtual void dataSizeDoubles(size_t count) {
         if (count != 1)
@@ -19,12 +19,20 @@ namespace core {
 DecodeTarget::DecodeTarget(const std::vector<std::string>& columns,
                            const std::vector<api::StridedData>& facades) :
     columns_(columns),
-    columnFacades_(facades) {}
+    columnFacades_(facades),
+    types_(columnFacades_.size(), api::DECODE_DEFAULT),
+    dictionaries_(columnFacades_.size()),
+    validity_(columnFacades_.size()),
+    validityMutex_(std::make_shared<std::mutex>()) {}
 
 DecodeTarget::DecodeTarget(const std::vector<std::string>& columns,
                            std::vector<api::StridedData>&& facades) :
     columns_(columns),
-    columnFacades_(std::move(facades)) {}
+    columnFacades_(std::move(facades)),
+    types_(columnFacades_.size(), api::DECODE_DEFAULT),
+    dictionaries_(columnFacades_.size()),
+    validity_(columnFacades_.size()),
+    validityMutex_(std::make_shared<std::mutex>()) {}
 
 DecodeTarget::~DecodeTarget() {}
 
@@ -36,6 +44,38 @@ std::vector<api::StridedData>& DecodeTarget::dataFacades() {
     return columnFacades_;
 }
 
+const std::vector<api::DecodedType>& DecodeTarget::types() const {
+    return types_;
+}
+
+void DecodeTarget::type(size_t column, api::DecodedType type) {
+    ASSERT(column < types_.size());
+    types_[column] = type;
+}
+
+void DecodeTarget::decodeCodes(size_t column) {
+    ASSERT(column < dictionaries_.size());
+    if (!dictionaries_[column]) dictionaries_[column] = std::make_shared<Dictionary>();
+}
+
+DecodeTarget::Dictionary* DecodeTarget::dictionary(size_t column) const {
+    ASSERT(column < dictionaries_.size());
+    return dictionaries_[column].get();
+}
+
+void DecodeTarget::validity(size_t column, const api::ValidityBitmap& bitmap) {
+    ASSERT(column < validity_.size());
+    validity_[column] = bitmap;
+}
+
+const std::vector<api::ValidityBitmap>& DecodeTarget::validity() const {
+    return validity_;
+}
+
+std::mutex& DecodeTarget::validityMutex() const {
+    return *validityMutex_;
+}
+
 DecodeTarget DecodeTarget::slice(size_t rowOffset, size_t nrows) {
 
     std::vector<api::StridedData> newFacades;
@@ -44,7 +84,37 @@ DecodeTarget DecodeTarget::slice(size_t rowOffset, size_t nrows) {
         newFacades.emplace_back(facade.slice(rowOffset, nrows));
     }
 
-    return DecodeTarget(columns_, std::move(newFacades));
+    DecodeTarget sliced(columns_, std::move(newFacades));
+    sliced.types_ = types_;
+    sliced.dictionaries_ = dictionaries_;
+    sliced.validityMutex_ = validityMutex_;
+    for (size_t i = 0; i < validity_.size(); ++i) {
+        if (validity_[i]) sliced.validity_[i] = validity_[i].slice(rowOffset);
+    }
+    return sliced;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::vector<int64_t> DecodeTarget::Dictionary::merge(const std::vector<std::string>& strings) {
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<int64_t> codes;
+    codes.reserve(strings.size());
+    for (const std::string& s : strings) {
+        auto it = lookup_.find(s);
+        if (it == lookup_.end()) {
+            it = lookup_.emplace(s, int64_t(strings_.size())).first;
+            strings_.push_back(s);
+        }
+        codes.push_back(it->second);
+    }
+    return codes;
+}
+
+int64_t DecodeTarget::Dictionary::code(const std::string& s) {
+    return merge({s})[0];
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -14,8 +14,13 @@
 #ifndef odc_core_DecodeTarget_H
 #define odc_core_DecodeTarget_H
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
+#include "odc/api/ColumnType.h"
 #include "odc/api/StridedData.h"
 
 
@@ -27,6 +32,25 @@ namespace core {
 
 class DecodeTarget {
 
+public: // types
+
+    /// The strings of a column decoded as integer codes. The dictionaries of all the tables
+    /// decoded into the target are merged, so the codes are consistent across them.
+
+    class Dictionary {
+    public:
+        /// Returns the code of each of the strings, adding any not yet in the dictionary
+        std::vector<int64_t> merge(const std::vector<std::string>& strings);
+        int64_t code(const std::string& s);
+
+        const std::vector<std::string>& strings() const { return strings_; }
+
+    private:
+        std::mutex mutex_;
+        std::vector<std::string> strings_;
+        std::map<std::string, int64_t> lookup_;
+    };
+
 public: // methods
 
     DecodeTarget(const std::vector<std::string> & columns,
@@ -38,12 +62,34 @@ public: // methods
     const std::vector<std::string>& columns() const;
     std::vector<api::StridedData>& dataFacades();
 
+    /// The representation in which each column is written. By default, all the columns are
+    /// decoded into 8-byte values.
+    const std::vector<api::DecodedType>& types() const;
+    void type(size_t column, api::DecodedType type);
+
+    /// Decode a (string) column as integer codes into a dictionary, rather than as the strings.
+    /// The codes are written as 64-bit integers, or as the integer type set for the column.
+    void decodeCodes(size_t column);
+    Dictionary* dictionary(size_t column) const;
+
+    /// Record which rows of a column are valid (non-missing) in a bitmap, as well as writing the
+    /// values. The bytes of the bitmap shared by two slices of the target are updated under a lock.
+    void validity(size_t column, const api::ValidityBitmap& bitmap);
+    const std::vector<api::ValidityBitmap>& validity() const;
+    std::mutex& validityMutex() const;
+
     DecodeTarget slice(size_t rowOffset, size_t nrows);
 
 private: // members
 
     std::vector<std::string> columns_;
     std::vector<api::StridedData> columnFacades_;
+    std::vector<api::DecodedType> types_;
+
+    // Shared with the slices of the target
+    std::vector<std::shared_ptr<Dictionary>> dictionaries_;
+    std::vector<api::ValidityBitmap> validity_;
+    std::shared_ptr<std::mutex> validityMutex_;
 };
 
 
@@ -10,6 +10,8 @@
 
 #include "odc/core/Encoder.h"
 
+#include <cstring>
+
 #include "odc/LibOdc.h"
 #include "odc/codec/CodecOptimizer.h"
 #include "odc/core/Header.h"
@@ -25,9 +27,11 @@ namespace core {
 void encodeFrame(eckit::DataHandle& out,
                  const std::vector<api::ColumnInfo>& columns,
                  const std::vector<api::ConstStridedData>& data,
-                 const std::map<std::string, std::string>& properties) {
+                 const std::map<std::string, std::string>& properties,
+                 const std::vector<api::ConstValidityBitmap>& validity) {
 
     ASSERT(columns.size() == data.size());
+    ASSERT(validity.empty() || validity.size() == data.size());
     ASSERT(columns.size() > 0);
     MetaData md;
 
@@ -52,6 +56,27 @@ void encodeFrame(eckit::DataHandle& out,
         }
     }
 
+    // Where validity bitmaps are supplied, the rows that are not valid take the missing value (or
+    // an empty string) in place of the data.
+
+    std::vector<char> hasValidity(ncols, false);
+    std::vector<std::vector<char>> missing(ncols);
+    for (size_t col = 0; col < validity.size(); ++col) {
+        if (validity[col]) {
+            hasValidity[col] = true;
+            missing[col].resize(data[col].dataSize(), 0);
+            if (columns[col].type != api::STRING) {
+                double mv = md[col]->coder().missingValue();
+                ::memcpy(&missing[col][0], &mv, sizeof(mv));
+            }
+        }
+    }
+
+    auto value = [&](size_t col, size_t row) -> const char* {
+        if (hasValidity[col] && !validity[col].valid(row)) return &missing[col][0];
+        return data[col].get(row);
+    };
+
     // Gather statistics over all the columns
 
     size_t maxRowSize = sizeof(uint16_t); // all rows contain a marker
@@ -60,8 +85,14 @@ void encodeFrame(eckit::DataHandle& out,
         ASSERT(data[col].nelem() == nrows);
         Codec& coder(md[col]->coder());
 
-        for (const char* d : data[col]) {
-            coder.gatherStats(*reinterpret_cast<const double*>(d));
+        if (hasValidity[col]) {
+            for (size_t row = 0; row < nrows; ++row) {
+                coder.gatherStats(*reinterpret_cast<const double*>(value(col, row)));
+            }
+        } else {
+            for (const char* d : data[col]) {
+                coder.gatherStats(*reinterpret_cast<const double*>(d));
+            }
         }
         maxRowSize += data[col].dataSize();
     }
@@ -90,7 +121,11 @@ void encodeFrame(eckit::DataHandle& out,
 
         if (row != 0) {
             for (; startCol < ncols; ++startCol) {
-                if (sortedData[startCol].isNewValue(row)) break;
+                if (hasValidity[startCol]) {
+                    if (::memcmp(value(startCol, row), value(startCol, row-1), data[startCol].dataSize()) != 0) break;
+                } else if (sortedData[startCol].isNewValue(row)) {
+                    break;
+                }
             }
         }
 
@@ -104,7 +139,7 @@ void encodeFrame(eckit::DataHandle& out,
         // Write the updated values
         char* p = encodedStream.get();
         for (size_t col = startCol; col < ncols; col++) {
-            p = coders[col]->encode(p, *reinterpret_cast<const double*>(sortedData[col].get(row)));
+            p = coders[col]->encode(p, *reinterpret_cast<const double*>(value(col, row)));
         }
         encodedStream.set(p);
     }
@@ -26,10 +26,12 @@ namespace core {
 
 //----------------------------------------------------------------------------------------------------------------------
 
+/// Rows that are not valid according to the (optional) validity bitmaps are encoded as missing values
 void encodeFrame(eckit::DataHandle& out,
                  const std::vector<api::ColumnInfo>& columns,
                  const std::vector<api::ConstStridedData>& data,
-                 const std::map<std::string, std::string>& properties);
+                 const std::map<std::string, std::string>& properties,
+                 const std::vector<api::ConstValidityBitmap>& validity={});
 
 //----------------------------------------------------------------------------------------------------------------------
 
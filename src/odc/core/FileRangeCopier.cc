@@ -0,0 +1,243 @@
+/*
+ * (C) Copyright 1996-2018 ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#endif
+
+#include "eckit/exception/Exceptions.h"
+#include "eckit/log/Log.h"
+
+#include "odc/core/FileRangeCopier.h"
+#include "odc/LibOdc.h"
+
+using namespace eckit;
+
+namespace odc {
+namespace core {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+const size_t COPY_BUFFER_SIZE = 16 * 1024 * 1024;
+
+/// The kernel copies are not supported between these file descriptors (e.g. different filesystems,
+/// or the output is not a regular file). Fall back to something else.
+
+bool unsupported(int err) {
+    return err == EXDEV || err == EINVAL || err == ENOSYS || err == EOPNOTSUPP || err == EBADF;
+}
+
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+FileRangeCopier::FileRangeCopier(const PathName& output, bool append) :
+    output_(output.asString()),
+    fd_(-1),
+    bytesWritten_(0),
+    device_(0),
+    inode_(0),
+    truncate_(!append),
+    useCopyFileRange_(true),
+    useSendfile_(true) {
+
+    // n.b. Not O_TRUNC. The output may turn out to be one of the inputs.
+
+    fd_ = ::open(output_.c_str(), O_WRONLY | O_CREAT | (append ? O_APPEND : 0), 0666);
+    if (fd_ < 0) throw CantOpenFile(output_);
+
+    struct stat st;
+    if (::fstat(fd_, &st) != 0) {
+        ::close(fd_);
+        throw FailedSystemCall("fstat " + output_);
+    }
+    device_ = st.st_dev;
+    inode_ = st.st_ino;
+}
+
+
+FileRangeCopier::~FileRangeCopier() {
+    if (fd_ >= 0) ::close(fd_);
+}
+
+
+void FileRangeCopier::close() {
+    if (fd_ >= 0) {
+        truncate();
+        int fd = fd_;
+        fd_ = -1;
+        if (::close(fd) != 0) throw WriteError(output_);
+    }
+}
+
+
+void FileRangeCopier::copy(const PathName& input, const Offset& offset, const Length& length) {
+
+    ASSERT(fd_ >= 0);
+    if (length == Length(0)) return;
+
+    std::string path(input.asString());
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw CantOpenFile(path);
+
+    try {
+        checkInput(fd, path);
+        truncate();
+        copy(fd, path, static_cast<long long>(offset), static_cast<long long>(length));
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+
+    ::close(fd);
+}
+
+
+void FileRangeCopier::checkInput(const PathName& input) {
+
+    ASSERT(fd_ >= 0);
+
+    std::string path(input.asString());
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw CantOpenFile(path);
+
+    try {
+        checkInput(fd, path);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+
+    ::close(fd);
+}
+
+
+void FileRangeCopier::checkInput(int fd, const std::string& input) {
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) throw FailedSystemCall("fstat " + input);
+
+    if (static_cast<unsigned long long>(st.st_dev) == device_ &&
+        static_cast<unsigned long long>(st.st_ino) == inode_) {
+        // Leave the file as it was
+        truncate_ = false;
+        throw UserError("Cannot copy " + input + " onto itself (output " + output_ + ")", Here());
+    }
+}
+
+
+void FileRangeCopier::truncate() {
+    if (truncate_) {
+        if (::ftruncate(fd_, 0) != 0) throw WriteError(output_);
+        truncate_ = false;
+    }
+}
+
+
+void FileRangeCopier::write(const void* data, size_t length) {
+
+    ASSERT(fd_ >= 0);
+    truncate();
+    const char* p = static_cast<const char*>(data);
+
+    for (size_t written = 0; written < length; ) {
+        ssize_t w = ::write(fd_, p + written, length - written);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) throw WriteError(output_);
+        written += w;
+        bytesWritten_ += w;
+    }
+}
+
+
+void FileRangeCopier::copy(int fd, const std::string& input, long long offset, long long length) {
+
+    // n.b. bytesWritten_ only counts the data that has actually been written
+
+    if (copyInKernel(fd, input, offset, length)) return;
+
+    // Fall back to a buffered copy
+
+    std::vector<char> buffer(std::min<long long>(length, COPY_BUFFER_SIZE));
+
+    while (length > 0) {
+        ssize_t n = ::pread(fd, &buffer[0], std::min<long long>(length, buffer.size()), offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) throw ReadError(input);
+
+        for (ssize_t written = 0; written < n; ) {
+            ssize_t w = ::write(fd_, &buffer[written], n - written);
+            if (w < 0 && errno == EINTR) continue;
+            if (w <= 0) throw WriteError(output_);
+            written += w;
+            bytesWritten_ += w;
+        }
+
+        offset += n;
+        length -= n;
+    }
+}
+
+
+bool FileRangeCopier::copyInKernel(int fd, const std::string& input, long long& offset, long long& length) {
+
+#ifdef __linux__
+
+#ifdef SYS_copy_file_range
+    while (useCopyFileRange_ && length > 0) {
+        loff_t off = offset;
+        ssize_t n = ::syscall(SYS_copy_file_range, fd, &off, fd_, nullptr, size_t(length), 0u);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && unsupported(errno)) {
+            LOG_DEBUG_LIB(LibOdc) << "copy_file_range not supported from " << input << " to " << output_ << std::endl;
+            useCopyFileRange_ = false;
+            break;
+        }
+        if (n <= 0) throw ReadError(input);
+        offset += n;
+        length -= n;
+        bytesWritten_ += n;
+    }
+#endif
+
+    while (useSendfile_ && length > 0) {
+        off_t off = offset;
+        ssize_t n = ::sendfile(fd_, fd, &off, size_t(length));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && unsupported(errno)) {
+            LOG_DEBUG_LIB(LibOdc) << "sendfile not supported from " << input << " to " << output_ << std::endl;
+            useSendfile_ = false;
+            break;
+        }
+        if (n <= 0) throw ReadError(input);
+        offset += n;
+        length -= n;
+        bytesWritten_ += n;
+    }
+
+#endif
+
+    return length == 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace core
+} // namespace odc
@@ -0,0 +1,83 @@
+/*
+ * (C) Copyright 1996-2018 ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+#ifndef odc_core_FileRangeCopier_H
+#define odc_core_FileRangeCopier_H
+
+#include <string>
+
+#include "eckit/filesystem/PathName.h"
+#include "eckit/io/Length.h"
+#include "eckit/io/Offset.h"
+#include "eckit/memory/NonCopyable.h"
+
+namespace odc {
+namespace core {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/// Copies byte ranges of files onto the end of an output file.
+///
+/// Where the platform supports it, the data is moved within the kernel (copy_file_range, which may
+/// share the underlying extents, or sendfile) without passing through user space. Otherwise it is
+/// copied through a large buffer.
+///
+/// The output is not truncated until the first data is written (or it is closed), and the output file
+/// may not be one of the inputs, so that an in-place copy is rejected without destroying its source.
+
+class FileRangeCopier : private eckit::NonCopyable {
+
+public: // methods
+
+    FileRangeCopier(const eckit::PathName& output, bool append=false);
+    ~FileRangeCopier();
+
+    void copy(const eckit::PathName& input, const eckit::Offset& offset, const eckit::Length& length);
+
+    /// Throws a UserError if the input is the output file. Call this for each input before writing
+    /// anything, so that the output is left untouched.
+    void checkInput(const eckit::PathName& input);
+
+    /// Interleave data held in memory (e.g. rewritten headers) with the copied ranges
+    void write(const void* data, size_t length);
+
+    void close();
+
+    eckit::Length bytesWritten() const { return eckit::Length(bytesWritten_); }
+
+private: // methods
+
+    void copy(int fd, const std::string& input, long long offset, long long length);
+    bool copyInKernel(int fd, const std::string& input, long long& offset, long long& length);
+    void checkInput(int fd, const std::string& input);
+    void truncate();
+
+private: // members
+
+    std::string output_;
+    int fd_;
+    unsigned long long bytesWritten_;
+
+    /// Identify the output file, to detect it being used as an input
+    unsigned long long device_;
+    unsigned long long inode_;
+    bool truncate_;
+
+    /// Once the kernel has refused a copy, don't keep asking
+    bool useCopyFileRange_;
+    bool useSendfile_;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace core
+} // namespace odc
+
+#endif
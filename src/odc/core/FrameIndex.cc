@@ -0,0 +1,563 @@
+/*
+ * (C) Copyright 1996-2018 ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <unordered_set>
+
+#include "eckit/exception/Exceptions.h"
+#include "eckit/io/Buffer.h"
+#include "eckit/io/DataHandle.h"
+#include "eckit/log/Log.h"
+
+#include "odc/api/StridedData.h"
+#include "odc/core/Codec.h"
+#include "odc/core/Column.h"
+#include "odc/core/DataStream.h"
+#include "odc/core/DecodeTarget.h"
+#include "odc/core/Exceptions.h"
+#include "odc/core/FrameIndex.h"
+#include "odc/core/Header.h"
+#include "odc/core/MetaData.h"
+#include "odc/core/Table.h"
+#include "odc/core/TablesReader.h"
+#include "odc/ODBAPISettings.h"
+
+using namespace eckit;
+using namespace odc::api;
+
+namespace odc {
+namespace core {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+const char FRAME_INDEX_MAGIC[5] {'\xff', '\xff', 'O', 'D', 'I'};
+const int32_t FRAME_INDEX_VERSION = 3; // 2: Bloom filters, 3: Header hashes
+
+// The fixed part of a frame header, including the MD5 of the rest of the header, fits in this
+const size_t HEADER_HASH_BYTES = 64;
+
+uint64_t mix(uint64_t x) {
+    // The splitmix64 finaliser
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+uint64_t readHeaderHash(DataHandle& dh, const Offset& offset, const Length& length) {
+    char buffer[HEADER_HASH_BYTES];
+    size_t n = std::min(sizeof(buffer), size_t(length));
+    dh.seek(offset);
+    if (dh.read(buffer, n) != long(n)) return 0;
+    return FrameIndex::headerHash(buffer, n);
+}
+
+/// Decode the columns of a table that are needed to count the distinct non-missing values in
+/// each column (constant columns are not decoded), and to build the requested Bloom filters.
+
+void decodeStatistics(Table& table, std::vector<FrameIndex::ColumnStatistics>& stats, bool distinct,
+                      const FrameIndex::BloomOptions& bloom, bool integersAsDoubles) {
+
+    const MetaData& md(table.columns());
+    size_t nrows = table.rowCount();
+    ASSERT(stats.size() == md.size());
+
+    std::set<std::string> names;
+    for (const Column* column : md) {
+        if (!names.insert(column->name()).second) return;
+    }
+
+    std::vector<char> decodeColumn(md.size(), false);
+    std::vector<std::vector<double>> values(md.size());
+    std::vector<std::string> decodeNames;
+    std::vector<StridedData> facades;
+
+    for (size_t i = 0; i < md.size(); ++i) {
+        if (distinct && stats[i].constant()) {
+            stats[i].distinct = (stats[i].hasMissing && stats[i].min == stats[i].missingValue) ? 0 : 1;
+        }
+        if ((distinct && !stats[i].constant()) || bloom.selects(*md[i])) {
+            size_t width = md[i]->dataSizeDoubles();
+            values[i].resize(nrows * width);
+            decodeColumn[i] = true;
+            decodeNames.push_back(md[i]->name());
+            facades.emplace_back(&values[i][0], nrows, width * sizeof(double), width * sizeof(double));
+        }
+    }
+
+    if (decodeNames.empty() || nrows == 0) return;
+
+    DecodeTarget target(decodeNames, std::move(facades));
+    table.decode(target);
+
+    for (size_t i = 0; i < md.size(); ++i) {
+
+        if (!decodeColumn[i]) continue;
+
+        size_t width = md[i]->dataSizeDoubles();
+        double missing = md[i]->missingValue();
+        bool hasMissing = md[i]->hasMissing();
+
+        // Gather the hashes of the distinct values
+
+        std::vector<uint64_t> hashes;
+
+        if (md[i]->type() == STRING) {
+            std::unordered_set<std::string> found;
+            for (size_t row = 0; row < nrows; ++row) {
+                const double* v = &values[i][row * width];
+                if (hasMissing && ::memcmp(v, &missing, sizeof(double)) == 0) continue;
+                const char* s = reinterpret_cast<const char*>(v);
+                if (found.insert(std::string(s, ::strnlen(s, width * sizeof(double)))).second) {
+                    hashes.push_back(FrameIndex::BloomFilter::hash(s, ::strnlen(s, width * sizeof(double))));
+                }
+            }
+        } else {
+            bool asInteger = !integersAsDoubles && (md[i]->type() == INTEGER || md[i]->type() == BITFIELD);
+            std::unordered_set<uint64_t> found;
+            for (size_t row = 0; row < nrows; ++row) {
+                double v = asInteger ? double(reinterpret_cast<const int64_t&>(values[i][row])) : values[i][row];
+                v += 0.0; // n.b. -0.0 == 0.0
+                if (hasMissing && v == missing) continue;
+                uint64_t bits;
+                ::memcpy(&bits, &v, sizeof(bits));
+                if (found.insert(bits).second) hashes.push_back(FrameIndex::BloomFilter::hash(v));
+            }
+        }
+
+        if (distinct && !stats[i].constant()) stats[i].distinct = hashes.size();
+
+        if (bloom.selects(*md[i])) {
+            FrameIndex::BloomFilter filter(hashes.size(), bloom.falsePositiveRate, bloom.maxBytes);
+            for (uint64_t h : hashes) filter.insert(h);
+            stats[i].bloom = std::move(filter);
+        }
+    }
+}
+
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool FrameIndex::BloomOptions::selects(const Column& column) const {
+
+    switch (column.type()) {
+    case INTEGER:
+    case BITFIELD:
+    case STRING:
+        break;
+    default:
+        return false;
+    }
+
+    for (const std::string& name : columns) {
+        if (columnNameMatches(column.name(), name)) return true;
+    }
+    return false;
+}
+
+
+FrameIndex::BloomFilter::BloomFilter() :
+    nhashes(0) {}
+
+
+FrameIndex::BloomFilter::BloomFilter(size_t nvalues, double falsePositiveRate, size_t maxBytes) {
+
+    ASSERT(falsePositiveRate > 0 && falsePositiveRate < 1);
+
+    // The optimal number of bits, and of hash functions, for the given false positive rate
+
+    const double ln2 = std::log(2.0);
+    double nbits = std::ceil(-double(std::max<size_t>(nvalues, 1)) * std::log(falsePositiveRate) / (ln2 * ln2));
+
+    size_t nwords = std::max<size_t>(1, (size_t(nbits) + 63) / 64);
+    if (maxBytes != 0) nwords = std::max<size_t>(1, std::min(nwords, maxBytes / sizeof(uint64_t)));
+
+    bits.resize(nwords, 0);
+    nhashes = std::max(1, std::min(16, int(std::lround(double(nwords * 64) / std::max<size_t>(nvalues, 1) * ln2))));
+}
+
+
+void FrameIndex::BloomFilter::insert(uint64_t hash) {
+
+    ASSERT(!bits.empty());
+    uint64_t nbits = bits.size() * 64;
+    uint64_t h2 = mix(hash) | 1;
+    for (int32_t i = 0; i < nhashes; ++i) {
+        uint64_t bit = (hash + i * h2) % nbits;
+        bits[bit / 64] |= (uint64_t(1) << (bit % 64));
+    }
+}
+
+
+bool FrameIndex::BloomFilter::mayContain(uint64_t hash) const {
+
+    if (bits.empty()) return true;
+    uint64_t nbits = bits.size() * 64;
+    uint64_t h2 = mix(hash) | 1;
+    for (int32_t i = 0; i < nhashes; ++i) {
+        uint64_t bit = (hash + i * h2) % nbits;
+        if (!(bits[bit / 64] & (uint64_t(1) << (bit % 64)))) return false;
+    }
+    return true;
+}
+
+
+uint64_t FrameIndex::BloomFilter::hash(double value) {
+    value += 0.0; // n.b. -0.0 == 0.0
+    uint64_t bits;
+    ::memcpy(&bits, &value, sizeof(bits));
+    return mix(bits);
+}
+
+
+uint64_t FrameIndex::BloomFilter::hash(const char* s, size_t len) {
+
+    while (len > 0 && (s[0] == ' ' || s[0] == '\0')) { ++s; --len; }
+    while (len > 0 && (s[len-1] == ' ' || s[len-1] == '\0')) --len;
+
+    // FNV-1a
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= static_cast<unsigned char>(s[i]);
+        h *= 0x100000001b3ULL;
+    }
+    return mix(h);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+const FrameIndex::ColumnStatistics* FrameIndex::Frame::column(const std::string& name) const {
+
+    const ColumnStatistics* found = nullptr;
+    for (const ColumnStatistics& c : columns) {
+        if (columnNameMatches(c.name, name)) {
+            if (found) return nullptr;
+            found = &c;
+        }
+    }
+    return found;
+}
+
+
+FrameIndex::FrameIndex() :
+    dataSize_(0) {}
+
+
+FrameIndex FrameIndex::build(const PathName& dataFile, bool distinct, size_t nthreads, const BloomOptions& bloom) {
+
+    FrameIndex index;
+    std::vector<Table> tables;
+
+    TablesReader reader(dataFile);
+    for (auto it = reader.begin(); it != reader.end(); ++it) {
+        index.addFrame(it->startPosition(), it->nextPosition() - it->startPosition(), it->rowCount(), it->columns());
+        tables.emplace_back(*it);
+    }
+
+    index.dataSize(dataFile.size());
+
+    if (!index.frames_.empty()) {
+        std::unique_ptr<DataHandle> dh(dataFile.fileHandle());
+        dh->openForRead();
+        AutoClose closer(*dh);
+        for (Frame& frame : index.frames_) {
+            frame.headerHash = readHeaderHash(*dh, frame.offset, frame.length);
+        }
+    }
+
+    if ((distinct || !bloom.columns.empty()) && !tables.empty()) {
+
+        // n.b. The integer codecs were chosen when the tables were read, on this thread
+        const bool integersAsDoubles = ODBAPISettings::instance().integersAsDoubles();
+
+        std::mutex guard_mutex;
+        std::vector<std::future<void>> threads;
+        size_t next_frame = 0;
+
+        nthreads = std::max<size_t>(1, std::min(nthreads, tables.size()));
+        for (size_t i = 0; i < nthreads; i++) {
+            threads.emplace_back(std::async(std::launch::async, [&] {
+                while (true) {
+                    size_t frame;
+
+                    {
+                        std::lock_guard<std::mutex> guard(guard_mutex);
+                        if (next_frame < tables.size()) {
+                            frame = next_frame++;
+                        } else {
+                            return;
+                        }
+                    }
+
+                    decodeStatistics(tables[frame], index.frames_[frame].columns, distinct, bloom, integersAsDoubles);
+                }
+            }));
+        }
+
+        // Waits for the threads. If any exceptions have been thrown, they get thrown into
+        // the main thread here.
+        for (auto& thread : threads) {
+            thread.get();
+        }
+    }
+
+    return index;
+}
+
+
+FrameIndex::Frame& FrameIndex::addFrame(const Offset& offset, const Length& length, size_t rowCount, const MetaData& columns) {
+
+    Frame frame;
+    frame.offset = offset;
+    frame.length = length;
+    frame.rowCount = rowCount;
+    frame.headerHash = 0;
+
+    for (const Column* column : columns) {
+        ColumnStatistics stats;
+        stats.name = column->name();
+        stats.type = column->type();
+        stats.codec = column->coder().name();
+        stats.min = column->min();
+        stats.max = column->max();
+        stats.missingValue = column->missingValue();
+        stats.hasMissing = column->hasMissing();
+        stats.distinct = -1;
+        frame.columns.emplace_back(std::move(stats));
+    }
+
+    frames_.emplace_back(std::move(frame));
+    return frames_.back();
+}
+
+
+PathName FrameIndex::indexPath(const PathName& dataFile) {
+    return dataFile + ".idx";
+}
+
+
+bool FrameIndex::find(const PathName& dataFile, FrameIndex& index) {
+
+    PathName path(indexPath(dataFile));
+    if (!path.exists()) return false;
+
+    // There may be an index of a different kind at this location
+
+    std::unique_ptr<DataHandle> dh(path.fileHandle());
+    dh->openForRead();
+    AutoClose closer(*dh);
+
+    char magic[sizeof(FRAME_INDEX_MAGIC)];
+    if (dh->read(magic, sizeof(magic)) != sizeof(magic) ||
+        ::memcmp(magic, FRAME_INDEX_MAGIC, sizeof(magic)) != 0) return false;
+
+    FrameIndex found(load(path));
+    if (found.dataSize() != dataFile.size()) return false;
+
+    // The frames must still be where the index says, and start with the same headers. Indexes
+    // without header hashes cannot be checked, so are not used.
+
+    std::unique_ptr<DataHandle> data(dataFile.fileHandle());
+    data->openForRead();
+    AutoClose dataCloser(*data);
+
+    long long expected = 0;
+    for (const Frame& frame : found.frames()) {
+        if (frame.headerHash == 0) return false;
+        if ((long long)(frame.offset) != expected ||
+            readHeaderHash(*data, frame.offset, frame.length) != frame.headerHash) {
+            Log::warning() << "Frame index " << path << " does not match " << dataFile << ", ignoring it" << std::endl;
+            return false;
+        }
+        expected += (long long)(frame.length);
+    }
+
+    if (expected != (long long)(dataFile.size())) return false;
+
+    std::swap(index, found);
+    return true;
+}
+
+
+uint64_t FrameIndex::headerHash(const void* frame, size_t length) {
+
+    const unsigned char* p = static_cast<const unsigned char*>(frame);
+    length = std::min(length, HEADER_HASH_BYTES);
+
+    // FNV-1a
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < length; ++i) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+
+    h = mix(h);
+    return h ? h : 1;
+}
+
+
+FrameIndex FrameIndex::load(const PathName& indexFile) {
+
+    Length size = indexFile.size();
+    Buffer buffer(size);
+
+    std::unique_ptr<DataHandle> dh(indexFile.fileHandle());
+    dh->openForRead();
+    AutoClose closer(*dh);
+    if (dh->read(buffer, size) != long(size)) throw ODBIncomplete(indexFile.asString(), Here());
+
+    if (size_t(size) < sizeof(FRAME_INDEX_MAGIC) + sizeof(int32_t) ||
+        ::memcmp(buffer, FRAME_INDEX_MAGIC, sizeof(FRAME_INDEX_MAGIC)) != 0) {
+        throw ODBInvalid(indexFile.asString(), "Not a frame index", Here());
+    }
+
+    int32_t byteOrder;
+    ::memcpy(&byteOrder, buffer + sizeof(FRAME_INDEX_MAGIC), sizeof(byteOrder));
+
+    const char* data = buffer + sizeof(FRAME_INDEX_MAGIC) + sizeof(byteOrder);
+    size_t remaining = size_t(size) - sizeof(FRAME_INDEX_MAGIC) - sizeof(byteOrder);
+
+    FrameIndex index;
+    if (byteOrder != BYTE_ORDER_INDICATOR) {
+        index.load<OtherByteOrder>(data, remaining);
+    } else {
+        index.load<SameByteOrder>(data, remaining);
+    }
+    return index;
+}
+
+
+template <typename ByteOrder>
+void FrameIndex::load(const void* data, size_t size) {
+
+    DataStream<ByteOrder> ds(data, size);
+
+    int32_t version;
+    ds.read(version);
+    if (version > FRAME_INDEX_VERSION) throw UserError("Frame index version not supported", Here());
+
+    int64_t dataSize;
+    ds.read(dataSize);
+    dataSize_ = dataSize;
+
+    int64_t nframes;
+    ds.read(nframes);
+    frames_.resize(nframes);
+
+    for (Frame& frame : frames_) {
+
+        int64_t offset;
+        int64_t length;
+        int64_t rowCount;
+        int64_t headerHash = 0;
+        int32_t ncols;
+        ds.read(offset);
+        ds.read(length);
+        ds.read(rowCount);
+        if (version >= 3) ds.read(headerHash);
+        ds.read(ncols);
+
+        frame.offset = offset;
+        frame.length = length;
+        frame.rowCount = rowCount;
+        frame.headerHash = headerHash;
+        frame.columns.resize(ncols);
+
+        for (ColumnStatistics& stats : frame.columns) {
+            int32_t type;
+            int32_t hasMissing;
+            int64_t distinct;
+            ds.read(stats.name);
+            ds.read(type);
+            ds.read(stats.codec);
+            ds.read(stats.min);
+            ds.read(stats.max);
+            ds.read(stats.missingValue);
+            ds.read(hasMissing);
+            ds.read(distinct);
+            if (version >= 2) {
+                ds.read(stats.bloom.nhashes);
+                ds.read(stats.bloom.bits);
+            }
+            stats.type = static_cast<ColumnType>(type);
+            stats.hasMissing = hasMissing;
+            stats.distinct = distinct;
+        }
+    }
+}
+
+
+void FrameIndex::save(const PathName& indexFile) const {
+
+    // As with the frame headers, grow the buffer until the index fits
+
+    Buffer buffer(64 * 1024);
+    size_t size = 0;
+
+    while (true) {
+        try {
+            DataStream<SameByteOrder> ds(buffer);
+
+            ds.writeBytes(FRAME_INDEX_MAGIC, sizeof(FRAME_INDEX_MAGIC));
+            ds.write(BYTE_ORDER_INDICATOR);
+            ds.write(FRAME_INDEX_VERSION);
+            ds.write(static_cast<int64_t>(dataSize_));
+            ds.write(static_cast<int64_t>(frames_.size()));
+
+            for (const Frame& frame : frames_) {
+                ds.write(static_cast<int64_t>(frame.offset));
+                ds.write(static_cast<int64_t>(frame.length));
+                ds.write(static_cast<int64_t>(frame.rowCount));
+                ds.write(static_cast<int64_t>(frame.headerHash));
+                ds.write(static_cast<int32_t>(frame.columns.size()));
+
+                for (const ColumnStatistics& stats : frame.columns) {
+                    ds.write(stats.name);
+                    ds.write(static_cast<int32_t>(stats.type));
+                    ds.write(stats.codec);
+                    ds.write(stats.min);
+                    ds.write(stats.max);
+                    ds.write(stats.missingValue);
+                    ds.write(static_cast<int32_t>(stats.hasMissing));
+                    ds.write(static_cast<int64_t>(stats.distinct));
+                    ds.write(stats.bloom.nhashes);
+                    ds.write(stats.bloom.bits);
+                }
+            }
+
+            size = ds.position();
+            break;
+
+        } catch (ODBEndOfDataStream& e) {
+            buffer = Buffer(buffer.size() * 2);
+        }
+    }
+
+    std::unique_ptr<DataHandle> dh(indexFile.fileHandle());
+    dh->openForWrite(size);
+    AutoClose closer(*dh);
+    ASSERT(dh->write(buffer, size) == long(size));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace core
+} // namespace odc
@@ -0,0 +1,150 @@
+/*
+ * (C) Copyright 1996-2018 ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+#ifndef odc_core_FrameIndex_H
+#define odc_core_FrameIndex_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "eckit/filesystem/PathName.h"
+#include "eckit/io/Length.h"
+#include "eckit/io/Offset.h"
+
+#include "odc/api/ColumnType.h"
+
+namespace odc {
+namespace core {
+
+class Column;
+class MetaData;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/// An index of the frames in an ODB file, stored alongside it (by default as <file>.idx). For
+/// each frame it records the position, size and row count, and statistics of every column.
+///
+/// This permits a reader to select the frames of interest, and to seek directly to them,
+/// without reading (or verifying) the headers of the frames it skips.
+
+class FrameIndex {
+
+public: // types
+
+    /// A Bloom filter over the (non-missing) values of a column in a frame. Numbers are hashed by
+    /// value, so the filter may be probed with a double irrespective of the column type. Strings
+    /// are hashed with any leading and trailing blanks (and NULs) removed.
+
+    struct BloomFilter {
+        std::vector<uint64_t> bits;
+        int32_t nhashes;
+
+        BloomFilter();
+
+        /// Size the filter to hold nvalues distinct values with (approximately) the given false
+        /// positive rate. If the size is limited by maxBytes, the false positive rate is higher.
+        BloomFilter(size_t nvalues, double falsePositiveRate, size_t maxBytes=0);
+
+        bool empty() const { return bits.empty(); }
+
+        void insert(uint64_t hash);
+        bool mayContain(uint64_t hash) const;
+
+        static uint64_t hash(double value);
+        static uint64_t hash(const char* s, size_t len);
+    };
+
+    /// Which columns get Bloom filters, and how large they are
+    struct BloomOptions {
+        std::vector<std::string> columns;
+        double falsePositiveRate = 0.01;
+        size_t maxBytes = 0; // 0 --> unlimited
+
+        /// Bloom filters are only built for the selected integer and string columns
+        bool selects(const Column& column) const;
+    };
+
+    struct ColumnStatistics {
+        std::string name;
+        api::ColumnType type;
+        std::string codec;
+        double min;
+        double max;
+        double missingValue;
+        bool hasMissing;
+        long long distinct; // Number of distinct non-missing values. -1 if not known.
+        BloomFilter bloom;  // Empty if not requested for this column
+
+        /// If constant, all the values in the frame are equal to min
+        bool constant() const { return codec == "constant" || codec == "constant_string"; }
+    };
+
+    struct Frame {
+        eckit::Offset offset;
+        eckit::Length length;
+        size_t rowCount;
+        uint64_t headerHash; // See headerHash(). 0 if not known
+        std::vector<ColumnStatistics> columns;
+
+        /// Returns null if the column is absent, or the name is ambiguous
+        const ColumnStatistics* column(const std::string& name) const;
+    };
+
+public: // methods
+
+    FrameIndex();
+
+    /// Index an existing file. The statistics are taken from the frame headers. Counting the
+    /// distinct values, and building Bloom filters, requires the frames to be decoded, which is done
+    /// on up to nthreads threads.
+    static FrameIndex build(const eckit::PathName& dataFile, bool countDistinct=true, size_t nthreads=1,
+                            const BloomOptions& bloom=BloomOptions());
+
+    static FrameIndex load(const eckit::PathName& indexFile);
+    void save(const eckit::PathName& indexFile) const;
+
+    /// The conventional location of the index for a data file
+    static eckit::PathName indexPath(const eckit::PathName& dataFile);
+
+    /// Load the index of a data file from its conventional location. Returns false if there is
+    /// no frame index there, or if it does not match the data file. The start of the header of
+    /// each frame is checked against the index, which is cheap compared to reading the headers.
+    static bool find(const eckit::PathName& dataFile, FrameIndex& index);
+
+    /// A hash of the start of a frame, which includes the MD5 of its header (and so changes
+    /// whenever the metadata recorded in the index does)
+    static uint64_t headerHash(const void* frame, size_t length);
+
+    /// Append a frame, with the statistics held in the column codecs
+    Frame& addFrame(const eckit::Offset& offset, const eckit::Length& length, size_t rowCount, const MetaData& columns);
+
+    const std::vector<Frame>& frames() const { return frames_; }
+
+    /// The size of the data file that was indexed
+    eckit::Length dataSize() const { return dataSize_; }
+    void dataSize(const eckit::Length& size) { dataSize_ = size; }
+
+private: // methods
+
+    template <typename ByteOrder> void load(const void* data, size_t size);
+
+private: // members
+
+    eckit::Length dataSize_;
+    std::vector<Frame> frames_;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace core
+} // namespace odc
+
+#endif
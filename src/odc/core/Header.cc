@@ -131,6 +131,61 @@ void Header::loadAfterMagic(DataHandle& dh) {
     }
 }
 
+template <typename ByteOrder>
+void Header::peek(DataHandle& dh, size_t& rowsNumber, size_t& frameSize) {
+
+    // The basic header, as in load(), followed by the sizes at the start of the variable part
+
+    constexpr size_t basic_header_size = 12 + 32 + 4;
+    constexpr size_t peek_size = basic_header_size + 8 + 8 + 8;
+    char buffer[peek_size];
+
+    if (dh.read(buffer, sizeof(buffer)) != sizeof(buffer)) throw ODBIncomplete(dh.title(), Here());
+
+    DataStream<ByteOrder> ds(buffer, sizeof(buffer));
+
+    int32_t formatVersionMajor;
+    ds.read(formatVersionMajor);
+    ASSERT("File format version not supported" && formatVersionMajor <= FORMAT_VERSION_NUMBER_MAJOR);
+
+    int32_t formatVersionMinor;
+    ds.read(formatVersionMinor);
+    ASSERT("File format version not supported" && formatVersionMinor <= FORMAT_VERSION_NUMBER_MINOR && formatVersionMinor > 3);
+
+    std::string headerDigest;
+    ds.read(headerDigest);
+
+    int32_t headerSize;
+    ds.read(headerSize);
+
+    int64_t nextFrameOffset;
+    ds.read(nextFrameOffset);
+
+    int64_t prevFrameOffset;
+    ds.read(prevFrameOffset);
+    ASSERT(prevFrameOffset == 0);
+
+    int64_t numberOfRows;
+    ds.read(numberOfRows);
+
+    rowsNumber = numberOfRows;
+    frameSize = 5 + sizeof(int32_t) + basic_header_size + headerSize + nextFrameOffset;
+}
+
+void Header::peekAfterMagic(DataHandle& dh, size_t& rowsNumber, size_t& frameSize) {
+
+    int32_t byteOrder;
+    if (dh.read(&byteOrder, sizeof(byteOrder)) != sizeof(byteOrder)) {
+        throw ODBIncomplete(dh.title(), Here());
+    }
+
+    if (byteOrder != BYTE_ORDER_INDICATOR) {
+        peek<OtherByteOrder>(dh, rowsNumber, frameSize);
+    } else {
+        peek<SameByteOrder>(dh, rowsNumber, frameSize);
+    }
+}
+
 namespace {
 
 
@@ -64,6 +64,11 @@ public: // methods
 
     void loadAfterMagic(eckit::DataHandle& dh);
 
+    /// Reads only the fixed size start of a header (following the magic), to obtain the number of
+    /// rows and the total encoded size of the frame. The header digest is not verified, and no
+    /// metadata is loaded. Leaves the DataHandle part way through the header.
+    static void peekAfterMagic(eckit::DataHandle& dh, size_t& rowsNumber, size_t& frameSize);
+
     static std::pair<eckit::Buffer, size_t>
     serializeHeader(size_t dataSize, size_t rowsNumber, const Properties& properties, const MetaData& columns);
 
@@ -73,6 +78,7 @@ public: // methods
 private: // members
 
     template <typename ByteOrder> void load(eckit::DataHandle& dh);
+    template <typename ByteOrder> static void peek(eckit::DataHandle& dh, size_t& rowsNumber, size_t& frameSize);
 
     MetaData& md_;
     Properties& props_;
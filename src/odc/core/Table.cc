@@ -10,8 +10,13 @@
 
 #include "odc/core/Table.h"
 
+#include <algorithm>
 #include <functional>
 #include <bitset>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <set>
 
 #include "eckit/io/AutoCloser.h"
 #include "eckit/io/Buffer.h"
@@ -31,8 +36,306 @@ namespace core {
 
 //----------------------------------------------------------------------------------------------------------------------
 
+namespace {
+
+/// Rows between the checkpoints recorded for decoding row ranges
+const size_t CHECKPOINT_INTERVAL = 1024;
+
+/// Writes the values decoded by a codec (8 bytes: a double, or a 64-bit integer for integer
+/// columns if so configured) into an output column with a requested representation.
+///
+/// Missing values are written as the missing value converted to the output type. Where a narrow
+/// integer type cannot hold it, the largest value of the type is used instead. Values that cannot
+/// be represented, or that would be mistaken for missing values, are an error.
+///
+/// String columns may instead be written as integer codes into a dictionary.
+
+class TypedOutput {
+
+public: // methods
+
+    TypedOutput(const Column& column, api::DecodedType type, size_t dataSize,
+                DecodeTarget::Dictionary* dictionary=nullptr) :
+        type_(type),
+        name_(column.name()),
+        integer_(column.coder().decodesIntegers()),
+        missing_(column.coder().rawMissingValue()),
+        missingInteger_(0),
+        dictionary_(dictionary),
+        widthDoubles_(column.dataSizeDoubles()),
+        string_(column.type() == api::STRING) {
+
+        if (dictionary_) {
+            initDictionary(column, dataSize);
+            return;
+        }
+
+        if (type == api::DECODE_DEFAULT) return;
+
+        bool integerColumn = (column.type() == api::INTEGER || column.type() == api::BITFIELD);
+        bool realColumn = (column.type() == api::REAL || column.type() == api::DOUBLE);
+        bool integerOutput = (type != api::DECODE_FLOAT32 && type != api::DECODE_FLOAT64);
+
+        if (!(integerColumn || (realColumn && !integerOutput)) || int(type) < 0 || int(type) >= api::NUM_DECODED_TYPES) {
+            std::stringstream ss;
+            ss << "Column '" << name_ << "' of type " << Column::columnTypeName(column.type())
+               << " cannot be decoded with output type " << type;
+            throw ODBDecodeError(ss.str(), Here());
+        }
+
+        if (dataSize < api::decodedTypeSize(type)) {
+            std::stringstream ss;
+            ss << "Output elements for column '" << name_ << "' of " << dataSize
+               << " bytes are too small for the requested type";
+            throw ODBDecodeError(ss.str(), Here());
+        }
+
+        switch (type) {
+            case api::DECODE_INT8:  missingInteger_ = integerMissing<int8_t>(); break;
+            case api::DECODE_INT16: missingInteger_ = integerMissing<int16_t>(); break;
+            case api::DECODE_INT32: missingInteger_ = integerMissing<int32_t>(); break;
+            default:                missingInteger_ = static_cast<int64_t>(missing_); break;
+        }
+    }
+
+    bool isDefault() const { return type_ == api::DECODE_DEFAULT && !dictionary_; }
+
+    /// Decode the next value from the codec into the output. Returns the (first 8 bytes of the)
+    /// value as decoded by the codec.
+    double decode(Codec& codec, char* out) {
+        double value = 0;
+        if (dictionary_) {
+            if (!codes_.empty()) {
+                storeCode(codes_[codec.decodeCode()], out);
+            } else {
+                codec.decode(&buffer_[0]);
+                storeString(&buffer_[0], out);
+            }
+        } else {
+            codec.decode(&value);
+            store(value, out);
+        }
+        return value;
+    }
+
+    /// Is a value, as decoded by the codec, missing? Strings are never missing.
+    bool isMissing(const double& raw) const {
+        return !string_ && value(raw) == missing_;
+    }
+
+    /// Store a value already decoded by the codec (dataSizeDoubles wide)
+    void store(const double* decoded, char* out) {
+        if (dictionary_) {
+            storeString(decoded, out);
+        } else {
+            store(*decoded, out);
+        }
+    }
+
+    void store(const double& raw, char* out) const {
+        switch (type_) {
+            case api::DECODE_INT8:    storeInteger<int8_t>(raw, out); break;
+            case api::DECODE_INT16:   storeInteger<int16_t>(raw, out); break;
+            case api::DECODE_INT32:   storeInteger<int32_t>(raw, out); break;
+            case api::DECODE_INT64:   storeInteger<int64_t>(raw, out); break;
+            case api::DECODE_FLOAT32: storeValue<float>(static_cast<float>(value(raw)), out); break;
+            case api::DECODE_FLOAT64: storeValue<double>(value(raw), out); break;
+            default:
+                ::memcpy(out, &raw, sizeof(raw));
+        }
+    }
+
+    /// n.b. Dictionary codes are not written, as the first row always overwrites them
+    void storeMissing(char* out) const {
+        if (dictionary_) return;
+        double raw = missing_;
+        if (integer_) {
+            int64_t ivalue = static_cast<int64_t>(missing_);
+            ::memcpy(&raw, &ivalue, sizeof(raw));
+        }
+        store(raw, out);
+    }
+
+private: // methods
+
+    void initDictionary(const Column& column, size_t dataSize) {
+
+        if (column.type() != api::STRING ||
+                (type_ != api::DECODE_DEFAULT && type_ != api::DECODE_INT8 && type_ != api::DECODE_INT16 &&
+                 type_ != api::DECODE_INT32 && type_ != api::DECODE_INT64)) {
+            std::stringstream ss;
+            ss << "Column '" << name_ << "' of type " << Column::columnTypeName(column.type())
+               << " cannot be decoded as dictionary codes with output type " << type_;
+            throw ODBDecodeError(ss.str(), Here());
+        }
+
+        if (dataSize < api::decodedTypeSize(type_)) {
+            std::stringstream ss;
+            ss << "Output elements for column '" << name_ << "' of " << dataSize
+               << " bytes are too small for the requested type";
+            throw ODBDecodeError(ss.str(), Here());
+        }
+
+        // Where the codec has a dictionary, map its codes onto the merged dictionary once. Otherwise
+        // (e.g. constant strings) look the decoded strings up.
+
+        Codec& codec(column.coder());
+        if (codec.hasDictionary()) codes_ = dictionary_->merge(codec.dictionary());
+        buffer_.resize(widthDoubles_);
+    }
+
+    void storeString(const double* decoded, char* out) {
+        const char* s = reinterpret_cast<const char*>(decoded);
+        std::string value(s, ::strnlen(s, widthDoubles_ * sizeof(double)));
+        auto it = lookup_.find(value);
+        if (it == lookup_.end()) it = lookup_.emplace(value, dictionary_->code(value)).first;
+        storeCode(it->second, out);
+    }
+
+    void storeCode(int64_t code, char* out) const {
+        switch (type_) {
+            case api::DECODE_INT8:  storeCodeAs<int8_t>(code, out); break;
+            case api::DECODE_INT16: storeCodeAs<int16_t>(code, out); break;
+            case api::DECODE_INT32: storeCodeAs<int32_t>(code, out); break;
+            default:                storeValue<int64_t>(code, out); break;
+        }
+    }
+
+    template <typename T>
+    void storeCodeAs(int64_t code, char* out) const {
+        if (code > std::numeric_limits<T>::max()) {
+            std::stringstream ss;
+            ss << "Dictionary for column '" << name_ << "' too large for the requested type";
+            throw ODBDecodeError(ss.str(), Here());
+        }
+        storeValue<T>(static_cast<T>(code), out);
+    }
+
+    template <typename T>
+    int64_t integerMissing() const {
+        if (missing_ >= std::numeric_limits<T>::min() && missing_ <= std::numeric_limits<T>::max()) {
+            return static_cast<int64_t>(missing_);
+        }
+        return std::numeric_limits<T>::max();
+    }
+
+    double value(const double& raw) const {
+        if (!integer_) return raw;
+        int64_t ivalue;
+        ::memcpy(&ivalue, &raw, sizeof(ivalue));
+        return static_cast<double>(ivalue);
+    }
+
+    /// Only integer columns are written into integer outputs, so the values are integral
+    template <typename T>
+    void storeInteger(const double& raw, char* out) const {
+        double v = value(raw);
+        int64_t result;
+        if (v == missing_) {
+            result = missingInteger_;
+        } else {
+            result = static_cast<int64_t>(v);
+            if (result < std::numeric_limits<T>::min() || result > std::numeric_limits<T>::max() ||
+                    result == missingInteger_) {
+                std::stringstream ss;
+                ss << "Value " << result << " in column '" << name_ << "' cannot be represented in the requested type";
+                throw ODBDecodeError(ss.str(), Here());
+            }
+        }
+        storeValue<T>(static_cast<T>(result), out);
+    }
+
+    template <typename T>
+    static void storeValue(T value, char* out) {
+        ::memcpy(out, &value, sizeof(T));
+    }
+
+private: // members
+
+    api::DecodedType type_;
+    std::string name_;
+    bool integer_;
+    double missing_;
+    int64_t missingInteger_;
+
+    DecodeTarget::Dictionary* dictionary_;
+    size_t widthDoubles_;
+    bool string_;
+    std::vector<int64_t> codes_;             // Codec dictionary code --> merged code
+    std::map<std::string, int64_t> lookup_;  // Decoded string --> merged code
+    std::vector<double> buffer_;
+};
+
+/// Pack the validity of a sequence of rows into a bitmap. Bytes that are only partly covered may be
+/// shared with other (concurrently decoded) tables, so are updated under the lock.
+
+void writeValidity(const api::ValidityBitmap& bitmap, const std::vector<char>& valid, std::mutex& mutex) {
+
+    size_t first = bitmap.offset();
+    size_t last = first + valid.size();
+    if (first == last) return;
+
+    unsigned char* data = bitmap.data();
+
+    for (size_t byte = first / 8; byte <= (last - 1) / 8; ++byte) {
+
+        size_t lo = std::max(first, byte * 8);
+        size_t hi = std::min(last, (byte + 1) * 8);
+
+        unsigned char bits = 0;
+        unsigned char mask = 0;
+        for (size_t bit = lo; bit < hi; ++bit) {
+            mask |= (1 << (bit % 8));
+            if (valid[bit - first]) bits |= (1 << (bit % 8));
+        }
+
+        if (mask == 0xff) {
+            data[byte] = bits;
+        } else {
+            std::lock_guard<std::mutex> lock(mutex);
+            data[byte] = (data[byte] & ~mask) | bits;
+        }
+    }
+}
+
+std::vector<TypedOutput> typedOutputs(const MetaData& metadata, const DecodeTarget& target,
+                                      const std::vector<char>& visitColumn,
+                                      const std::vector<api::StridedData*>& facades,
+                                      const std::vector<size_t>& targetColumns) {
+
+    std::vector<TypedOutput> outputs;
+    outputs.reserve(metadata.size());
+    for (size_t col = 0; col < metadata.size(); ++col) {
+        if (visitColumn[col]) {
+            size_t i = targetColumns[col];
+            outputs.emplace_back(*metadata[col], target.types()[i], facades[col]->dataSize(), target.dictionary(i));
+        } else {
+            outputs.emplace_back(*metadata[col], api::DECODE_DEFAULT, 0);
+        }
+    }
+    return outputs;
+}
+
+}
+
+/// The state needed to start decoding at a row: the position of its start-column marker in the
+/// encoded data, and the values carried forward from the previous row for every column.
+
+struct Table::Checkpoints {
+
+    struct Checkpoint {
+        size_t offset;
+        std::vector<double> values;
+    };
+
+    std::mutex mutex;
+    std::vector<Checkpoint> checkpoints; // checkpoints[i] is at row i * CHECKPOINT_INTERVAL
+};
+
+
 Table::Table(const ThreadSharedDataHandle& dh) :
-    dh_(dh) {}
+    dh_(dh),
+    checkpoints_(std::make_shared<Checkpoints>()) {}
 
 Offset Table::startPosition() const {
     return startPosition_;
@@ -117,19 +420,19 @@ const std::map<std::string, size_t>&Table::simpleColumnLookup() {
 }
 
 
-void Table::decode(DecodeTarget& target) {
+void Table::resolveTarget(DecodeTarget& target, size_t nrows, std::vector<char>& visitColumn,
+                          std::vector<api::StridedData*>& facades, std::vector<size_t>& targetColumns) {
 
-    const MetaData& metadata(columns());
-    size_t nrows = metadata.rowsNumber();
-    size_t ncols = metadata.size();
+    size_t ncols = columns().size();
 
     const std::map<std::string, size_t>& columnLookup(this->columnLookup());
     const std::map<std::string, size_t>& lookupSimple(simpleColumnLookup());
 
     // Loop over the specified output columns, and select the correct ones for decoding.
 
-    std::vector<char> visitColumn(ncols, false);
-    std::vector<api::StridedData*> facades(ncols, 0); // TODO: Do we want to do a copy, rather than point to StridedData*?
+    visitColumn.assign(ncols, false);
+    facades.assign(ncols, 0); // TODO: Do we want to do a copy, rather than point to StridedData*?
+    targetColumns.assign(ncols, 0);
 
     ASSERT(target.columns().size() == target.dataFacades().size());
     ASSERT(target.columns().size() <= ncols);
@@ -154,8 +457,33 @@ void Table::decode(DecodeTarget& target) {
 
         visitColumn[pos] = true;
         facades[pos] = &target.dataFacades()[i];
+        targetColumns[pos] = i;
         ASSERT(target.dataFacades()[i].nelem() >= nrows);
     }
+}
+
+
+void Table::decode(DecodeTarget& target) {
+
+    const MetaData& metadata(columns());
+    size_t nrows = metadata.rowsNumber();
+    size_t ncols = metadata.size();
+
+    std::vector<char> visitColumn;
+    std::vector<api::StridedData*> facades;
+    std::vector<size_t> targetColumns;
+    resolveTarget(target, nrows, visitColumn, facades, targetColumns);
+    std::vector<TypedOutput> outputs(typedOutputs(metadata, target, visitColumn, facades, targetColumns));
+
+    // Columns for which the validity of each row is also recorded
+
+    std::vector<size_t> validityColumns;
+    for (size_t col = 0; col < ncols; ++col) {
+        if (visitColumn[col] && target.validity()[targetColumns[col]]) validityColumns.push_back(col);
+    }
+    std::vector<std::vector<char>> valid(ncols);
+    std::vector<char> currentValid(ncols, false);
+    for (size_t col : validityColumns) valid[col].resize(nrows);
 
     // Read the data in in bulk for this table
 
@@ -182,7 +510,11 @@ void Table::decode(DecodeTarget& target) {
 
     for (int col = 0; col < long(ncols); col++) {
         if (visitColumn[col]) {
-            *reinterpret_cast<double*>((*facades[col])[0]) = decoders[col].get().missingValue();
+            if (outputs[col].isDefault()) {
+                *reinterpret_cast<double*>((*facades[col])[0]) = decoders[col].get().missingValue();
+            } else {
+                outputs[col].storeMissing((*facades[col])[0]);
+            }
         }
     }
 
@@ -207,13 +539,22 @@ void Table::decode(DecodeTarget& target) {
 
         for (int col = startCol; col < long(ncols); col++) {
             if (visitColumn[col]) {
-                decoders[col].get().decode(reinterpret_cast<double*>((*facades[col])[rowCount]));
+                if (outputs[col].isDefault()) {
+                    double* out = reinterpret_cast<double*>((*facades[col])[rowCount]);
+                    decoders[col].get().decode(out);
+                    if (!valid[col].empty()) currentValid[col] = !outputs[col].isMissing(*out);
+                } else {
+                    double raw = outputs[col].decode(decoders[col].get(), (*facades[col])[rowCount]);
+                    if (!valid[col].empty()) currentValid[col] = !outputs[col].isMissing(raw);
+                }
                 lastDecoded[col] = rowCount;
             } else {
                 decoders[col].get().skip();
             }
         }
 
+        for (size_t col : validityColumns) valid[col][rowCount] = currentValid[col];
+
         lastStartCol = startCol;
     }
 
@@ -228,6 +569,199 @@ void Table::decode(DecodeTarget& target) {
             break;
         }
     }
+
+    for (size_t col : validityColumns) {
+        writeValidity(target.validity()[targetColumns[col]], valid[col], target.validityMutex());
+    }
+}
+
+
+void Table::decode(DecodeTarget& target, size_t firstRow, size_t nrows, size_t stride) {
+
+    const MetaData& metadata(columns());
+    size_t ncols = metadata.size();
+
+    ASSERT(stride > 0);
+    if (nrows == 0) return;
+
+    size_t lastRow = firstRow + (nrows - 1) * stride;
+    if (lastRow >= rowCount()) {
+        std::stringstream ss;
+        ss << "Rows up to " << lastRow << " requested from a frame of " << rowCount() << " rows";
+        throw UserError(ss.str(), Here());
+    }
+
+    std::vector<char> visitColumn;
+    std::vector<api::StridedData*> facades;
+    std::vector<size_t> targetColumns;
+    resolveTarget(target, nrows, visitColumn, facades, targetColumns);
+    std::vector<TypedOutput> outputs(typedOutputs(metadata, target, visitColumn, facades, targetColumns));
+
+    std::vector<std::vector<char>> valid(ncols);
+    for (size_t col = 0; col < ncols; ++col) {
+        if (visitColumn[col] && target.validity()[targetColumns[col]]) valid[col].resize(nrows);
+    }
+
+    // The decoding state is held as a row of values for all the columns
+
+    std::vector<size_t> offsets(ncols);
+    std::vector<size_t> widths(ncols);
+    size_t rowSize = 0;
+    for (size_t col = 0; col < ncols; ++col) {
+        offsets[col] = rowSize;
+        widths[col] = metadata[col]->dataSizeDoubles();
+        rowSize += widths[col];
+    }
+
+    std::lock_guard<std::mutex> lock(checkpoints_->mutex);
+    std::vector<Checkpoints::Checkpoint>& checkpoints(checkpoints_->checkpoints);
+
+    if (checkpoints.empty()) {
+        std::vector<double> missing(rowSize);
+        for (size_t col = 0; col < ncols; ++col) missing[offsets[col]] = metadata[col]->coder().missingValue();
+        checkpoints.emplace_back(Checkpoints::Checkpoint{0, std::move(missing)});
+    }
+
+    // Only read the encoded data between the checkpoints around the rows required
+
+    size_t first = std::min(firstRow / CHECKPOINT_INTERVAL, checkpoints.size() - 1);
+    size_t last = (lastRow / CHECKPOINT_INTERVAL) + 1;
+
+    size_t startOffset = checkpoints[first].offset;
+    size_t endOffset = (last < checkpoints.size()) ? checkpoints[last].offset : size_t(dataSize_);
+
+    Buffer readBuffer(endOffset - startOffset);
+    dh_.seek(dataPosition_ + Offset(startOffset));
+    ASSERT(dh_.read(readBuffer, readBuffer.size()) == long(readBuffer.size()));
+
+    std::vector<std::reference_wrapper<Codec>> decoders;
+    decoders.reserve(ncols);
+    for (auto& col : metadata) decoders.push_back(col->coder());
+
+    GeneralDataStream ds;
+    size_t streamOffset = 0;
+
+    std::vector<double> state;
+    size_t row = 0;
+
+    auto restart = [&](size_t checkpoint) {
+        const Checkpoints::Checkpoint& cp(checkpoints[checkpoint]);
+        state = cp.values;
+        row = checkpoint * CHECKPOINT_INTERVAL;
+        streamOffset = cp.offset;
+        ds = GeneralDataStream(otherByteOrder(), static_cast<char*>(readBuffer.data()) + (cp.offset - startOffset),
+                               endOffset - cp.offset);
+        for (Codec& decoder : decoders) decoder.setDataStream(ds);
+    };
+
+    restart(first);
+
+    for (size_t i = 0; i < nrows; ++i) {
+
+        size_t wanted = firstRow + (i * stride);
+
+        // Skip ahead, if there is a checkpoint between here and the next row required
+
+        size_t checkpoint = wanted / CHECKPOINT_INTERVAL;
+        if (checkpoint < checkpoints.size() && checkpoint * CHECKPOINT_INTERVAL > row) restart(checkpoint);
+
+        for (; row <= wanted; ++row) {
+
+            unsigned char marker[2];
+            ds.readBytes(&marker, sizeof(marker));
+            int startCol = (marker[0] * 256) + marker[1]; // Endian independant
+
+            // Values for all the columns are needed to record the checkpoints
+
+            for (size_t col = startCol; col < ncols; ++col) {
+                decoders[col].get().decode(&state[offsets[col]]);
+            }
+
+            if ((row + 1) % CHECKPOINT_INTERVAL == 0 && (row + 1) < rowCount() &&
+                    (row + 1) / CHECKPOINT_INTERVAL == checkpoints.size()) {
+                checkpoints.emplace_back(Checkpoints::Checkpoint{streamOffset + size_t(ds.position()), state});
+            }
+        }
+
+        for (size_t col = 0; col < ncols; ++col) {
+            if (visitColumn[col]) {
+                if (outputs[col].isDefault()) {
+                    ::memcpy((*facades[col])[i], &state[offsets[col]], widths[col] * sizeof(double));
+                } else {
+                    outputs[col].store(&state[offsets[col]], (*facades[col])[i]);
+                }
+                if (!valid[col].empty()) valid[col][i] = !outputs[col].isMissing(state[offsets[col]]);
+            }
+        }
+    }
+
+    for (size_t col = 0; col < ncols; ++col) {
+        if (!valid[col].empty()) {
+            writeValidity(target.validity()[targetColumns[col]], valid[col], target.validityMutex());
+        }
+    }
+}
+
+
+void Table::mergeDictionaries(DecodeTarget& target) {
+
+    std::vector<char> visitColumn;
+    std::vector<api::StridedData*> facades;
+    std::vector<size_t> targetColumns;
+    resolveTarget(target, 0, visitColumn, facades, targetColumns);
+
+    // Constant strings are known from the header. Other strings without a codec dictionary are
+    // only known once decoded, so those columns are decoded here, and their strings merged in row order.
+
+    const MetaData& metadata(columns());
+    std::vector<size_t> decodeColumns;
+
+    for (size_t col = 0; col < metadata.size(); ++col) {
+        if (visitColumn[col]) {
+            DecodeTarget::Dictionary* dictionary = target.dictionary(targetColumns[col]);
+            if (!dictionary) continue;
+            Column& column(*metadata[col]);
+            Codec& codec(column.coder());
+            if (codec.hasDictionary()) {
+                dictionary->merge(codec.dictionary());
+            } else if (column.isConstant()) {
+                double value = column.min();
+                const char* s = reinterpret_cast<const char*>(&value);
+                dictionary->code(std::string(s, ::strnlen(s, sizeof(value))));
+            } else {
+                decodeColumns.push_back(col);
+            }
+        }
+    }
+
+    if (decodeColumns.empty() || rowCount() == 0) return;
+
+    size_t nrows = rowCount();
+    std::vector<std::string> names;
+    std::vector<api::StridedData> facades;
+    std::vector<std::vector<double>> buffers;
+    buffers.reserve(decodeColumns.size());
+    for (size_t col : decodeColumns) {
+        size_t width = metadata[col]->dataSizeDoubles();
+        names.push_back(metadata[col]->name());
+        buffers.emplace_back(nrows * width);
+        facades.emplace_back(&buffers.back()[0], nrows, width * sizeof(double), width * sizeof(double));
+    }
+
+    DecodeTarget strings(names, std::move(facades));
+    decode(strings);
+
+    for (size_t i = 0; i < decodeColumns.size(); ++i) {
+        size_t col = decodeColumns[i];
+        size_t width = metadata[col]->dataSizeDoubles() * sizeof(double);
+        std::vector<std::string> values;
+        values.reserve(nrows);
+        for (size_t row = 0; row < nrows; ++row) {
+            const char* s = reinterpret_cast<const char*>(&buffers[i][0]) + row * width;
+            values.emplace_back(s, ::strnlen(s, width));
+        }
+        target.dictionary(targetColumns[col])->merge(values);
+    }
 }
 
 
@@ -269,69 +803,231 @@ Span Table::span(const std::vector<std::string>& columns, bool onlyConstants) {
 
 // Helper workers to simplify building span decoder
 
+namespace {
+
+/// Spread the bits of a 64-bit value across the hash, so that values differing only in their
+/// high bits (e.g. multiples of a power of two) do not collide in the low bits used as the index.
+
+struct MixHash {
+    size_t operator()(uint64_t v) const {
+        v ^= v >> 33;
+        v *= 0xff51afd7ed558ccdULL;
+        v ^= v >> 33;
+        v *= 0xc4ceb3fe1a85ec53ULL;
+        v ^= v >> 33;
+        return static_cast<size_t>(v);
+    }
+};
+
+/// The distinct values found in a column, held in an open-addressing (linear probing) hash table.
+/// Values are only ordered once, when they are added to the span.
+
+template <typename T, typename Hash>
+class UniqueValues {
+public: // methods
+
+    UniqueValues() : slots_(16), occupied_(16, false), size_(0) {}
+
+    void insert(const T& value) {
+        if (2 * (size_ + 1) > slots_.size()) grow();
+        size_t i = find(value);
+        if (!occupied_[i]) {
+            slots_[i] = value;
+            occupied_[i] = true;
+            ++size_;
+        }
+    }
+
+    template <typename U, typename Fn>
+    std::set<U> sorted(Fn convert) const {
+        std::set<U> values;
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            if (occupied_[i]) values.insert(values.end(), convert(slots_[i]));
+        }
+        return values;
+    }
+
+private: // methods
+
+    size_t find(const T& value) const {
+        size_t mask = slots_.size() - 1;
+        size_t i = Hash()(value) & mask;
+        while (occupied_[i] && !(slots_[i] == value)) i = (i + 1) & mask;
+        return i;
+    }
+
+    void grow() {
+        std::vector<T> slots(slots_.size() * 2);
+        std::vector<char> occupied(slots.size(), false);
+        std::swap(slots, slots_);
+        std::swap(occupied, occupied_);
+        for (size_t i = 0; i < slots.size(); ++i) {
+            if (occupied[i]) {
+                size_t j = find(slots[i]);
+                slots_[j] = std::move(slots[i]);
+                occupied_[j] = true;
+            }
+        }
+    }
+
+private: // members
+
+    std::vector<T> slots_;
+    std::vector<char> occupied_;
+    size_t size_;
+};
+
+/// Each column of the span is decoded in bulk into a buffer (using the columnar decoding of the
+/// table), before the distinct values are picked out of it.
+
 class ColumnValuesBase {
 public: // methods
 
+    ColumnValuesBase(const std::string& name, size_t nrows, size_t widthDoubles) :
+        names_(1, name), widthDoubles_(widthDoubles), buffer_(std::max<size_t>(nrows, 1) * widthDoubles) {}
+
     virtual ~ColumnValuesBase() {}
 
+    /// The same column may be requested under more than one name
+    void addName(const std::string& name) { names_.push_back(name); }
+
+    api::StridedData facade(size_t nrows) {
+        return api::StridedData(&buffer_[0], nrows, widthDoubles_ * sizeof(double), widthDoubles_ * sizeof(double));
+    }
+
+    /// Select the representation into which the column is decoded
+    virtual void configure(DecodeTarget&, size_t) {}
+
+    virtual void addValues(const DecodeTarget& target, size_t column, size_t nrows) = 0;
     virtual void updateSpan(Span& span) = 0;
-    virtual void addValue(double* val) = 0;
+
+protected: // members
+
+    std::vector<std::string> names_;
+    size_t widthDoubles_;
+    std::vector<double> buffer_;
 };
 
+struct IntegerColumnValues : ColumnValuesBase {
 
-template <typename T>
-class ColumnValues : public ColumnValuesBase {
-public: // methods
+    IntegerColumnValues(const std::string& nm, size_t nrows) : ColumnValuesBase(nm, nrows, 1) {}
 
-    ColumnValues(const std::string& name) : name_(name) {}
+    void configure(DecodeTarget& target, size_t column) override { target.type(column, api::DECODE_INT64); }
+
+    void addValues(const DecodeTarget&, size_t, size_t nrows) override {
+        const int64_t* values = reinterpret_cast<const int64_t*>(&buffer_[0]);
+        for (size_t row = 0; row < nrows; ++row) {
+            if (row == 0 || values[row] != values[row-1]) values_.insert(static_cast<uint64_t>(values[row]));
+        }
+    }
 
     void updateSpan(Span& s) override {
-        s.addValues(name_, values_);
+        std::set<long> values(values_.sorted<long>([](uint64_t v) { return static_cast<long>(static_cast<int64_t>(v)); }));
+        for (const std::string& name : names_) s.addValues(name, values);
     }
 
-protected: // members
-    std::string name_;
-    std::set<T> values_;
+    UniqueValues<uint64_t, MixHash> values_;
 };
 
-struct IntegerColumnValues : ColumnValues<long> {
-    using ColumnValues<long>::ColumnValues;
-    void addValue(double* val) override { values_.insert(static_cast<int64_t>(*val)); }
+/// Real values are held by their bit patterns, so that the hashing is exact. Zeros are normalised
+/// so that, as in a std::set<double>, -0.0 and 0.0 are the same value.
+
+struct DoubleColumnValues : ColumnValuesBase {
+
+    DoubleColumnValues(const std::string& nm, size_t nrows) : ColumnValuesBase(nm, nrows, 1) {}
+
+    void addValues(const DecodeTarget&, size_t, size_t nrows) override {
+        uint64_t last = 0;
+        for (size_t row = 0; row < nrows; ++row) {
+            double v = (buffer_[row] == 0) ? 0.0 : buffer_[row];
+            uint64_t bits;
+            ::memcpy(&bits, &v, sizeof(bits));
+            if (row == 0 || bits != last) values_.insert(bits);
+            last = bits;
+        }
+    }
+
+    void updateSpan(Span& s) override {
+        std::set<double> values(values_.sorted<double>([](uint64_t bits) {
+            double v;
+            ::memcpy(&v, &bits, sizeof(v));
+            return v;
+        }));
+        for (const std::string& name : names_) s.addValues(name, values);
+    }
+
+    UniqueValues<uint64_t, MixHash> values_;
 };
 
-struct DoubleColumnValues : ColumnValues<double> {
-    using ColumnValues<double>::ColumnValues;
-    void addValue(double* val) override { values_.insert(*val); }
+struct StringColumnValues : ColumnValuesBase {
+
+    StringColumnValues(const std::string& nm, size_t nrows, size_t widthDoubles) :
+        ColumnValuesBase(nm, nrows, widthDoubles) {}
+
+    void addValues(const DecodeTarget&, size_t, size_t nrows) override {
+        size_t maxLength = widthDoubles_ * sizeof(double);
+        for (size_t row = 0; row < nrows; ++row) {
+            const char* c = reinterpret_cast<const char*>(&buffer_[row * widthDoubles_]);
+            if (row > 0 && ::memcmp(c, c - maxLength, maxLength) == 0) continue;
+            values_.insert(std::string(c, ::strnlen(c, maxLength)));
+        }
+    }
+
+    void updateSpan(Span& s) override {
+        std::set<std::string> values(values_.sorted<std::string>([](const std::string& v) { return v; }));
+        for (const std::string& name : names_) s.addValues(name, values);
+    }
+
+    UniqueValues<std::string, std::hash<std::string>> values_;
 };
 
-struct StringColumnValues : ColumnValues<std::string> {
-    StringColumnValues(const std::string& nm, size_t maxlen) : ColumnValues<std::string>(nm), maxLength_(maxlen) {}
-    void addValue(double* val) override {
-        const char* c = reinterpret_cast<const char*>(val);
-        values_.insert(std::string(c, ::strnlen(c, maxLength_)));
+/// For dictionary-encoded strings we only need to know which codes are used within the
+/// frame. The strings themselves are only looked up once, when the span is built.
+
+struct DictionaryColumnValues : ColumnValuesBase {
+
+    DictionaryColumnValues(const std::string& nm, size_t nrows, size_t maxlen) :
+        ColumnValuesBase(nm, nrows, 1), maxLength_(maxlen) {}
+
+    void configure(DecodeTarget& target, size_t column) override { target.decodeCodes(column); }
+
+    void addValues(const DecodeTarget& target, size_t column, size_t nrows) override {
+        dictionary_ = target.dictionary(column)->strings();
+        used_.assign(dictionary_.size(), false);
+        const int64_t* codes = reinterpret_cast<const int64_t*>(&buffer_[0]);
+        for (size_t row = 0; row < nrows; ++row) used_[codes[row]] = true;
     }
+
+    void updateSpan(Span& s) override {
+        std::set<std::string> values;
+        for (size_t i = 0; i < used_.size(); ++i) {
+            if (used_[i]) {
+                const std::string& str(dictionary_[i]);
+                values.insert(std::string(str.c_str(), ::strnlen(str.c_str(), std::min(str.length(), maxLength_))));
+            }
+        }
+        for (const std::string& name : names_) s.addValues(name, values);
+    }
+
+    std::vector<std::string> dictionary_;
+    std::vector<char> used_;
     size_t maxLength_;
 };
 
+}
 
 
 Span Table::decodeSpan(const std::vector<std::string>& columns) {
 
     const MetaData& metadata(this->columns());
     size_t nrows = metadata.rowsNumber();
-    size_t ncols = metadata.size();
 
     const std::map<std::string, size_t>& columnLookup = this->columnLookup();
     const std::map<std::string, size_t>& lookupSimple = simpleColumnLookup();
 
-    // Store the unique values
-
-    std::vector<std::unique_ptr<ColumnValuesBase>> columnValues(ncols);
+    // Store the unique values, for each column to be decoded
 
-    // Loop over the specified output columns, and select the correct ones for decoding.
-
-    std::vector<char> visitColumn(ncols, false);
-    size_t maxDoublesDecode = 1;
+    std::map<size_t, std::unique_ptr<ColumnValuesBase>> columnValues;
 
     for (const std::string& columnName : columns) {
 
@@ -343,66 +1039,60 @@ Span Table::decodeSpan(const std::vector<std::string>& columns) {
             throw ODBDecodeError(ss.str(), Here());
         }
 
-        visitColumn[it->second] = true;
+        std::unique_ptr<ColumnValuesBase>& values(columnValues[it->second]);
+        if (values) {
+            values->addName(columnName);
+            continue;
+        }
 
         // What do we do with the values?
 
-        switch (metadata[it->second]->type()) {
+        const Column& column(*metadata[it->second]);
+        switch (column.type()) {
         case api::BITFIELD:
         case api::INTEGER:
-            columnValues[it->second].reset(new IntegerColumnValues(columnName));
+            values.reset(new IntegerColumnValues(columnName, nrows));
             break;
         case api::REAL:
         case api::DOUBLE:
-            columnValues[it->second].reset(new DoubleColumnValues(columnName));
+            values.reset(new DoubleColumnValues(columnName, nrows));
             break;
-        case api::STRING:
-            columnValues[it->second].reset(new StringColumnValues(columnName, sizeof(double)*metadata[it->second]->dataSizeDoubles()));
-            maxDoublesDecode = std::max(maxDoublesDecode, metadata[it->second]->dataSizeDoubles());
+        case api::STRING: {
+            if (column.coder().hasDictionary()) {
+                values.reset(new DictionaryColumnValues(columnName, nrows, sizeof(double)*column.dataSizeDoubles()));
+            } else {
+                values.reset(new StringColumnValues(columnName, nrows, column.dataSizeDoubles()));
+            }
             break;
+        }
         default:
             throw SeriousBug("Unexpected type in decoding column: " + columnName, Here());
         };
     }
 
-    // Read the data in in bulk for this table
+    // Decode the columns in bulk for this table
 
-    const Buffer readBuffer(readEncodedData());
-    GeneralDataStream ds(otherByteOrder(), readBuffer);
-
-    std::vector<std::reference_wrapper<Codec>> decoders;
-    decoders.reserve(ncols);
-    for (auto& col : metadata) {
-        decoders.push_back(col->coder());
-        decoders.back().get().setDataStream(ds);
+    std::vector<std::string> targetColumns;
+    std::vector<api::StridedData> facades;
+    for (const auto& kv : columnValues) {
+        targetColumns.push_back(metadata[kv.first]->name());
+        facades.push_back(kv.second->facade(nrows));
     }
 
-    // Do the decoding
+    DecodeTarget target(targetColumns, std::move(facades));
 
-    std::vector<size_t> lastDecoded(ncols, 0);
-    double decodeBuffer[maxDoublesDecode];
-
-    for (size_t rowCount = 0; rowCount < nrows; ++rowCount) {
-
-        unsigned char marker[2];
-        ds.readBytes(&marker, sizeof(marker));
-        int startCol = (marker[0] * 256) + marker[1]; // Endian independant
+    size_t i = 0;
+    for (const auto& kv : columnValues) kv.second->configure(target, i++);
 
-        for (int col = startCol; col < long(ncols); col++) {
-            if (visitColumn[col]) {
-                decoders[col].get().decode(decodeBuffer);
-                columnValues[col]->addValue(decodeBuffer);
-            } else {
-                decoders[col].get().skip();
-            }
-        }
-    }
+    decode(target);
 
     // And add these to the spans
 
     Span s(startPosition(), nextPosition()-startPosition());
-    for (const auto& values : columnValues) {
-        if (values.get()) values->updateSpan(s);
+    i = 0;
+    for (const auto& kv : columnValues) {
+        kv.second->addValues(target, i++, nrows);
+        kv.second->updateSpan(s);
     }
     return s;
 }
@@ -18,6 +18,7 @@
 
 #include "eckit/io/Buffer.h"
 
+#include "odc/api/ColumnType.h"
 #include "odc/core/ThreadSharedDataHandle.h"
 #include "odc/core/MetaData.h"
 #include "odc/core/Span.h"
@@ -59,6 +60,17 @@ public: // methods
 
     void decode(DecodeTarget& target);
 
+    /// Decode nrows rows, starting from firstRow and taking every stride'th row, into the target.
+    /// Checkpoints of the decoding state are recorded as the frame is decoded, so that later
+    /// calls only read and decode the data from the nearest checkpoint before each row required.
+    void decode(DecodeTarget& target, size_t firstRow, size_t nrows, size_t stride=1);
+
+    /// Merge the strings of this table into the dictionaries of the target columns decoded as
+    /// dictionary codes. Merging the tables of a frame in order, before they are decoded in
+    /// parallel, makes the codes independent of the order in which the tables are decoded.
+    /// String columns without a codec dictionary (other than constants) are decoded to do so.
+    void mergeDictionaries(DecodeTarget& target);
+
     Span span(const std::vector<std::string>& columns, bool onlyConstant=false);
     Span decodeSpan(const std::vector<std::string>& columns);
 
@@ -70,6 +82,11 @@ private: // methods
     const std::map<std::string, size_t>& columnLookup();
     const std::map<std::string, size_t>& simpleColumnLookup();
 
+    /// Identify the facade (if any) into which each column is decoded, and the corresponding
+    /// column of the target
+    void resolveTarget(DecodeTarget& target, size_t nrows, std::vector<char>& visitColumn,
+                       std::vector<api::StridedData*>& facades, std::vector<size_t>& targetColumns);
+
 private: // members
 
     ThreadSharedDataHandle dh_;
@@ -88,6 +105,11 @@ private: // members
 
     std::map<std::string, size_t> columnLookup_;
     std::map<std::string, size_t> simpleColumnLookup_;
+
+    // The decoding state at regular intervals through the frame. Shared between copies of the table.
+
+    struct Checkpoints;
+    std::shared_ptr<Checkpoints> checkpoints_;
 };
 
 
@@ -80,17 +80,26 @@ const Table& ReadTablesIterator::operator*() const {
 
 
 TablesReader::TablesReader(DataHandle& dh) :
-    dh_(dh) {}
+    dh_(dh),
+    selectedFrames_(false) {}
 
 
 TablesReader::TablesReader(DataHandle* dh) :
-    dh_(dh) {}
+    dh_(dh),
+    selectedFrames_(false) {}
 
 
 TablesReader::TablesReader(const PathName& path) :
     TablesReader(path.fileHandle()) {}
 
 
+TablesReader::TablesReader(const PathName& path, const std::vector<Offset>& frames) :
+    TablesReader(path.fileHandle()) {
+    selectedFrames_ = true;
+    frames_ = frames;
+}
+
+
 TablesReader::iterator TablesReader::begin() {
     return ReadTablesIterator(*this);
 }
@@ -110,8 +119,15 @@ bool TablesReader::ensureTable(long idx) {
 
     if (idx == long(tables_.size())) {
 
+        Offset nextPosition;
+        if (selectedFrames_) {
+            if (idx == long(frames_.size())) return false;
+            nextPosition = frames_[idx];
+        } else {
+            nextPosition = (tables_.empty() ? Offset(0) : tables_.back()->nextPosition());
+        }
+
         // n.b. Some DataHandles don't implement estimate() --> accept "0"
-        Offset nextPosition = (tables_.empty() ? Offset(0) : tables_.back()->nextPosition());
         ASSERT(nextPosition <= dh_.estimate() || dh_.estimate() == Length(0));
 
         // If the table has been truncated, this is an error, and we cannot read on.
@@ -16,6 +16,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 #include "odc/core/Table.h"
 #include "odc/core/ThreadSharedDataHandle.h"
@@ -86,6 +87,10 @@ public: // methods
     TablesReader(eckit::DataHandle* dh); // n.b. takes ownership
     TablesReader(const eckit::PathName& path);
 
+    /// Read only the frames starting at the given offsets (e.g. selected using a FrameIndex). The
+    /// other frames are skipped without their headers being read.
+    TablesReader(const eckit::PathName& path, const std::vector<eckit::Offset>& frames);
+
     iterator begin();
     iterator end();
 
@@ -104,6 +109,9 @@ private: // members
     std::vector<std::unique_ptr<Table>> tables_;
 
     ThreadSharedDataHandle dh_;
+
+    bool selectedFrames_;
+    std::vector<eckit::Offset> frames_;
 };
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -14,7 +14,14 @@
 /// @author Piotr Kuchta, Oct 2010
 
 #include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <exception>
 #include <fstream>
+#include <future>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 #include "eckit/filesystem/PathName.h"
 #include "eckit/log/Log.h"
@@ -23,6 +30,7 @@
 #include "eckit/types/Types.h"
 
 #include "odc/api/ColumnType.h"
+#include "odc/core/Column.h"
 #include "odc/csv/TextReader.h"
 #include "odc/csv/TextReaderIterator.h"
 #include "odc/LibOdc.h"
@@ -33,6 +41,370 @@ typedef StringTools S;
 
 namespace odc {
 
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+/// The text is read, and parsed, in blocks of (at least) this many bytes
+const size_t TEXT_BLOCK_SIZE = 8 * 1024 * 1024;
+
+/// Blocks are not split into parts smaller than this for parsing in parallel
+const size_t MIN_PART_SIZE = 512 * 1024;
+
+/// Marks a NULL string in the parsed data
+const size_t NULL_STRING = size_t(-1);
+
+inline bool isBlank(char c) { return ::isspace(static_cast<unsigned char>(c)); }
+
+/// As StringTools::trim, without constructing new strings
+inline void trim(const char*& begin, const char*& end) {
+    while (begin != end && isBlank(*begin)) ++begin;
+    while (end != begin && isBlank(end[-1])) --end;
+}
+
+/// As StringTools::unQuote
+inline void unQuote(const char*& begin, const char*& end) {
+    if (end - begin >= 2 && (*begin == '"' || *begin == '\'') && end[-1] == *begin) {
+        ++begin;
+        --end;
+    }
+}
+
+inline bool isNull(const char* begin, const char* end) {
+    return end - begin == 4 &&
+           ::toupper(begin[0]) == 'N' && ::toupper(begin[1]) == 'U' &&
+           ::toupper(begin[2]) == 'L' && ::toupper(begin[3]) == 'L';
+}
+
+}
+
+/// The rows of the text are parsed into numbers, or references to the strings in the text, in
+/// blocks. Each block is split into parts at line boundaries which are parsed concurrently, and
+/// the next block is parsed in the background whilst the rows of the current one are consumed.
+///
+/// The splitting and conversion of the values exactly follows that of std::getline,
+/// StringTools::split and the eckit Translators, so that the rows are unchanged.
+
+class TextReaderIterator::BlockParser : private eckit::NonCopyable {
+
+    struct StringRef {
+        size_t offset;
+        size_t length;
+    };
+
+    struct Part {
+        Part() : nrows(0), endOfData(false) {}
+        size_t nrows;
+        std::vector<double> values;     // nrows x ncols (unused for string columns)
+        std::vector<StringRef> strings; // nrows x nstrings
+        bool endOfData;                 // A line without values ends the input
+        std::exception_ptr error;       // To be thrown when reading beyond the last row
+    };
+
+    struct Block {
+        Block() : last(false) {}
+        std::vector<char> text;
+        std::vector<Part> parts;
+        bool last;
+    };
+
+public: // methods
+
+    BlockParser(std::istream& in, const std::string& delimiter, const core::MetaData& columns) :
+        in_(in),
+        ncols_(columns.size()),
+        nstrings_(0),
+        nthreads_(std::max(1u, std::thread::hardware_concurrency())),
+        part_(0),
+        nextRow_(0),
+        rowsRead_(0),
+        values_(0),
+        strings_(0),
+        text_(0) {
+
+        std::fill(delimiters_, delimiters_ + 256, false);
+        for (char c : delimiter) delimiters_[static_cast<unsigned char>(c)] = true;
+
+        for (const core::Column* column : columns) {
+            types_.push_back(column->type());
+            missingValues_.push_back(column->missingValue());
+            stringIndex_.push_back(column->type() == api::STRING ? nstrings_++ : 0);
+        }
+
+        readAhead();
+    }
+
+    ~BlockParser() {
+        if (parsing_.valid()) parsing_.wait();
+    }
+
+    /// Moves to the next row. Returns false at the end of the data.
+    bool next() {
+
+        while (current_ || pending_) {
+
+            if (!current_) {
+                parsing_.get();
+                current_ = std::move(pending_);
+                part_ = 0;
+                nextRow_ = 0;
+                if (!current_->last) readAhead();
+            }
+
+            while (part_ < current_->parts.size()) {
+
+                const Part& part(current_->parts[part_]);
+
+                if (nextRow_ < part.nrows) {
+                    values_ = &part.values[nextRow_ * ncols_];
+                    strings_ = nstrings_ ? &part.strings[nextRow_ * nstrings_] : 0;
+                    text_ = &current_->text[0];
+                    ++nextRow_;
+                    ++rowsRead_;
+                    return true;
+                }
+
+                if (part.error) rethrow(part.error);
+
+                if (part.endOfData) {
+                    if (parsing_.valid()) parsing_.wait();
+                    current_.reset();
+                    pending_.reset();
+                    return false;
+                }
+
+                ++part_;
+                nextRow_ = 0;
+            }
+
+            current_.reset();
+        }
+
+        return false;
+    }
+
+    /// The values of the current row
+
+    double value(size_t col) const { return values_[col]; }
+
+    bool string(size_t col, const char*& s, size_t& length) const {
+        const StringRef& ref(strings_[stringIndex_[col]]);
+        if (ref.length == NULL_STRING) return false;
+        s = text_ + ref.offset;
+        length = ref.length;
+        return true;
+    }
+
+private: // methods
+
+    /// The parts are parsed without knowing where they start in the input, so the line is only
+    /// known once the preceding rows have been read. n.b. The first line is the header.
+    [[noreturn]] void rethrow(const std::exception_ptr& error) const {
+        try {
+            std::rethrow_exception(error);
+        } catch (const std::exception& e) {
+            std::ostringstream ss;
+            ss << e.what() << " at line " << (rowsRead_ + 2) << " of the input";
+            throw UserError(ss.str(), Here());
+        }
+    }
+
+    /// Read the next block of complete lines, and start parsing it in the background
+    void readAhead() {
+
+        std::unique_ptr<Block> block(new Block);
+        block->text.swap(carry_);
+
+        size_t start = block->text.size();
+
+        while (true) {
+            block->text.resize(start + TEXT_BLOCK_SIZE);
+            in_.read(&block->text[start], TEXT_BLOCK_SIZE);
+            size_t n = in_.gcount();
+            block->text.resize(start + n);
+
+            if (n < TEXT_BLOCK_SIZE) {
+                block->last = true;
+                break;
+            }
+
+            // Carry any incomplete line over into the next block
+
+            size_t end = block->text.size();
+            while (end > start && block->text[end-1] != '\n') --end;
+
+            if (end > start) {
+                carry_.assign(block->text.begin() + end, block->text.end());
+                block->text.resize(end);
+                break;
+            }
+
+            start += n;
+        }
+
+        pending_ = std::move(block);
+        Block* b = pending_.get();
+        parsing_ = std::async(std::launch::async, [this, b] { parse(*b); });
+    }
+
+    void parse(Block& block) const {
+
+        const char* text = block.text.empty() ? 0 : &block.text[0];
+        size_t size = block.text.size();
+
+        size_t nparts = std::max<size_t>(1, std::min(nthreads_, size / MIN_PART_SIZE));
+
+        std::vector<const char*> bounds(1, text);
+        for (size_t i = 1; i < nparts; ++i) {
+            const char* p = std::max(bounds.back(), text + (i * size) / nparts);
+            const char* nl = static_cast<const char*>(::memchr(p, '\n', (text + size) - p));
+            if (!nl) break;
+            bounds.push_back(nl + 1);
+        }
+        bounds.push_back(text + size);
+
+        block.parts.resize(bounds.size() - 1);
+
+        std::vector<std::future<void>> threads;
+        for (size_t i = 1; i < block.parts.size(); ++i) {
+            threads.emplace_back(std::async(std::launch::async, [&, i] {
+                parse(text, bounds[i], bounds[i+1], block.parts[i]);
+            }));
+        }
+        parse(text, bounds[0], bounds[1], block.parts[0]);
+
+        for (auto& thread : threads) {
+            thread.get();
+        }
+    }
+
+    void parse(const char* text, const char* begin, const char* end, Part& part) const {
+
+        std::vector<std::pair<const char*, const char*>> fields;
+        fields.reserve(ncols_ + 1);
+        std::string buffer;
+
+        try {
+
+            while (begin != end) {
+
+                const char* eol = static_cast<const char*>(::memchr(begin, '\n', end - begin));
+                const char* lineBegin = begin;
+                const char* lineEnd = eol ? eol : end;
+                begin = eol ? eol + 1 : end;
+
+                trim(lineBegin, lineEnd);
+
+                // n.b. Consecutive delimiters are treated as one
+
+                fields.clear();
+                for (const char* p = lineBegin; p != lineEnd; ) {
+                    while (p != lineEnd && delimiters_[static_cast<unsigned char>(*p)]) ++p;
+                    if (p == lineEnd) break;
+                    const char* fieldBegin = p;
+                    while (p != lineEnd && !delimiters_[static_cast<unsigned char>(*p)]) ++p;
+                    fields.emplace_back(fieldBegin, p);
+                }
+
+                if (fields.empty()) {
+                    part.endOfData = true;
+                    return;
+                }
+
+                if (fields.size() != ncols_) {
+                    std::ostringstream ss;
+                    ss << "Expected " << ncols_ << " values, found " << fields.size();
+                    throw UserError(ss.str(), Here());
+                }
+
+                part.values.resize(part.values.size() + ncols_);
+                part.strings.resize(part.strings.size() + nstrings_);
+                double* values = &part.values[part.nrows * ncols_];
+                StringRef* strings = nstrings_ ? &part.strings[part.nrows * nstrings_] : 0;
+
+                for (size_t i = 0; i < ncols_; ++i) {
+
+                    const char* b = fields[i].first;
+                    const char* e = fields[i].second;
+                    trim(b, e);
+
+                    bool null = isNull(b, e);
+
+                    switch (types_[i]) {
+
+                    case api::STRING:
+                        if (null) {
+                            strings[stringIndex_[i]] = StringRef{0, NULL_STRING};
+                        } else {
+                            unQuote(b, e);
+                            strings[stringIndex_[i]] = StringRef{size_t(b - text), size_t(e - b)};
+                        }
+                        values[i] = 0;
+                        break;
+
+                    case api::REAL:
+                        values[i] = null ? missingValues_[i]
+                                         : static_cast<double>(Translator<std::string, float>()(buffer.assign(b, e)));
+                        break;
+
+                    case api::DOUBLE:
+                        values[i] = null ? missingValues_[i]
+                                         : Translator<std::string, double>()(buffer.assign(b, e));
+                        break;
+
+                    case api::INTEGER:
+                    case api::BITFIELD:
+                        values[i] = null ? missingValues_[i]
+                                         : static_cast<double>(Translator<std::string, long>()(buffer.assign(b, e)));
+                        break;
+
+                    default:
+                        throw SeriousBug("Unexpected type in column", Here());
+                    }
+                }
+
+                ++part.nrows;
+            }
+
+        } catch (...) {
+            // The row being parsed is not complete
+            part.values.resize(part.nrows * ncols_);
+            part.strings.resize(part.nrows * nstrings_);
+            part.error = std::current_exception();
+        }
+    }
+
+private: // members
+
+    std::istream& in_;
+
+    size_t ncols_;
+    size_t nstrings_;
+    std::vector<api::ColumnType> types_;
+    std::vector<double> missingValues_;
+    std::vector<size_t> stringIndex_;
+    bool delimiters_[256];
+
+    size_t nthreads_;
+
+    std::vector<char> carry_;
+
+    std::unique_ptr<Block> current_;
+    size_t part_;
+    size_t nextRow_;
+    size_t rowsRead_;
+
+    const double* values_;
+    const StringRef* strings_;
+    const char* text_;
+
+    std::unique_ptr<Block> pending_;
+    std::future<void> parsing_;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+
 TextReaderIterator::TextReaderIterator(TextReader &owner)
 : columns_(0),
   lastValues_(0),
@@ -49,6 +421,7 @@ TextReaderIterator::TextReaderIterator(TextReader &owner)
     ASSERT(in_);
 
     parseHeader();
+    parser_.reset(new BlockParser(*in_, delimiter_, columns_));
     next();
 }
 
@@ -68,9 +441,14 @@ TextReaderIterator::TextReaderIterator(TextReader &owner, const PathName& pathNa
     ASSERT(in_);
     ownsF_ = true;
     parseHeader();
+    parser_.reset(new BlockParser(*in_, delimiter_, columns_));
     next();
 }
 
+TextReaderIterator::TextReaderIterator()
+: columns_(0)
+{}
+
 eckit::sql::BitfieldDef TextReaderIterator::parseBitfields(const std::string& c)
 {
     size_t leftBracket (c.find('['));
@@ -196,73 +574,49 @@ bool TextReaderIterator::next()
     if (noMore_)
         return false; 
 
-    std::string line;
-    std::getline(*in_, line);
-    line = S::trim(line);
-    std::vector<std::string> values(S::split(delimiter_, line));
-
-    size_t nCols = values.size();
-    if (nCols == 0)
+    if (!parser_->next())
         return ! (noMore_ = true);
-    ASSERT(nCols == columns().size());
+
+    size_t nCols = columns().size();
 
     for(size_t i = 0; i < nCols; ++i)
     {
-        const std::string& v (S::trim(values[i]));
-        if (S::upper(v) == "NULL") {
+        if (columns()[i]->type() != api::STRING) {
+            lastValues_[columnOffsets_[i]] = parser_->value(i);
+            continue;
+        }
+
+        const char* s;
+        size_t charlen;
+        if (!parser_->string(i, s, charlen)) {
             lastValues_[columnOffsets_[i]] = columns_[i]->missingValue();
-        } else  {
-            api::ColumnType typ ( columns()[i]->type() );
-
-            switch (typ) {
-
-            case api::STRING: {
-                std::string unquoted = S::unQuote(v);
-                size_t charlen = unquoted.length();
-                size_t lenDoubles = charlen > 0 ? (((charlen - 1) / 8) + 1): 1;
-
-                // If the string is bigger than any we have come across before, we need to
-                // resize the buffers to cope for this
-                // TODO: Adjust the writer to be able to easily continue if all we have changed is a column size.
-                if (lenDoubles > columns_[i]->dataSizeDoubles()) {
-
-                    newDataset_ = true;
-                    columns_[i]->dataSizeDoubles(lenDoubles);
-
-                    // Allocate a new buffer, but keep the old data around
-                    double* oldData = lastValues_;
-                    lastValues_ = 0;
-                    initRowBuffer();
-                    ASSERT(oldData);
-                    ::memcpy(lastValues_, oldData, columnOffsets_[i]*sizeof(double));
-                    delete[] oldData;
-                }
+            continue;
+        }
 
-                char* buf = reinterpret_cast<char*>(&lastValues_[columnOffsets_[i]]);
-                lenDoubles = columns_[i]->dataSizeDoubles();
+        size_t lenDoubles = charlen > 0 ? (((charlen - 1) / 8) + 1): 1;
 
-                ::memcpy(buf, &unquoted[0], charlen);
-                ::memset(buf + charlen, 0, (lenDoubles * sizeof(double)) - charlen);
-                break;
-            }
+        // If the string is bigger than any we have come across before, we need to
+        // resize the buffers to cope for this
+        // TODO: Adjust the writer to be able to easily continue if all we have changed is a column size.
+        if (lenDoubles > columns_[i]->dataSizeDoubles()) {
 
-            case api::REAL:
-                lastValues_[columnOffsets_[i]] = static_cast<double>(Translator<std::string, float>()(v));
-                break;
+            newDataset_ = true;
+            columns_[i]->dataSizeDoubles(lenDoubles);
 
-            case api::DOUBLE:
-                lastValues_[columnOffsets_[i]] = Translator<std::string, double>()(v);
-                break;
+            // Allocate a new buffer, but keep the old data around
+            double* oldData = lastValues_;
+            lastValues_ = 0;
+            initRowBuffer();
+            ASSERT(oldData);
+            ::memcpy(lastValues_, oldData, columnOffsets_[i]*sizeof(double));
+            delete[] oldData;
+        }
 
-            case api::INTEGER:
-            case api::BITFIELD:
-                lastValues_[columnOffsets_[i]] = static_cast<double>(Translator<std::string, long>()(v));
-                break;
+        char* buf = reinterpret_cast<char*>(&lastValues_[columnOffsets_[i]]);
+        lenDoubles = columns_[i]->dataSizeDoubles();
 
-            default:
-                throw SeriousBug("Unexpected type in column", Here());
-            }
-        }
+        ::memcpy(buf, s, charlen);
+        ::memset(buf + charlen, 0, (lenDoubles * sizeof(double)) - charlen);
     }
 
     return nCols;
@@ -280,6 +634,9 @@ int TextReaderIterator::close()
 {
     //if (ownsF_ && f) { f->close(); delete f; f = 0; }
 
+    // Stop any parsing in the background before the stream goes away
+    parser_.reset();
+
     if (ownsF_ && in_)
     {
         delete in_;
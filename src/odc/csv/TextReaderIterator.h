@@ -16,6 +16,8 @@
 #ifndef TextReaderIterator_H
 #define TextReaderIterator_H
 
+#include <memory>
+
 #include "odc/IteratorProxy.h"
 #include "odc/core/MetaData.h"
 
@@ -68,6 +70,10 @@ private:
 	void initRowBuffer();
 	void parseHeader();
 
+    /// Splits, and converts, the text following the header in large blocks on multiple threads.
+    class BlockParser;
+    std::unique_ptr<BlockParser> parser_;
+
     core::MetaData columns_;
 	double* lastValues_;
     size_t* columnOffsets_;
@@ -88,7 +94,7 @@ public:
 
 protected:
 	// FIXME:
-    TextReaderIterator(): columns_(0) {}
+    TextReaderIterator();
 
 	friend class odc::TextReader;
 	friend class odc::IteratorProxy<odc::TextReaderIterator, odc::TextReader, const double>;
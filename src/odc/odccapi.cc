@@ -248,6 +248,25 @@ oda_select_iterator_ptr odb_create_select_iterator_from_file(oda_ptr co, const c
     return oda_select_iterator_ptr(iter);
 }
 
+/// Run subsequent selects (without a FROM clause) over the given file. Repeating the same SQL over
+/// files with compatible columns reuses the parsed statement.
+int odb_select_bind(oda_ptr co, const char *filename)
+{
+    Select *o (reinterpret_cast<Select*>(co));
+    PathName path (filename);
+    if (! path.exists())
+        return 2;
+
+    try {
+        o->bind(path);
+    }
+    catch (eckit::Exception& e) {
+        eckit::Log::error() << "Caught exception: " << e << std::endl;
+        return 3;
+    }
+    return 0;
+}
+
 
 int odb_read_iterator_destroy(oda_read_iterator_ptr it)
 {
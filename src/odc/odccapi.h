@@ -76,6 +76,7 @@ oda_ptr odb_select_create(const char *, int *);
 int odb_select_destroy(oda_ptr);
 oda_select_iterator_ptr odb_create_select_iterator(oda_ptr, const char *, int *);
 oda_select_iterator_ptr odb_create_select_iterator_from_file(oda_ptr, const char *, const char *, int *);
+int odb_select_bind(oda_ptr, const char *);
 int odb_select_iterator_destroy(oda_select_iterator_ptr);
 int odb_select_iterator_get_no_of_columns(oda_select_iterator_ptr, int*);
 int odb_select_iterator_get_column_size_doubles(oda_read_iterator_ptr, int, int*);
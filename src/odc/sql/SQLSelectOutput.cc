@@ -18,7 +18,9 @@
 #include "eckit/sql/SQLSelect.h"
 #include "eckit/sql/expression/SQLExpression.h"
 
+#include "odc/core/Exceptions.h"
 #include "odc/sql/SQLSelectOutput.h"
+#include "odc/sql/TODATable.h"
 #include "odc/sql/Types.h"
 
 
@@ -30,15 +32,19 @@ namespace sql {
 
 //----------------------------------------------------------------------------------------------------------------------
 
-// TODO: n.b. We can implement an optimised case if the output buffer matches the buffer in the
-//            innards of the select, which just does a memcpy. It will be a bit messy, but this
-//            is probably the place to do it (although it may rather belong in eckit).
+// n.b. Single-double numeric columns are written directly from eval(), bypassing the
+//      SQLType::output --> outputXXX double dispatch for each value. Where the query only projects
+//      columns of its table (see rowSource()), contiguous runs of such columns are copied straight
+//      from the row buffer of the table with memcpy.
 
 SQLSelectOutput::SQLSelectOutput(bool manageOwnBuffer) :
     out_(0),
     pos_(0),
     end_(0),
     bufferElements_(0),
+    rowSource_(nullptr),
+    rowLayoutVersion_(0),
+    copyLayoutValid_(false),
     count_(0),
     manageOwnBuffer_(manageOwnBuffer),
     isNewDataset_(true),
@@ -59,6 +65,11 @@ void SQLSelectOutput::resetBuffer(double* out, size_t count) {
     ASSERT(bufferElements_ >= requiredBufferSize_);
 }
 
+void SQLSelectOutput::rowSource(const TableRowSource* source) {
+    rowSource_ = source;
+    copyLayoutValid_ = false;
+}
+
 void SQLSelectOutput::print(std::ostream& s) const {
     s << "SQLSelectOutput";
 }
@@ -70,9 +81,30 @@ void SQLSelectOutput::flush() {}
 bool SQLSelectOutput::output(const expression::Expressions& results)
 {
     ASSERT(results.size() == columnSizesDoubles_.size());
+    ASSERT(size_t(end_ - out_) >= requiredBufferSize_);
     pos_ = out_;
+
+    const double* row = nullptr;
+    if (rowSource_ && (row = rowSource_->rowData())) {
+        if (!copyLayoutValid_ || rowLayoutVersion_ != rowSource_->rowLayoutVersion()) updateCopyLayout();
+        for (const CopyRange& range : copyRanges_) {
+            ::memcpy(&out_[range.target], &row[range.source], range.count * sizeof(double));
+        }
+        for (const MissingValuePatch& patch : missingValuePatches_) {
+            if (out_[patch.target] == patch.sourceMissing) out_[patch.target] = patch.targetMissing;
+        }
+    }
+
     for (currentColumn_ = 0; currentColumn_ < columnSizesDoubles_.size(); currentColumn_++) {
-        results[currentColumn_]->output(*this);
+        if (row && copied_[currentColumn_]) {
+            pos_ += columnSizesDoubles_[currentColumn_];
+        } else if (directOutput_[currentColumn_]) {
+            bool missing = false;
+            double x = results[currentColumn_]->eval(missing);
+            *pos_++ = (missing ? missingValues_[currentColumn_] : x);
+        } else {
+            results[currentColumn_]->output(*this);
+        }
     }
     ASSERT(pos_ == end_);
     count_++;
@@ -95,6 +127,58 @@ void SQLSelectOutput::outputNumber(double x, bool missing) {
     *pos_++ = (missing ? missingValues_[currentColumn_] : x);
 }
 
+/// Work out which output columns are (numeric) columns of the source rows, and may be copied directly.
+/// Anything else is evaluated as normal.
+
+void SQLSelectOutput::updateCopyLayout() {
+
+    ASSERT(rowSource_);
+
+    copyRanges_.clear();
+    missingValuePatches_.clear();
+    copied_.assign(columnSizesDoubles_.size(), false);
+
+    const core::MetaData& columns(rowSource_->rowColumns());
+
+    for (size_t i = 0; i < columnSizesDoubles_.size(); ++i) {
+
+        if (!directOutput_[i]) continue;
+
+        size_t idx;
+        try {
+            idx = columns.columnIndex(metaData_[i]->name());
+        } catch (const core::AmbiguousColumnException&) {
+            continue;
+        } catch (const core::ColumnNotFoundException&) {
+            continue;
+        }
+
+        const core::Column& column(*columns[idx]);
+        if (column.type() != metaData_[i]->type() || column.dataSizeDoubles() != 1) continue;
+
+        copied_[i] = true;
+        size_t source = rowSource_->rowDataOffset(idx);
+
+        if (!copyRanges_.empty() &&
+            copyRanges_.back().source + copyRanges_.back().count == source &&
+            copyRanges_.back().target + copyRanges_.back().count == offsets_[i]) {
+            ++copyRanges_.back().count;
+        } else {
+            copyRanges_.push_back(CopyRange{source, offsets_[i], 1});
+        }
+
+        // Evaluation reports a value equal to the source missing value as missing, which is then
+        // output as the target missing value. Reproduce that.
+
+        if (column.hasMissing() && column.missingValue() != missingValues_[i]) {
+            missingValuePatches_.push_back(MissingValuePatch{offsets_[i], column.missingValue(), missingValues_[i]});
+        }
+    }
+
+    rowLayoutVersion_ = rowSource_->rowLayoutVersion();
+    copyLayoutValid_ = true;
+}
+
 // TODO: We can add special missing-value behaviour here --- with user specified missing values!
 
 void SQLSelectOutput::outputReal(double x, bool missing) { outputNumber(x, missing); }
@@ -143,6 +227,9 @@ void SQLSelectOutput::updateTypes(SQLSelect& sql) {
     columnSizesDoubles_.reserve(output.size());
     missingValues_.clear();
     missingValues_.reserve(output.size());
+    directOutput_.clear();
+    directOutput_.reserve(output.size());
+    copyLayoutValid_ = false;
 
     // TODO: What happens here if the metadata/columns change during an odb?
     // --> We need to update this allocation as we go.
@@ -174,6 +261,11 @@ void SQLSelectOutput::updateTypes(SQLSelect& sql) {
         //      with the default encoder.
 
         missingValues_.push_back(metaData_[i]->missingValue());
+
+        // Numeric values occupy exactly one double, and can be written without going through the
+        // type-specific output functions. Strings must be padded, so retain the general path.
+
+        directOutput_.push_back(metaData_[i]->type() != api::STRING && columnSizesDoubles_.back() == 1);
     }
 
     requiredBufferSize_ = std::accumulate(columnSizesDoubles_.begin(), columnSizesDoubles_.end(), 0);
@@ -42,6 +42,8 @@
 namespace odc {
 namespace sql {
 
+class TableRowSource;
+
 //----------------------------------------------------------------------------------------------------------------------
 
 class SQLSelectOutput : public eckit::sql::SQLOutput {
@@ -54,6 +56,10 @@ public: // methods
 
     void resetBuffer(double* out, size_t count);
 
+    /// If the query only projects columns of a table, the values may be copied directly from the
+    /// rows of that table (rather than evaluating each expression). Set to null otherwise.
+    void rowSource(const TableRowSource* source);
+
     // Enable access to the aggregated data from the SelectIterator
 
     const double* data() const { return out_; }
@@ -66,6 +72,7 @@ public: // methods
 private: // utility
 
     void outputNumber(double val, bool missing);
+    void updateCopyLayout();
 
 private: // methods (overrides)
 
@@ -102,6 +109,29 @@ private: // members
     std::vector<size_t> columnSizesDoubles_;
     std::vector<size_t> offsets_;
     std::vector<double> missingValues_;
+    std::vector<char> directOutput_;
+
+    /// Contiguous ranges of numeric columns copied from the source rows, and the columns (copied
+    /// as part of those ranges) for which the source and target missing values differ.
+
+    struct CopyRange {
+        size_t source;
+        size_t target;
+        size_t count;
+    };
+
+    struct MissingValuePatch {
+        size_t target;
+        double sourceMissing;
+        double targetMissing;
+    };
+
+    const TableRowSource* rowSource_;
+    size_t rowLayoutVersion_;
+    bool copyLayoutValid_;
+    std::vector<CopyRange> copyRanges_;
+    std::vector<MissingValuePatch> missingValuePatches_;
+    std::vector<char> copied_;
 
     core::MetaData metaData_;
 
@@ -68,7 +68,9 @@ template <typename READER>
 TODATable<READER>::TODATable(SQLDatabase& owner, const std::string& path, const std::string& name, READER&& oda) :
     SQLTable(owner, path, name),
     oda_(std::move(oda)),
-    readerIterator_(oda_.begin()) {
+    readerIterator_(oda_.begin()),
+    scan_(nullptr),
+    layoutVersion_(0) {
 
     populateMetaData();
 }
@@ -83,11 +85,75 @@ const READER& TODATable<READER>::oda() const {
 }
 
 
+template <typename READER>
+const core::MetaData& TODATable<READER>::inputColumns() const {
+    return inputColumns_;
+}
+
+template <typename READER>
+void TODATable<READER>::rebind(READER&& oda) {
+
+    // n.b. Any scan of the previous input keeps its own reference to the (old) reader iterator.
+
+    oda_ = std::move(oda);
+    readerIterator_ = oda_.begin();
+
+    if (!readerIterator_->columns().compatible(inputColumns_)) {
+        throw UserError("New input is not compatible with the columns of table " + path_, Here());
+    }
+
+    inputColumns_ = readerIterator_->columns();
+    ++layoutVersion_;
+}
+
+template <typename READER>
+const double* TODATable<READER>::rowData() const {
+    return scan_ ? scan_->row()->data() : nullptr;
+}
+
+template <typename READER>
+const core::MetaData& TODATable<READER>::rowColumns() const {
+    ASSERT(scan_);
+    return scan_->row()->columns();
+}
+
+template <typename READER>
+size_t TODATable<READER>::rowDataOffset(size_t i) const {
+    ASSERT(scan_);
+    return scan_->row()->dataOffset(i);
+}
+
+template <typename READER>
+size_t TODATable<READER>::rowLayoutVersion() const {
+    return layoutVersion_;
+}
+
+template <typename READER>
+void TODATable<READER>::scanStarted(const TODATableIterator<READER>* scan) const {
+    scan_ = scan;
+    ++layoutVersion_;
+}
+
+template <typename READER>
+void TODATable<READER>::scanUpdated(const TODATableIterator<READER>* scan) const {
+    if (scan == scan_) ++layoutVersion_;
+}
+
+template <typename READER>
+void TODATable<READER>::scanFinished(const TODATableIterator<READER>* scan) const {
+    if (scan == scan_) {
+        scan_ = nullptr;
+        ++layoutVersion_;
+    }
+}
+
+
 template <typename READER>
 void TODATable<READER>::populateMetaData()
 {
     auto& it(readerIterator_);
 
+    inputColumns_ = it->columns();
     size_t count = it->columns().size();
 
     for(size_t i = 0; i < count; i++)
@@ -24,10 +24,31 @@
 namespace odc {
 namespace sql {
 
+template <typename READER> class TODATableIterator;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/// Access to the row most recently fetched by a scan of a table. An output which only projects
+/// columns of the table can copy their values from here, rather than evaluating each expression.
+
+class TableRowSource {
+public:
+
+    virtual ~TableRowSource() {}
+
+    /// Null if no scan of the table is in progress
+    virtual const double* rowData() const = 0;
+    virtual const core::MetaData& rowColumns() const = 0;
+    virtual size_t rowDataOffset(size_t i) const = 0;
+
+    /// Changes whenever the layout of the rows (the columns, or their offsets) may have changed
+    virtual size_t rowLayoutVersion() const = 0;
+};
+
 //----------------------------------------------------------------------------------------------------------------------
 
 template <typename READER>
-class TODATable : public eckit::sql::SQLTable {
+class TODATable : public eckit::sql::SQLTable, public TableRowSource {
 public:
 
     TODATable(eckit::sql::SQLDatabase& owner, const std::string& path, const std::string& name);
@@ -36,9 +57,31 @@ public:
 
     const READER& oda() const;
 
+    /// The columns of the first frame of the input
+    const core::MetaData& inputColumns() const;
+
+    /// Read from a new input, keeping the SQL columns of the table (and so any statements that
+    /// have been prepared against it). The columns of the new input must be compatible with the
+    /// existing ones (see MetaData::compatible).
+    void rebind(READER&& oda);
+
+    // Access to the current row of the most recently started scan
+
+    virtual const double* rowData() const override;
+    virtual const core::MetaData& rowColumns() const override;
+    virtual size_t rowDataOffset(size_t i) const override;
+    virtual size_t rowLayoutVersion() const override;
+
 private: // methods
 
     void populateMetaData();
+
+    // Called by the iterators as they are created, updated and destroyed
+
+    friend class TODATableIterator<READER>;
+    void scanStarted(const TODATableIterator<READER>* scan) const;
+    void scanUpdated(const TODATableIterator<READER>* scan) const;
+    void scanFinished(const TODATableIterator<READER>* scan) const;
 //    void updateMetaData(const std::vector<SQLColumn*>&);
 
 protected: // methods
@@ -63,6 +106,10 @@ private: // members
 
     // This is a hack. Avoid calling begin() twice on non-seekable DataHandle if possible
     typename READER::iterator readerIterator_;
+    core::MetaData inputColumns_;
+
+    mutable const TODATableIterator<READER>* scan_;
+    mutable size_t layoutVersion_;
 };
 
 //----------------------------------------------------------------------------------------------------------------------
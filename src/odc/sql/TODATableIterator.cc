@@ -63,6 +63,7 @@ TODATableIterator<READER>::TODATableIterator(const TODATable<READER>& parent,
     metadataUpdateCallback_(metadataUpdateCallback),
     firstRow_(true) {
 
+    parent_.scanStarted(this);
     if (it_ != end_) updateMetaData();
 }
 
@@ -72,11 +73,14 @@ void TODATableIterator<READER>::rewind() {
         it_ = const_cast<READER&>(parent_.oda()).begin();
         end_ = parent_.oda().end();
         firstRow_ = true;
+        parent_.scanUpdated(this);
     }
 }
 
 template <typename READER>
-TODATableIterator<READER>::~TODATableIterator() {}
+TODATableIterator<READER>::~TODATableIterator() {
+    parent_.scanFinished(this);
+}
 
 template <typename READER>
 bool TODATableIterator<READER>::next() {
@@ -118,6 +122,8 @@ void TODATableIterator<READER>::updateMetaData() {
         columnsHaveMissing_.push_back(it_->hasMissing(idx));
         columnMissingValues_.push_back(it_->missingValue(idx));
     }
+
+    parent_.scanUpdated(this);
 }
 
 template <typename READER>
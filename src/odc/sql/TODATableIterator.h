@@ -39,6 +39,9 @@ public: // methods
                       const typename READER::iterator& seedIterator);
 	virtual ~TODATableIterator();
 
+    /// The row most recently fetched
+    const typename READER::iterator& row() const { return it_; }
+
 private: // methods (override>
 
     virtual void rewind() override;
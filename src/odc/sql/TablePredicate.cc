@@ -0,0 +1,603 @@
+/*
+ * (C) Copyright 1996-2018 ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#include "eckit/exception/Exceptions.h"
+#include "eckit/utils/Regex.h"
+#include "eckit/utils/StringTools.h"
+
+#include "odc/core/Codec.h"
+#include "odc/core/Column.h"
+#include "odc/core/DecodeTarget.h"
+#include "odc/core/MetaData.h"
+#include "odc/core/Table.h"
+#include "odc/sql/TablePredicate.h"
+
+using namespace odc::api;
+
+namespace odc {
+namespace sql {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+// A minimal tokeniser. It only needs to recognise enough of the SQL grammar to decide whether
+// a query is of the restricted form handled by TablePredicate. Anything it doesn't understand
+// results in an empty token list, and the query is handed over to the SQL engine.
+
+std::vector<std::string> tokenise(const std::string& sql) {
+
+    std::vector<std::string> tokens;
+
+    size_t i = 0;
+    while (i < sql.size()) {
+
+        char c = sql[i];
+
+        if (::isspace(c)) {
+            ++i;
+        } else if (::isalpha(c) || c == '_') {
+            size_t start = i;
+            while (i < sql.size() && (::isalnum(sql[i]) || sql[i] == '_' || sql[i] == '@' || sql[i] == '.')) ++i;
+            tokens.emplace_back(sql.substr(start, i - start));
+        } else if (::isdigit(c) || c == '.' || c == '-' || c == '+') {
+            const char* start = &sql[i];
+            char* end;
+            ::strtod(start, &end);
+            if (end == start) return {};
+            tokens.emplace_back(start, end - start);
+            i += (end - start);
+        } else if (c == '<' || c == '>' || c == '=' || c == '!') {
+            size_t start = i++;
+            if (i < sql.size() && (sql[i] == '=' || (c == '<' && sql[i] == '>'))) ++i;
+            tokens.emplace_back(sql.substr(start, i - start));
+        } else if (c == '\'') {
+            // Keep the quotes, so that strings can be distinguished from identifiers. A doubled
+            // quote is an escaped quote.
+            std::string token(1, c);
+            while (true) {
+                if (++i == sql.size()) return {};
+                if (sql[i] == '\'') {
+                    if (i + 1 < sql.size() && sql[i+1] == '\'') {
+                        ++i;
+                    } else {
+                        break;
+                    }
+                }
+                token += sql[i];
+            }
+            token += sql[i++];
+            tokens.emplace_back(std::move(token));
+        } else if (c == '*' || c == ';' || c == '(' || c == ')' || c == ',') {
+            tokens.emplace_back(1, c);
+            ++i;
+        } else {
+            return {};
+        }
+    }
+
+    return tokens;
+}
+
+bool isKeyword(const std::string& token, const char* keyword) {
+    return eckit::StringTools::lower(token) == keyword;
+}
+
+bool isIdentifier(const std::string& token) {
+    if (token.empty() || !(::isalpha(token[0]) || token[0] == '_')) return false;
+    for (const char* kw : {"select", "from", "where", "and", "or", "not", "in", "is", "null", "between", "like",
+                           "order", "group", "by", "limit", "distinct", "into", "as", "asc", "desc"}) {
+        if (isKeyword(token, kw)) return false;
+    }
+    return true;
+}
+
+bool isNumber(const std::string& token, double& value) {
+    if (token.empty() || ::isalpha(token[0]) || token[0] == '_' || token[0] == '\'') return false;
+    char* end;
+    value = ::strtod(token.c_str(), &end);
+    return *end == '\0';
+}
+
+bool isString(const std::string& token, std::string& value) {
+    if (token.size() < 2 || token.front() != '\'' || token.back() != '\'') return false;
+    value = token.substr(1, token.size() - 2);
+    return true;
+}
+
+/// Parse a number or string value into the condition
+bool parseValue(const std::string& token, std::vector<double>& values, std::vector<std::string>& strings) {
+    double value;
+    std::string s;
+    if (isNumber(token, value)) {
+        values.push_back(value);
+        return true;
+    }
+    if (isString(token, s)) {
+        strings.emplace_back(std::move(s));
+        return true;
+    }
+    return false;
+}
+
+/// Where the padding of a string might matter to the SQL engine's comparisons, leave them to it
+
+bool isPlain(const std::string& s) {
+    for (char c : s) {
+        if (!::isprint(static_cast<unsigned char>(c))) return false;
+    }
+    return s.empty() || !(::isspace(static_cast<unsigned char>(s.front())) || ::isspace(static_cast<unsigned char>(s.back())));
+}
+
+/// The SQL engine matches LIKE patterns as regular expressions. Only handle the patterns that mean
+/// the same whether they are read as basic or extended expressions.
+
+std::shared_ptr<eckit::Regex> compilePattern(const std::string& pattern) {
+    if (!isPlain(pattern) || pattern.find_first_of("+?|(){}\\") != std::string::npos) return nullptr;
+    try {
+        return std::make_shared<eckit::Regex>(pattern);
+    } catch (eckit::Exception&) {
+        return nullptr;
+    }
+}
+
+/// A string from a column, truncated at the width of the column
+std::string columnString(const char* s, size_t length, const core::Column& column) {
+    return std::string(s, ::strnlen(s, std::min(length, column.dataSizeDoubles() * sizeof(double))));
+}
+
+/// The strings that may appear in a column, where its header holds them all
+bool headerStrings(const core::Column& column, std::vector<std::string>& strings) {
+
+    const core::Codec& codec(column.coder());
+
+    if (codec.hasDictionary()) {
+        for (const std::string& s : codec.dictionary()) strings.emplace_back(columnString(s.c_str(), s.size(), column));
+        return true;
+    }
+
+    if (codec.name() == "constant_string") {
+        double value = column.min();
+        strings.emplace_back(columnString(reinterpret_cast<const char*>(&value), sizeof(value), column));
+        return true;
+    }
+
+    return false;
+}
+
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::unique_ptr<TablePredicate> TablePredicate::parse(const std::string& sql) {
+
+    std::vector<std::string> tokens = tokenise(sql);
+    while (!tokens.empty() && tokens.back() == ";") tokens.pop_back();
+
+    if (tokens.size() < 2 || !isKeyword(tokens[0], "select") || tokens[1] != "*") return nullptr;
+
+    std::unique_ptr<TablePredicate> predicate(new TablePredicate);
+    if (tokens.size() == 2) return predicate;
+
+    if (!isKeyword(tokens[2], "where")) return nullptr;
+
+    size_t pos = 3;
+    while (true) {
+
+        if (pos + 3 > tokens.size()) return nullptr;
+
+        Condition condition;
+        condition.column = tokens[pos];
+        const std::string& op(tokens[pos+1]);
+
+        if (!isIdentifier(condition.column)) return nullptr;
+
+        if (isKeyword(op, "in")) {
+
+            condition.op = IN;
+            pos += 2;
+            if (tokens[pos] != "(") return nullptr;
+
+            while (true) {
+                if (++pos >= tokens.size()) return nullptr;
+                if (!parseValue(tokens[pos], condition.values, condition.strings)) return nullptr;
+                if (++pos >= tokens.size()) return nullptr;
+                if (tokens[pos] == ")") break;
+                if (tokens[pos] != ",") return nullptr;
+            }
+            ++pos;
+
+            // Don't try to interpret mixtures of numbers and strings
+            if (!condition.values.empty() && !condition.strings.empty()) return nullptr;
+
+        } else if (isKeyword(op, "like")) {
+
+            std::string pattern;
+            if (!isString(tokens[pos+2], pattern)) return nullptr;
+
+            condition.op = LIKE;
+            condition.strings.push_back(pattern);
+            condition.regex = compilePattern(pattern);
+            pos += 3;
+
+        } else {
+
+            if (!parseValue(tokens[pos+2], condition.values, condition.strings)) return nullptr;
+
+            if (op == "=" || op == "==") condition.op = EQ;
+            else if (op == "<>" || op == "!=") condition.op = NE;
+            else if (op == "<") condition.op = LT;
+            else if (op == "<=") condition.op = LE;
+            else if (op == ">") condition.op = GT;
+            else if (op == ">=") condition.op = GE;
+            else return nullptr;
+
+            if (!condition.strings.empty() && condition.op != EQ && condition.op != NE) return nullptr;
+            pos += 3;
+        }
+
+        predicate->conditions_.emplace_back(std::move(condition));
+
+        if (pos == tokens.size()) break;
+        if (!isKeyword(tokens[pos], "and")) return nullptr;
+        ++pos;
+    }
+
+    return predicate;
+}
+
+
+bool TablePredicate::isProjection(const std::string& sql) {
+
+    std::vector<std::string> tokens = tokenise(sql);
+    while (!tokens.empty() && tokens.back() == ";") tokens.pop_back();
+
+    if (tokens.size() < 2 || !isKeyword(tokens[0], "select")) return false;
+    if (tokens.size() == 2 && tokens[1] == "*") return true;
+
+    // n.b. Names qualified with a '.' may refer to other tables, or to parts of bitfields
+
+    for (size_t pos = 1; pos < tokens.size(); pos += 2) {
+        if (!isIdentifier(tokens[pos]) || tokens[pos].find('.') != std::string::npos) return false;
+        if (pos + 1 < tokens.size() && tokens[pos+1] != ",") return false;
+    }
+
+    return tokens.size() % 2 == 0;
+}
+
+
+TablePredicate::Match TablePredicate::evaluate(const core::Table& table) const {
+
+    if (table.rowCount() == 0) return NONE;
+
+    Match result = ALL;
+    for (const Condition& condition : conditions_) {
+        Match m = evaluate(table, condition);
+        if (m == NONE) return NONE;
+        if (m == SOME) result = SOME;
+    }
+    return result;
+}
+
+
+TablePredicate::Match TablePredicate::evaluate(const core::FrameIndex::Frame& frame) const {
+
+    if (frame.rowCount == 0) return NONE;
+
+    Match result = ALL;
+    for (const Condition& condition : conditions_) {
+        Match m = evaluate(frame, condition);
+        if (m == NONE) return NONE;
+        if (m == SOME) result = SOME;
+    }
+    return result;
+}
+
+
+const core::Column* TablePredicate::findColumn(const core::Table& table, const Condition& condition) {
+
+    const core::Column* column = nullptr;
+    for (const core::Column* c : table.columns()) {
+        if (core::columnNameMatches(c->name(), condition.column)) {
+            if (column) return nullptr;
+            column = c;
+        }
+    }
+    return column;
+}
+
+
+TablePredicate::Match TablePredicate::evaluate(const core::Table& table, const Condition& condition) const {
+
+    // Find the column. If it is absent, or ambiguous, let the SQL engine report/handle it.
+
+    const core::Column* column = findColumn(table, condition);
+    if (!column) return SOME;
+
+    // Conditions on strings are decided if they are decided for every string the column may hold
+
+    if (column->type() == STRING) {
+
+        std::vector<std::string> strings;
+        if (condition.strings.empty() || !headerStrings(*column, strings) || strings.empty()) return SOME;
+
+        Match result = evaluate(condition, strings.front());
+        for (const std::string& s : strings) {
+            if (evaluate(condition, s) != result) return SOME;
+        }
+        return result;
+    }
+
+    return evaluate(condition, column->type(), column->coder().name(), column->hasMissing(),
+                    column->min(), column->max(), column->missingValue());
+}
+
+
+TablePredicate::Match TablePredicate::evaluate(const core::FrameIndex::Frame& frame, const Condition& condition) const {
+
+    const core::FrameIndex::ColumnStatistics* column = frame.column(condition.column);
+    if (!column) return SOME;
+
+    Match m = evaluate(condition, column->type, column->codec, column->hasMissing,
+                       column->min, column->max, column->missingValue);
+    if (m != SOME) return m;
+
+    return evaluate(condition, *column);
+}
+
+
+TablePredicate::Match TablePredicate::evaluate(const Condition& condition, ColumnType type, const std::string& codecName,
+                                               bool hasMissing, double min, double max, double missingValue) {
+
+    // Only rely on the header statistics where they exactly bound the decoded values. Missing values
+    // are excluded from the range, and the short_real codecs lose precision on decode.
+
+    switch (type) {
+    case INTEGER:
+    case REAL:
+    case DOUBLE:
+        break;
+    default:
+        return SOME;
+    }
+
+    if (hasMissing) return SOME;
+    if (codecName == "short_real" || codecName == "short_real2") return SOME;
+    if (!condition.strings.empty()) return SOME;
+
+    if (min > max || min == missingValue || max == missingValue) return SOME;
+
+    if (condition.op == IN) {
+        bool inRange = false;
+        for (double v : condition.values) {
+            if (min == v && max == v) return ALL;
+            if (v >= min && v <= max) inRange = true;
+        }
+        return inRange ? SOME : NONE;
+    }
+
+    ASSERT(condition.values.size() == 1);
+    double v = condition.values[0];
+
+    switch (condition.op) {
+    case EQ:
+        if (v < min || v > max) return NONE;
+        return (min == v && max == v) ? ALL : SOME;
+    case NE:
+        if (min == v && max == v) return NONE;
+        return (v < min || v > max) ? ALL : SOME;
+    case LT:
+        if (min >= v) return NONE;
+        return (max < v) ? ALL : SOME;
+    case LE:
+        if (min > v) return NONE;
+        return (max <= v) ? ALL : SOME;
+    case GT:
+        if (max <= v) return NONE;
+        return (min > v) ? ALL : SOME;
+    case GE:
+        if (max < v) return NONE;
+        return (min >= v) ? ALL : SOME;
+    default:
+        break;
+    }
+
+    return SOME;
+}
+
+
+TablePredicate::Match TablePredicate::evaluate(const Condition& condition, const core::FrameIndex::ColumnStatistics& column) {
+
+    // The Bloom filters can only tell us that a frame contains none of the values
+
+    if (column.bloom.empty()) return SOME;
+    if (condition.op != EQ && condition.op != IN) return SOME;
+
+    using Bloom = core::FrameIndex::BloomFilter;
+
+    if (column.type == STRING) {
+        if (condition.strings.empty()) return SOME;
+        for (const std::string& s : condition.strings) {
+            if (column.bloom.mayContain(Bloom::hash(s.c_str(), s.size()))) return SOME;
+        }
+    } else {
+        if (condition.values.empty()) return SOME;
+        for (double v : condition.values) {
+            // Missing values are not included in the filters
+            if (column.hasMissing && v == column.missingValue) return SOME;
+            if (column.bloom.mayContain(Bloom::hash(v))) return SOME;
+        }
+    }
+
+    return NONE;
+}
+
+TablePredicate::Match TablePredicate::evaluate(const Condition& condition, const std::string& value) {
+
+    if (!isPlain(value)) return SOME;
+
+    switch (condition.op) {
+    case EQ:
+    case NE:
+    case IN: {
+        bool found = false;
+        for (const std::string& s : condition.strings) {
+            if (!isPlain(s)) return SOME;
+            if (s == value) found = true;
+        }
+        if (condition.op == NE) return found ? NONE : ALL;
+        return found ? ALL : NONE;
+    }
+    case LIKE:
+        if (!condition.regex) return SOME;
+        return condition.regex->match(value) ? ALL : NONE;
+    default:
+        break;
+    }
+
+    return SOME;
+}
+
+
+bool TablePredicate::evaluate(const Condition& condition, double v) {
+
+    switch (condition.op) {
+    case EQ: return v == condition.values[0];
+    case NE: return v != condition.values[0];
+    case LT: return v < condition.values[0];
+    case LE: return v <= condition.values[0];
+    case GT: return v > condition.values[0];
+    case GE: return v >= condition.values[0];
+    case IN: return std::find(condition.values.begin(), condition.values.end(), v) != condition.values.end();
+    default:
+        break;
+    }
+
+    throw eckit::SeriousBug("Unexpected operator in numeric condition", Here());
+}
+
+
+bool TablePredicate::selectRows(core::Table& table, std::vector<char>& selected) const {
+
+    size_t nrows = table.rowCount();
+    selected.assign(nrows, true);
+
+    // Find the column of each condition. The numeric columns, and the dictionary encoded strings (as
+    // their codes), are then decoded together in one pass over the table.
+
+    std::vector<const core::Column*> columns;
+    std::vector<std::string> names;
+    std::vector<size_t> decoded(conditions_.size(), size_t(-1));
+
+    for (size_t i = 0; i < conditions_.size(); ++i) {
+
+        const Condition& condition(conditions_[i]);
+        const core::Column* column = findColumn(table, condition);
+        if (!column) return false;
+        columns.push_back(column);
+
+        switch (column->type()) {
+
+        case INTEGER:
+        case REAL:
+        case DOUBLE:
+            // The treatment of missing values is left to the SQL engine
+            if (condition.values.empty()) return false;
+            break;
+
+        case STRING: {
+            if (condition.strings.empty()) return false;
+            std::vector<std::string> strings;
+            if (!headerStrings(*column, strings)) return false;
+
+            if (!column->coder().hasDictionary()) {
+                Match m = evaluate(condition, strings.front());
+                if (m == SOME) return false;
+                if (m == NONE) selected.assign(nrows, false);
+                continue;
+            }
+            break;
+        }
+
+        default:
+            return false;
+        }
+
+        auto it = std::find(names.begin(), names.end(), column->name());
+        decoded[i] = it - names.begin();
+        if (it == names.end()) names.push_back(column->name());
+    }
+
+    if (names.empty()) return true;
+
+    std::vector<std::vector<double>> values(names.size(), std::vector<double>(std::max<size_t>(nrows, 1)));
+    std::vector<StridedData> facades;
+    for (std::vector<double>& v : values) {
+        facades.emplace_back(&v[0], nrows, sizeof(double), sizeof(double));
+    }
+
+    core::DecodeTarget target(names, std::move(facades));
+    for (size_t i = 0; i < conditions_.size(); ++i) {
+        if (decoded[i] == size_t(-1)) continue;
+        if (columns[i]->type() == STRING) {
+            target.decodeCodes(decoded[i]);
+        } else {
+            target.type(decoded[i], DECODE_FLOAT64);
+        }
+    }
+    table.decode(target);
+
+    for (size_t i = 0; i < conditions_.size(); ++i) {
+
+        if (decoded[i] == size_t(-1)) continue;
+
+        const Condition& condition(conditions_[i]);
+        const core::Column& column(*columns[i]);
+        const std::vector<double>& columnValues(values[decoded[i]]);
+
+        if (column.type() != STRING) {
+            double missing = column.coder().rawMissingValue();
+            for (size_t row = 0; row < nrows; ++row) {
+                if (!selected[row]) continue;
+                if (column.hasMissing() && columnValues[row] == missing) return false;
+                selected[row] = evaluate(condition, columnValues[row]);
+            }
+            continue;
+        }
+
+        // Evaluate the condition once for each string in the dictionary, then select the rows by
+        // their codes
+
+        const std::vector<std::string>& dictionary(target.dictionary(decoded[i])->strings());
+        std::vector<char> matches(dictionary.size());
+        for (size_t j = 0; j < dictionary.size(); ++j) {
+            Match m = evaluate(condition, columnString(dictionary[j].c_str(), dictionary[j].size(), column));
+            if (m == SOME) return false;
+            matches[j] = (m == ALL);
+        }
+
+        const int64_t* codes = reinterpret_cast<const int64_t*>(&columnValues[0]);
+        for (size_t row = 0; row < nrows; ++row) {
+            if (selected[row]) selected[row] = matches[codes[row]];
+        }
+    }
+
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace sql
+} // namespace odc
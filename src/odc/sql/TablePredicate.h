@@ -0,0 +1,127 @@
+/*
+ * (C) Copyright 1996-2018 ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+#ifndef odc_sql_TablePredicate_H
+#define odc_sql_TablePredicate_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "odc/api/ColumnType.h"
+#include "odc/core/FrameIndex.h"
+
+namespace eckit { class Regex; }
+
+namespace odc {
+namespace core { class Column; class Table; }
+namespace sql {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/// A restricted view of a filter query, which can be evaluated against the column statistics held
+/// in a frame header (or a frame index). Only queries of the form
+///
+///     select * [where <condition> [and <condition> ...]]
+///
+/// where each condition is one of
+///
+///     <column> <op> <number>
+///     <column> = '<string>'
+///     <column> <> '<string>'
+///     <column> like '<pattern>'
+///     <column> in (<value>, <value>, ...)
+///
+/// are recognised. Anything else (projections, functions, OR, FROM clauses, ...) must go through
+/// the full SQL engine. Conditions on strings are evaluated once for each entry of the dictionary
+/// of a column (or for its constant value), or using Bloom filters from a frame index.
+
+class TablePredicate {
+
+public: // types
+
+    enum Match {
+        NONE,   // No row in the table can satisfy the predicate
+        ALL,    // Every row in the table satisfies the predicate
+        SOME    // The header statistics are not sufficient to decide
+    };
+
+public: // methods
+
+    /// Returns null if the query is not of the restricted form above
+    static std::unique_ptr<TablePredicate> parse(const std::string& sql);
+
+    /// Is the query a plain projection of the columns of its (implicit) table, i.e. of the form
+    ///
+    ///     select * | <column> [, <column> ...]
+    ///
+    /// with no conditions, functions, ordering or FROM clause?
+    static bool isProjection(const std::string& sql);
+
+    Match evaluate(const core::Table& table) const;
+
+    /// Evaluate against the statistics in a frame index, without reading the frame header
+    Match evaluate(const core::FrameIndex::Frame& frame) const;
+
+    /// Select the rows of a table satisfying the predicate, from its columns decoded in a single pass.
+    /// Conditions on dictionary encoded strings are evaluated once per entry of the dictionary, and
+    /// the rows are then selected by their codes. Returns false if the conditions cannot be evaluated with the
+    /// same result as the SQL engine, which must then be used instead.
+    bool selectRows(core::Table& table, std::vector<char>& selected) const;
+
+private: // types
+
+    enum Operator { EQ, NE, LT, LE, GT, GE, IN, LIKE };
+
+    /// n.b. For EQ, NE and IN, the values may be either numbers or strings. LIKE has exactly one
+    ///      string (the pattern). Otherwise there is exactly one number.
+
+    struct Condition {
+        std::string column;
+        Operator op;
+        std::vector<double> values;
+        std::vector<std::string> strings;
+        std::shared_ptr<eckit::Regex> regex; // Null if the pattern is not one we can evaluate
+    };
+
+private: // methods
+
+    TablePredicate() = default;
+
+    Match evaluate(const core::Table& table, const Condition& condition) const;
+
+    /// Returns null if the column is absent or ambiguous
+    static const core::Column* findColumn(const core::Table& table, const Condition& condition);
+
+    /// Evaluate a condition on strings against a single value
+    static Match evaluate(const Condition& condition, const std::string& value);
+
+    /// Evaluate a numeric condition against a single value
+    static bool evaluate(const Condition& condition, double value);
+    Match evaluate(const core::FrameIndex::Frame& frame, const Condition& condition) const;
+
+    /// Evaluate a condition against the range of values of a column
+    static Match evaluate(const Condition& condition, api::ColumnType type, const std::string& codecName,
+                          bool hasMissing, double min, double max, double missingValue);
+
+    /// Evaluate an equality (or IN) condition against the Bloom filter of a column
+    static Match evaluate(const Condition& condition, const core::FrameIndex::ColumnStatistics& column);
+
+private: // members
+
+    std::vector<Condition> conditions_;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace sql
+} // namespace odc
+
+#endif
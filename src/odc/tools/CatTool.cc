@@ -0,0 +1,46 @@
+/*
+ * (C) Copyright 1996-2018 ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+#include "eckit/exception/Exceptions.h"
+#include "eckit/log/Log.h"
+
+#include "odc/api/Odb.h"
+#include "odc/tools/CatTool.h"
+
+using namespace eckit;
+
+namespace odc {
+namespace tool {
+
+CatTool::CatTool (int argc, char *argv[]) : Tool(argc, argv)
+{
+    registerOptionWithArgument("-o");
+}
+
+void CatTool::run()
+{
+    std::string output(optionArgument("-o", std::string("")));
+
+    if (parameters().size() < 2 || output.empty())
+    {
+        Log::error() << "Usage: ";
+        usage(parameters(0), Log::error());
+        Log::error() << std::endl;
+        throw UserError("Expected an output file (option -o) and at least one input file");
+    }
+
+    const std::vector<std::string> params(parameters());
+    std::vector<std::string> inputs(params.begin() + 1, params.end());
+
+    odc::api::copyFrames(inputs, output, odc::api::FrameSelection(), optionIsSet("-append"));
+}
+
+} // namespace tool
+} // namespace odc
@@ -0,0 +1,44 @@
+/*
+ * (C) Copyright 1996-2018 ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+#ifndef odc_CatTool_H
+#define odc_CatTool_H
+
+#include "odc/tools/Tool.h"
+
+namespace odc {
+namespace tool {
+
+class CatTool : public Tool {
+public:
+    CatTool (int argc, char *argv[]);
+
+    void run();
+
+    static void help(std::ostream &o)
+    {
+        o << "Concatenates the frames of files, without decoding them";
+    }
+
+    static void usage(const std::string& name, std::ostream &o)
+    {
+        o << name << " [-append] -o <output.odb> <input.odb> [<input.odb> ...]";
+    }
+
+private:
+// No copy allowed
+    CatTool(const CatTool&);
+    CatTool& operator=(const CatTool&);
+};
+
+} // namespace tool
+} // namespace odc
+
+#endif
@@ -8,10 +8,25 @@
  * does it submit to any jurisdiction.
  */
 
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+#include <thread>
+
 #include "eckit/exception/Exceptions.h"
 #include "eckit/filesystem/PathName.h"
+#include "eckit/io/Buffer.h"
+#include "eckit/io/DataHandle.h"
+#include "eckit/io/MemoryHandle.h"
 #include "eckit/log/Log.h"
 #include "odc/Comparator.h"
+#include "odc/core/Column.h"
+#include "odc/core/MetaData.h"
+#include "odc/core/Table.h"
+#include "odc/core/TablesReader.h"
+#include "odc/ODBAPISettings.h"
 #include "odc/Reader.h"
 #include "odc/Writer.h"
 #include "odc/tools/CompactTool.h"
@@ -22,7 +37,169 @@ using namespace eckit;
 namespace odc {
 namespace tool {
 
-CompactTool::CompactTool (int argc, char *argv[]) : Tool(argc, argv) { }
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+/// Consecutive input frames with identical columns, which are re-encoded together
+
+struct Chunk {
+    std::vector<core::Table> tables;
+    unsigned long long rows = 0;
+};
+
+
+/// Order dependent checksums of the decoded values in each column. Values are reduced to the
+/// precision at which the Comparator compares them.
+
+class ColumnChecksums {
+public:
+
+    void update(const core::MetaData& columns, const double* data) {
+
+        if (sums_.empty()) sums_.resize(columns.size(), 0);
+        ASSERT(sums_.size() == columns.size());
+
+        for (size_t i = 0; i < columns.size(); ++i) {
+
+            const core::Column& column(*columns[i]);
+            uint64_t h = 0;
+
+            switch (column.type()) {
+            case api::STRING: {
+                const char* s = reinterpret_cast<const char*>(data);
+                h = std::hash<std::string>()(std::string(s, ::strnlen(s, column.dataSizeDoubles() * sizeof(double))));
+                break;
+            }
+            case api::REAL: {
+                float f = *data;
+                uint32_t bits;
+                ::memcpy(&bits, &f, sizeof(bits));
+                h = bits;
+                break;
+            }
+            default:
+                ::memcpy(&h, data, sizeof(h));
+                break;
+            }
+
+            sums_[i] = (sums_[i] * 0x100000001b3ULL) ^ h;
+            data += column.dataSizeDoubles();
+        }
+
+        ++rows_;
+    }
+
+    bool operator==(const ColumnChecksums& other) const { return rows_ == other.rows_ && sums_ == other.sums_; }
+    bool operator!=(const ColumnChecksums& other) const { return !(*this == other); }
+
+private:
+    std::vector<uint64_t> sums_;
+    unsigned long long rows_ = 0;
+};
+
+
+/// Passes the input rows on to a writer, accumulating their checksums on the way through, so that
+/// they need not be decoded a second time for verification.
+
+class ChecksummingIterator {
+public:
+    ChecksummingIterator(odc::Reader::iterator& it, ColumnChecksums& sums) : it_(it), sums_(sums) {}
+
+    bool operator!=(const ChecksummingIterator& other) const { return it_ != other.it_; }
+    ChecksummingIterator& operator++() { sums_.update(it_->columns(), it_->data()); ++it_; return *this; }
+    odc::Reader::iterator& operator->() const { return it_; }
+
+private:
+    odc::Reader::iterator& it_;
+    ColumnChecksums& sums_;
+};
+
+
+/// Re-encode a chunk of frames, with optimal codecs, and verify the result.
+
+std::unique_ptr<MemoryHandle> compactChunk(Chunk& chunk, size_t index, size_t rowsPerFrame,
+                                           bool checksums, bool integersAsDoubles) {
+
+    // Settings are thread specific
+    ODBAPISettings::instance().treatIntegersAsDoubles(integersAsDoubles);
+
+    std::vector<char> input;
+    for (core::Table& table : chunk.tables) {
+        const Buffer encoded(table.readEncodedData(true));
+        const char* p = encoded;
+        input.insert(input.end(), p, p + encoded.size());
+    }
+
+    MemoryHandle in(&input[0], input.size());
+    std::unique_ptr<MemoryHandle> out(new MemoryHandle);
+    ColumnChecksums inputSums;
+
+    {
+        odc::Reader reader(in);
+        odc::Reader::iterator it(reader.begin());
+        odc::Reader::iterator end(reader.end());
+
+        odc::Writer<> writer(*out);
+        writer.rowsBufferSize(rowsPerFrame);
+        odc::Writer<>::iterator outIt(writer.begin());
+
+        unsigned long long rows;
+        if (checksums) {
+            ChecksummingIterator b(it, inputSums);
+            ChecksummingIterator e(end, inputSums);
+            rows = outIt->pass1(b, e);
+        } else {
+            rows = outIt->pass1(it, end);
+        }
+        ASSERT(rows == chunk.rows);
+    }
+
+    // Verify the re-encoded chunk
+
+    MemoryHandle written(out->data(), out->position());
+
+    if (checksums) {
+        ColumnChecksums outputSums;
+        odc::Reader reader(written);
+        odc::Reader::iterator it(reader.begin());
+        odc::Reader::iterator end(reader.end());
+        for (; it != end; ++it) outputSums.update(it->columns(), it->data());
+
+        if (outputSums != inputSums) {
+            std::ostringstream ss;
+            ss << "Checksums of compacted data differ from the input, in chunk " << index;
+            throw SeriousBug(ss.str(), Here());
+        }
+    } else {
+        odc::Reader reader1(in);
+        odc::Reader reader2(written);
+        odc::Reader::iterator it1(reader1.begin());
+        odc::Reader::iterator end1(reader1.end());
+        odc::Reader::iterator it2(reader2.begin());
+        odc::Reader::iterator end2(reader2.end());
+
+        std::ostringstream desc;
+        desc << "chunk " << index;
+        odc::Comparator().compare(it1, end1, it2, end2, "input " + desc.str(), "output " + desc.str());
+    }
+
+    return out;
+}
+
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+CompactTool::CompactTool (int argc, char *argv[]) : Tool(argc, argv)
+{
+    registerOptionWithArgument("-nthreads");
+    registerOptionWithArgument("-rowsperframe");
+}
+
+/// Consecutive frames with the same columns are merged, up to the target frame size, and each
+/// group is re-encoded (and verified) independently and in parallel. The output is written in the
+/// order of the input.
 
 void CompactTool::run()
 {
@@ -39,27 +216,61 @@ void CompactTool::run()
 	PathName inFile = parameters(1);
 	PathName outFile = parameters(2);
 
-	odc::Reader in(inFile);
-	odc::Writer<> out(outFile);
+    long nthreads = optionArgument("-nthreads", long(std::max(1u, std::thread::hardware_concurrency())));
+    if (nthreads <= 0) throw UserError("-nthreads must be a positive number");
+
+    long rowsPerFrame = optionArgument("-rowsperframe", long(odc::Writer<>().rowsBufferSize()));
+    if (rowsPerFrame <= 0) throw UserError("-rowsperframe must be a positive number");
+
+    bool checksums = optionIsSet("-checksum");
 
-	odc::Reader::iterator it(in.begin());
-	odc::Reader::iterator end(in.end());
+    // Group the input frames
 
-	odc::Writer<>::iterator writer(out.begin());
-	writer->pass1(it, end);
-	
-	odc::Reader outReader(outFile);
-	Log::info() << "Verifying." << std::endl;	
-	odc::Reader::iterator it1 = in.begin();
-	odc::Reader::iterator end1 = in.end();
+    core::TablesReader reader(inFile);
+    std::vector<Chunk> chunks;
+    size_t inputFrames = 0;
 
-	odc::Reader::iterator it2 = outReader.begin();
-	odc::Reader::iterator end2 = outReader.end();
+    for (auto it = reader.begin(); it != reader.end(); ++it) {
+        if (it->rowCount() == 0) continue;
+        ++inputFrames;
+        if (chunks.empty() ||
+            chunks.back().rows + it->rowCount() > static_cast<unsigned long long>(rowsPerFrame) ||
+            chunks.back().tables.back().columns() != it->columns()) {
+            chunks.emplace_back();
+        }
+        chunks.back().tables.emplace_back(*it);
+        chunks.back().rows += it->rowCount();
+    }
 
-	odc::Comparator comparator;
-	comparator.compare(it1, end1, it2, end2, inFile, outFile);
+    // Re-encode, holding a bounded number of chunks in memory
+
+    std::unique_ptr<DataHandle> out(outFile.fileHandle());
+    out->openForWrite(0);
+    AutoClose closer(*out);
+
+    const bool integersAsDoubles = ODBAPISettings::instance().integersAsDoubles();
+    std::deque<std::future<std::unique_ptr<MemoryHandle>>> pending;
+
+    auto writeNext = [&] {
+        std::unique_ptr<MemoryHandle> encoded(pending.front().get());
+        pending.pop_front();
+        long length = encoded->position();
+        if (length > 0) ASSERT(out->write(encoded->data(), length) == length);
+    };
+
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        pending.emplace_back(std::async(std::launch::async, compactChunk, std::ref(chunks[i]), i,
+                                        size_t(rowsPerFrame), checksums, integersAsDoubles));
+        if (pending.size() >= size_t(nthreads)) writeNext();
+    }
+    while (!pending.empty()) writeNext();
+
+    Log::info() << "Compacted " << inputFrames << " frame(s) in " << chunks.size() << " chunk(s). Verified "
+                << (checksums ? "checksums." : "values.") << std::endl;
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+
 } // namespace tool 
 } // namespace odc 
 
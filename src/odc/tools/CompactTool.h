@@ -25,7 +25,7 @@ public:
 	{ o << "Tries to compress a file"; }
 
 	static void usage(const std::string& name, std::ostream &o)
-	{ o << name << " <input.odb> <output.odb>"; }
+	{ o << name << " [-nthreads <N>] [-rowsperframe <N>] [-checksum] <input.odb> <output.odb>"; }
 
 private:
 // No copy allowed
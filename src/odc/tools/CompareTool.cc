@@ -8,13 +8,15 @@
  * does it submit to any jurisdiction.
  */
 
+#include <algorithm>
+#include <thread>
+
 #include "eckit/exception/Exceptions.h"
 #include "eckit/filesystem/PathName.h"
 #include "eckit/log/Log.h"
 #include "eckit/utils/StringTools.h"
 #include "eckit/log/Timer.h"
 #include "odc/Comparator.h"
-#include "odc/Reader.h"
 #include "odc/tools/CompareTool.h"
 
 using namespace std;
@@ -27,6 +29,7 @@ CompareTool::CompareTool (int argc, char *argv[])
 : Tool(argc, argv) 
 {
 	registerOptionWithArgument("-excludeColumnsTypes");
+    registerOptionWithArgument("-nthreads");
     registerOptionWithArgument("-excludeColumns");
     if (parameters().size() != 3)
 	{
@@ -55,13 +58,6 @@ CompareTool::CompareTool (int argc, char *argv[])
 void CompareTool::run()
 {
     Timer t(std::string("Comparing files ") + file1_ + " and " + file2_);
-    odc::Reader oda1(file1_);
-    odc::Reader oda2(file2_);
-
-	odc::Reader::iterator it1(oda1.begin());
-	odc::Reader::iterator end1(oda1.end());
-	odc::Reader::iterator it2(oda2.begin());
-	odc::Reader::iterator end2(oda2.end());
 
 	std::vector<std::string> excludedColumnsTypes = StringTools::split(",", optionArgument("-excludeColumnsTypes", std::string("")));
     std::vector<std::string> excludedColumns = StringTools::split(",", optionArgument("-excludeColumns", std::string("")));
@@ -74,8 +70,11 @@ void CompareTool::run()
         Log::info() << "excludedColumns:" << excludedColumns << std::endl;
     }
 
+    long nthreads = optionArgument("-nthreads", long(std::max(1u, std::thread::hardware_concurrency())));
+    if (nthreads <= 0) throw UserError("-nthreads must be a positive number");
+
 	bool checkMissing = ! optionIsSet("-dontCheckMissing");
-    odc::Comparator(checkMissing).compare(it1, end1, it2, end2, file1_, file2_, excludedColumnsTypes, excludedColumns);
+    odc::Comparator(checkMissing).compareTables(file1_, file2_, excludedColumnsTypes, excludedColumns, nthreads);
 }
 
 } // namespace tool 
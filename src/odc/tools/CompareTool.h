@@ -34,7 +34,7 @@ public:
 
 	static void usage(const std::string& name, std::ostream &o)
 	{
-        o << name << " [-excludeColumns <list-of-columns>] [-excludeColumnsTypes <list-of-columns>] [-dontCheckMissing] <file1.odb> <file2.odb>";
+        o << name << " [-excludeColumns <list-of-columns>] [-excludeColumnsTypes <list-of-columns>] [-dontCheckMissing] [-nthreads <N>] <file1.odb> <file2.odb>";
 	}
 
 private:
@@ -8,6 +8,11 @@
  * does it submit to any jurisdiction.
  */
 
+#include <algorithm>
+#include <future>
+#include <mutex>
+#include <thread>
+
 #include "eckit/eckit.h"
 #include "eckit/exception/Exceptions.h"
 #include "eckit/log/Log.h"
@@ -16,6 +21,7 @@
 #include "odc/core/TablesReader.h"
 #include "odc/LibOdc.h"
 #include "odc/Reader.h"
+#include "odc/RowsCounter.h"
 #include "odc/tools/CountTool.h"
 
 using namespace eckit;
@@ -23,7 +29,10 @@ using namespace eckit;
 namespace odc {
 namespace tool {
 
-CountTool::CountTool (int argc, char *argv[]) : Tool(argc, argv) { }
+CountTool::CountTool (int argc, char *argv[]) : Tool(argc, argv)
+{
+    registerOptionWithArgument("-nthreads");
+}
 
 size_t CountTool::rowCount(const PathName &db)
 {
@@ -52,14 +61,55 @@ void CountTool::run()
         throw UserError(ss.str());
 	}
 
-	unsigned long long n (0);
-    for (size_t i (1); i < parameters().size(); ++i)
-    {
-        const std::string fileName (parameters(i));
+    long nthreads = optionArgument("-nthreads", long(std::max(1u, std::thread::hardware_concurrency())));
+    if (nthreads <= 0) throw UserError("-nthreads must be a positive number");
+
+    const bool verify = !optionIsSet("-noverify");
+
+    // Count the files concurrently
+
+    const std::vector<std::string> params(parameters());
+    std::vector<std::string> fileNames(params.begin() + 1, params.end());
+    std::vector<unsigned long long> counts(fileNames.size());
+
+    std::mutex guard_mutex;
+    std::vector<std::future<void>> threads;
+    size_t next_file = 0;
 
-        LOG_DEBUG_LIB(LibOdc) << "CountTool: counting " << fileName << std::endl;
+    for (long i = 0; i < std::min<long>(nthreads, fileNames.size()); ++i) {
+        threads.emplace_back(std::async(std::launch::async, [&] {
+            while (true) {
+                size_t file;
 
-        n += rowCount(fileName);
+                {
+                    std::lock_guard<std::mutex> guard(guard_mutex);
+                    if (next_file < fileNames.size()) {
+                        file = next_file++;
+                    } else {
+                        return;
+                    }
+                }
+
+                LOG_DEBUG_LIB(LibOdc) << "CountTool: counting " << fileNames[file] << std::endl;
+
+                counts[file] = verify ? rowCount(fileNames[file])
+                                      : RowsCounter::headerRowCount(fileNames[file]);
+            }
+        }));
+    }
+
+    // Waits for the threads. If any exceptions have been thrown, they get thrown into
+    // the main thread here.
+    for (auto& thread : threads) {
+        thread.get();
+    }
+
+	unsigned long long n (0);
+    for (size_t i (0); i < fileNames.size(); ++i)
+    {
+        if (optionIsSet("-perfile"))
+            std::cout << counts[i] << " " << fileNames[i] << std::endl;
+        n += counts[i];
     }
 	
 	std::cout << n << std::endl;
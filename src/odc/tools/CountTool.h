@@ -31,7 +31,7 @@ public:
 
 	static void usage(const std::string& name, std::ostream &o)
 	{
-		o << name << " <file.odb>";
+		o << name << " [-nthreads <N>] [-noverify] [-perfile] <file.odb> [<file.odb> ...]";
 	}
 
 private:
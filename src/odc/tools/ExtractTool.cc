@@ -0,0 +1,101 @@
+/*
+ * (C) Copyright 1996-2018 ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+#include <cstdlib>
+
+#include "eckit/exception/Exceptions.h"
+#include "eckit/log/Log.h"
+#include "eckit/utils/StringTools.h"
+
+#include "odc/api/Odb.h"
+#include "odc/tools/ExtractTool.h"
+
+using namespace eckit;
+
+namespace odc {
+namespace tool {
+
+namespace {
+
+long toCount(const std::string& s, const std::string& what) {
+    char* end;
+    long n = ::strtol(s.c_str(), &end, 10);
+    if (s.empty() || *end != '\0' || n < 0) throw UserError("Invalid " + what + ": " + s);
+    return n;
+}
+
+}
+
+ExtractTool::ExtractTool (int argc, char *argv[]) : Tool(argc, argv)
+{
+    registerOptionWithArgument("-o");
+    registerOptionWithArgument("-frames");
+    registerOptionWithArgument("-rows");
+    registerOptionWithArgument("-span");
+}
+
+void ExtractTool::usage(const std::string& name, std::ostream &o)
+{
+    o << name << " [-frames <first>[:<count>]] [-rows <n>] [-span <column>=<value>[/<value>...][,...]] [-append]"
+              << " -o <output.odb> <input.odb> [<input.odb> ...]" << std::endl
+      << std::endl
+      << "\t-frames <first>[:<count>]" << std::endl
+      << "\t               Skip the first <first> frames (counted across all inputs), and copy at most <count>" << std::endl
+      << "\t-rows <n>      Stop once at least <n> rows have been copied. Only whole frames are copied" << std::endl
+      << "\t-span <column>=<value>[/<value>...][,<column>=...]" << std::endl
+      << "\t               Only copy frames which contain at least one of the values, for each column" << std::endl;
+}
+
+void ExtractTool::run()
+{
+    std::string output(optionArgument("-o", std::string("")));
+
+    if (parameters().size() < 2 || output.empty())
+    {
+        Log::error() << "Usage: ";
+        usage(parameters(0), Log::error());
+        Log::error() << std::endl;
+        throw UserError("Expected an output file (option -o) and at least one input file");
+    }
+
+    odc::api::FrameSelection selection;
+
+    std::string frames(optionArgument("-frames", std::string("")));
+    if (!frames.empty()) {
+        std::vector<std::string> range(StringTools::split(":", frames));
+        if (range.empty() || range.size() > 2) throw UserError("Invalid frame range: " + frames);
+        long first = toCount(range[0], "frame range");
+        long count = (range.size() == 2) ? toCount(range[1], "frame range") : 0;
+        if (range.size() == 2 && count == 0) throw UserError("Invalid frame range: " + frames);
+        selection.firstFrame = first;
+        selection.maxFrames = count;
+    }
+
+    long rows = optionArgument("-rows", long(0));
+    if (rows < 0) throw UserError("-rows must not be negative");
+    selection.maxRows = rows;
+
+    std::string span(optionArgument("-span", std::string("")));
+    for (const std::string& key : StringTools::split(",", span)) {
+        std::vector<std::string> kv(StringTools::split("=", key));
+        if (kv.size() != 2) throw UserError("Invalid span selection: " + key);
+        std::vector<std::string> values(StringTools::split("/", kv[1]));
+        if (values.empty()) throw UserError("Invalid span selection: " + key);
+        selection.spanValues[kv[0]].insert(values.begin(), values.end());
+    }
+
+    const std::vector<std::string> params(parameters());
+    std::vector<std::string> inputs(params.begin() + 1, params.end());
+
+    odc::api::copyFrames(inputs, output, selection, optionIsSet("-append"));
+}
+
+} // namespace tool
+} // namespace odc
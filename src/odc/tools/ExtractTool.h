@@ -0,0 +1,41 @@
+/*
+ * (C) Copyright 1996-2018 ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+#ifndef odc_ExtractTool_H
+#define odc_ExtractTool_H
+
+#include "odc/tools/Tool.h"
+
+namespace odc {
+namespace tool {
+
+class ExtractTool : public Tool {
+public:
+    ExtractTool (int argc, char *argv[]);
+
+    void run();
+
+    static void help(std::ostream &o)
+    {
+        o << "Extracts whole frames from files, without decoding them";
+    }
+
+    static void usage(const std::string& name, std::ostream &o);
+
+private:
+// No copy allowed
+    ExtractTool(const ExtractTool&);
+    ExtractTool& operator=(const ExtractTool&);
+};
+
+} // namespace tool
+} // namespace odc
+
+#endif
@@ -8,8 +8,13 @@
  * does it submit to any jurisdiction.
  */
 
+#include <algorithm>
+#include <thread>
+
 #include "eckit/eckit.h"
 #include "eckit/exception/Exceptions.h"
+#include "eckit/utils/StringTools.h"
+#include "odc/core/FrameIndex.h"
 #include "odc/core/MetaData.h"
 #include "odc/Reader.h"
 #include "odc/Select.h"
@@ -25,20 +30,38 @@ using namespace eckit;
 namespace odc {
 namespace tool {
 
-IndexTool::IndexTool (int argc, char *argv[]) : Tool(argc, argv) { }
+IndexTool::IndexTool (int argc, char *argv[]) : Tool(argc, argv)
+{
+    registerOptionWithArgument("-nthreads");
+    registerOptionWithArgument("-bloom");
+    registerOptionWithArgument("-fpr");
+    registerOptionWithArgument("-bloombytes");
+}
 
 void IndexTool::help(std::ostream &o) {
-    o << "Creates index of reports for a given file";
+    o << "Creates index of reports (or of frames) for a given file";
 }
 
 
 void IndexTool::usage(const std::string& name, std::ostream &o) {
     o << name
-      << " <file.odb> [<file.odb.idx>] " << std::endl
+      << " [-seqno | -frames [-nodistinct] [-nthreads <n>] [-bloom <columns> [-fpr <rate>] [-bloombytes <n>]]] <file.odb> [<file.odb.idx>] " << std::endl
       << std::endl
-      << "\tSpecifically the index file is an ODB file with (INTEGER) columns: block_begin, block_length, seqno, n_rows"
+      << "\tBy default (or with -seqno) the index file is an ODB file with (INTEGER) columns:" << std::endl
+      << "\tblock_begin, block_length, seqno, n_rows" << std::endl
+      << "\tOne entry is made for each unique seqno - block pair within the source ODB file." << std::endl
       << std::endl
-      << "\tOne entry is made for each unique seqno - block pair within the source ODB file." << std::endl;
+      << "\t-frames        Write a frame index instead. For each frame this records its position, size and number" << std::endl
+      << "\t               of rows, and the range, presence of missing values and number of distinct values of each" << std::endl
+      << "\t               column. It is used to skip frames when filtering the file." << std::endl
+      << "\t-nodistinct    Take the statistics from the frame headers only. Do not decode the data" << std::endl
+      << "\t-nthreads <n>  Number of threads used to decode the frames (default: number of cores)" << std::endl
+      << "\t-bloom <columns>" << std::endl
+      << "\t               Comma separated list of (integer or string) columns for which Bloom filters are built" << std::endl
+      << "\t               in each frame. These allow frames to be skipped when looking up individual values." << std::endl
+      << "\t-fpr <rate>    Target false positive rate of the Bloom filters (default: 0.01)" << std::endl
+      << "\t-bloombytes <n>" << std::endl
+      << "\t               Maximum size of each Bloom filter, in bytes (default: unlimited)" << std::endl;
 }
 
 
@@ -56,10 +79,30 @@ void IndexTool::run()
 
     PathName dataFile (parameters(1));
     PathName indexFile (parameters().size() == 3 
-                        ? parameters(2) 
-                        : parameters(1) + ".idx");
+                        ? PathName(parameters(2))
+                        : core::FrameIndex::indexPath(dataFile));
+
+    if (optionIsSet("-seqno") && optionIsSet("-frames")) {
+        throw UserError("Only one of -seqno and -frames may be specified");
+    }
+
+    if (!optionIsSet("-frames")) {
+        Indexer::createIndex(dataFile, indexFile);
+        return;
+    }
+
+    long nthreads = optionArgument("-nthreads", long(std::max(1u, std::thread::hardware_concurrency())));
+    if (nthreads <= 0) throw UserError("-nthreads must be a positive number");
+
+    core::FrameIndex::BloomOptions bloom;
+    bloom.columns = StringTools::split(",", optionArgument("-bloom", std::string("")));
+    bloom.falsePositiveRate = optionArgument("-fpr", 0.01);
+    long maxBytes = optionArgument("-bloombytes", long(0));
+    if (bloom.falsePositiveRate <= 0 || bloom.falsePositiveRate >= 1) throw UserError("-fpr must be between 0 and 1");
+    if (maxBytes < 0) throw UserError("-bloombytes must not be negative");
+    bloom.maxBytes = maxBytes;
 
-	Indexer::createIndex(dataFile, indexFile);
+    core::FrameIndex::build(dataFile, !optionIsSet("-nodistinct"), nthreads, bloom).save(indexFile);
 }
 
 } // namespace tool 
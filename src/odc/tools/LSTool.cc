@@ -9,10 +9,22 @@
  */
 
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
 #include <fstream>
+#include <future>
+#include <set>
+#include <thread>
 
 #include "eckit/exception/Exceptions.h"
 
+#include "odc/core/DecodeTarget.h"
+#include "odc/core/Table.h"
+#include "odc/core/TablesReader.h"
+#include "odc/ODBAPISettings.h"
 #include "odc/Reader.h"
 #include "odc/tools/LSTool.h"
 
@@ -24,11 +36,176 @@ namespace tool {
 LSTool::LSTool (int argc, char *argv[]) : Tool(argc, argv)
 {
 	registerOptionWithArgument("-o"); // Text Output
+	registerOptionWithArgument("-nthreads");
 }
 
 const std::string LSTool::nullString;
 
-unsigned long long LSTool::printData(const std::string &db, std::ostream &out)
+namespace {
+
+/// Can the frame be decoded column by column?
+bool columnwise(const core::Table& table) {
+    std::set<std::string> names;
+    for (const core::Column* column : table.columns()) {
+        if (column->type() != api::STRING && column->dataSizeDoubles() != 1) return false;
+        if (!names.insert(column->name()).second) return false;
+    }
+    return true;
+}
+
+inline void appendInteger(std::string& text, int value) {
+    char buf[16];
+    char* p = buf + sizeof(buf);
+    unsigned int v = value < 0 ? 0u - static_cast<unsigned int>(value) : static_cast<unsigned int>(value);
+    do {
+        *--p = '0' + (v % 10);
+        v /= 10;
+    } while (v);
+    if (value < 0) *--p = '-';
+    text.append(p, buf + sizeof(buf) - p);
+}
+
+/// Formats the rows of a frame exactly as LSTool::printRows does, without the per-value stream
+/// operations. The text of the whole frame is built in one buffer.
+
+std::string renderFrame(core::Table& table, bool integersAsDoubles) {
+
+    // Settings are thread specific
+    ODBAPISettings::instance().treatIntegersAsDoubles(integersAsDoubles);
+
+    const core::MetaData& md(table.columns());
+    size_t nrows = table.rowCount();
+    size_t ncols = md.size();
+
+    std::vector<std::vector<double>> values(ncols);
+    std::vector<std::string> names;
+    std::vector<api::StridedData> facades;
+
+    for (size_t i = 0; i < ncols; ++i) {
+        size_t width = md[i]->dataSizeDoubles() * sizeof(double);
+        values[i].resize(nrows * md[i]->dataSizeDoubles());
+        names.push_back(md[i]->name());
+        facades.emplace_back(&values[i][0], nrows, width, width);
+    }
+
+    core::DecodeTarget target(names, std::move(facades));
+    table.decode(target);
+
+    std::vector<uint64_t> missing(ncols);
+    for (size_t i = 0; i < ncols; ++i) {
+        double missingValue = md[i]->missingValue();
+        ::memcpy(&missing[i], &missingValue, sizeof(missing[i]));
+    }
+
+    std::string text;
+    text.reserve(nrows * ncols * 12);
+    char buf[512];
+
+    for (size_t row = 0; row < nrows; ++row) {
+        for (size_t i = 0; i < ncols; ++i) {
+
+            if (i) text += '\t';
+
+            const core::Column& column(*md[i]);
+            size_t width = column.dataSizeDoubles();
+            const double* v = &values[i][row * width];
+
+            uint64_t bits;
+            ::memcpy(&bits, v, sizeof(bits));
+            if (column.hasMissing() && bits == missing[i]) {
+                text += '.';
+                continue;
+            }
+
+            switch (column.type()) {
+                case odc::api::INTEGER:
+                case odc::api::BITFIELD:
+                    appendInteger(text, static_cast<int>(*v));
+                    break;
+                case odc::api::REAL:
+                case odc::api::DOUBLE: {
+                    // n.b. As std::fixed with the default precision
+                    int n = ::snprintf(buf, sizeof(buf), "%.6f", *v);
+                    ASSERT(n > 0 && size_t(n) < sizeof(buf));
+                    text.append(buf, n);
+                    break;
+                }
+                case odc::api::STRING: {
+                    const char* s = reinterpret_cast<const char*>(v);
+                    text += '\'';
+                    text.append(s, ::strnlen(s, width * sizeof(double)));
+                    text += '\'';
+                    break;
+                }
+                case odc::api::IGNORE:
+                default:
+                    ASSERT("Unknown type" && false);
+                    break;
+            }
+        }
+        text += '\n';
+    }
+
+    return text;
+}
+
+}
+
+unsigned long long LSTool::printData(const std::string &db, std::ostream &out, size_t nthreads)
+{
+    std::vector<core::Table> tables;
+    core::TablesReader reader(db);
+    for (auto it = reader.begin(); it != reader.end(); ++it) {
+        if (it->rowCount() > 0) tables.emplace_back(*it);
+    }
+
+    // Frames that cannot be decoded column by column (duplicate names, or wide numeric columns)
+    // are unusual. Fall back to the row-wise output for the whole file.
+
+    for (const core::Table& table : tables) {
+        if (!columnwise(table)) return printRows(db, out);
+    }
+
+    // Format the frames concurrently, and write them out in order
+
+    const bool integersAsDoubles = ODBAPISettings::instance().integersAsDoubles();
+    std::deque<std::future<std::string>> pending;
+    size_t nextOutput = 0;
+
+    core::MetaData md(0);
+    unsigned long long n = 0;
+
+    auto writeNext = [&] {
+        std::string text(pending.front().get());
+        pending.pop_front();
+
+        const core::Table& table(tables[nextOutput++]);
+        if (md != table.columns())
+        {
+            md = table.columns();
+            const char* spacer = "";
+            for (size_t i = 0; i < md.size(); ++i) {
+                out << spacer << md[i]->name();
+                spacer = "\t";
+            }
+            out << "\n";
+        }
+
+        out.write(text.data(), text.size());
+        n += table.rowCount();
+    };
+
+    for (size_t i = 0; i < tables.size(); ++i) {
+        pending.emplace_back(std::async(std::launch::async, renderFrame, std::ref(tables[i]), integersAsDoubles));
+        if (pending.size() >= std::max<size_t>(nthreads, 1)) writeNext();
+    }
+    while (!pending.empty()) writeNext();
+
+    out.flush();
+    return n;
+}
+
+unsigned long long LSTool::printRows(const std::string &db, std::ostream &out)
 {
 	odc::Reader f(db);
 	odc::Reader::iterator it = f.begin();
@@ -108,8 +285,11 @@ void LSTool::run()
         out = foutPtr.get();
     }
 
+	long nthreads = optionArgument("-nthreads", long(std::max(1u, std::thread::hardware_concurrency())));
+	if (nthreads <= 0) throw UserError("-nthreads must be a positive number");
+
 	unsigned long long n = 0;
-	n = printData(db, *out);
+	n = printData(db, *out, nthreads);
 	Log::info() << "Selected " << n << " row(s)." << std::endl;
 }
 
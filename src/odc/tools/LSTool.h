@@ -26,11 +26,14 @@ public:
 	{ o << "Shows file's contents"; }
 
 	static void usage(const std::string& name, std::ostream &o)
-    { o << name << " [-o <output-file>] <file-name>" << std::endl << std::endl; }
+    { o << name << " [-o <output-file>] [-nthreads <n>] <file-name>" << std::endl << std::endl; }
 
-	unsigned long long printData(const std::string &db, std::ostream &out);
+	/// Frames are decoded, and formatted, on up to nthreads threads
+	unsigned long long printData(const std::string &db, std::ostream &out, size_t nthreads=1);
 
 private:
+	unsigned long long printRows(const std::string &db, std::ostream &out);
+
 // No copy allowed
     LSTool(const LSTool&);
     LSTool& operator=(const LSTool&);
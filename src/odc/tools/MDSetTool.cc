@@ -17,10 +17,15 @@
 #include "eckit/utils/Tokenizer.h"
 #include "eckit/sql/SQLTypedefs.h"
 
+#include "eckit/io/MemoryHandle.h"
+
+#include "odc/core/FileRangeCopier.h"
 #include "odc/core/Header.h"
 #include "odc/core/MetaData.h"
 #include "odc/core/TablesReader.h"
 #include "odc/ODBAPISettings.h"
+#include "odc/Reader.h"
+#include "odc/Writer.h"
 
 using namespace eckit;
 using namespace std;
@@ -36,16 +41,93 @@ void MDSetTool::help(std::ostream &o) {
 
 
 void MDSetTool::usage(const std::string& name, std::ostream &o) {
-    o << name << " <update-list> <input.odb> <output.odb>" << endl << endl
+    o << name << " [-rename <old>=<new>[,...]] [-missing <column>=<value>[,...]] <update-list> <input.odb> <output.odb>" << endl << endl
 
       << "\t<update-list> is a comma separated list of expressions of the form:" << endl
       << "\t  <column-name> : <type> = <value>" << endl << endl
       << "\t<type> can be one of: integer, real, double, string. If ommited, the existing type of the column will not be changed." << endl
       << "\tBoth type and value are optional; at least one of the two should be present. For example:" << endl
-      << "\t  odb mdset \"expver='    0008'\" input.odb patched.odb " << endl;
+      << "\t  odb mdset \"expver='    0008'\" input.odb patched.odb " << endl << endl
+      << "\t-rename <old>=<new>[,...]       Rename columns" << endl
+      << "\t-missing <column>=<value>[,...] Change the missing value of columns" << endl << endl
+      << "\tOnly the frame headers are rewritten, and the encoded data is copied unchanged, unless a value is set" << endl
+      << "\tfor a column which is not constant in a frame, or a missing value is changed. Such frames are re-encoded." << endl;
+}
+
+MDSetTool::MDSetTool (int argc, char *parameters[]) : Tool(argc, parameters)
+{
+    registerOptionWithArgument("-rename");
+    registerOptionWithArgument("-missing");
+}
+
+namespace {
+
+std::map<std::string, std::string> parseAssignments(const std::string& s)
+{
+    std::map<std::string, std::string> r;
+    for (const std::string& assignment : S::split(",", s))
+    {
+        std::vector<std::string> kv(S::split("=", assignment));
+        if (kv.size() != 2) throw UserError("Invalid assignment: " + assignment);
+        r[S::trim(kv[0])] = S::trim(kv[1]);
+    }
+    return r;
+}
+
+/// Re-encode a frame, forcing the given columns to constant values, and replacing the missing values
+/// of others. The rest of the metadata (names, types) is taken from the (updated) columns.
+
+eckit::Buffer reencode(Table& table, const MetaData& columns, const std::map<size_t, double>& constants,
+                       const std::map<size_t, double>& missingValues)
+{
+    const Buffer encoded(table.readEncodedData(true));
+    MemoryHandle in(encoded);
+    MemoryHandle out;
+
+    odc::Reader reader(in);
+    odc::Reader::iterator it(reader.begin());
+    odc::Reader::iterator end(reader.end());
+
+    {
+        odc::Writer<> writer(out);
+        odc::Writer<>::iterator outIt(writer.begin());
+        outIt->columns(columns);
+
+        // n.b. Setting the columns resets the codecs, and hence the missing values
+
+        std::vector<size_t> changedMissing;
+        for (size_t i = 0; i < columns.size(); ++i)
+        {
+            auto missing = missingValues.find(i);
+            double mv = (missing == missingValues.end()) ? columns[i]->missingValue() : missing->second;
+            outIt->missingValue(i, mv);
+            if (it != end && mv != it->columns()[i]->missingValue()) changedMissing.push_back(i);
+        }
+        outIt->writeHeader();
+
+        for (; it != end; ++it)
+        {
+            double* data = it->data();
+            for (size_t i : changedMissing)
+            {
+                double& v (data[it->dataOffset(i)]);
+                if (v == it->columns()[i]->missingValue()) v = missingValues.at(i);
+            }
+            for (const auto& kv : constants)
+            {
+                size_t offset = it->dataOffset(kv.first);
+                size_t width = columns[kv.first]->dataSizeDoubles();
+                data[offset] = kv.second;
+                for (size_t i = 1; i < width; ++i) data[offset + i] = 0;
+            }
+            ASSERT(outIt->writeRow(data, it->columns().size()) == 0);
+        }
+    }
+
+    return eckit::Buffer(out.data(), out.position());
 }
 
-MDSetTool::MDSetTool (int argc, char *parameters[]) : Tool(argc, parameters) { }
+}
 
 void MDSetTool::run()
 {
@@ -60,67 +142,94 @@ void MDSetTool::run()
     }
 
     PathName inFile = parameters(2), outFile = parameters(3);
-    std::unique_ptr<DataHandle> outHandle(ODBAPISettings::instance().writeToFile(outFile));
 
     std::vector<std::string> columns, types, values;
     std::vector<eckit::sql::BitfieldDef> bitfieldDefs;
     parseUpdateList(parameters(1), columns, types, values, bitfieldDefs);
 
+    std::map<std::string, std::string> renames(parseAssignments(optionArgument("-rename", std::string(""))));
+    std::map<std::string, std::string> missingValues(parseAssignments(optionArgument("-missing", std::string(""))));
+
+    // The payloads are copied directly from the input file, unless the frame has to be re-encoded
+
+    outFile.dirName().mkdir();
+    FileRangeCopier out(outFile);
+    out.checkInput(inFile);
+
+    size_t rewrittenFrames = 0;
+    size_t reencodedFrames = 0;
+
     odc::core::TablesReader reader(inFile);
 
     for (auto it = reader.begin(), end = reader.end(); it != end; ++it) {
 
         const MetaData& md (it->columns());
+        std::map<size_t, double> constants;
+
         for (size_t i = 0; i < columns.size(); ++i)
         {
-            Column& c (*md[md.columnIndex(columns[i])]);
+            size_t index = md.columnIndex(columns[i]);
+            Column& c (*md[index]);
             Log::info() << "" << columns[i]  << ": " << c << endl;
 
             if (types[i].size() && types[i] != "NONE") c.type(Column::type(types[i]));
             if (bitfieldDefs[i].first.size()) c.bitfieldDef(bitfieldDefs[i]);
             if (values[i].size() && values[i] != "NONE")
             {
-                Codec& codec (c.coder());
-                if (codec.name().find("constant") == std::string::npos)
+                double v (StringTool::translate(values[i]));
+                if (c.isConstant())
                 {
-                    stringstream ss;
-                    ss << "Column '" << columns[i] << "' is not constant (codec: " << codec.name() << ")" << endl;
-                    throw UserError(ss.str());
+                    c.min(v);
+                    c.max(v);
+                }
+                else
+                {
+                    constants[index] = v;
                 }
-                double v (StringTool::translate(values[i]));
-                c.min(v);
-                c.max(v);
             }
         }
 
+        // n.b. The missing values are not set on the columns, which would also reset their statistics.
+        //      The encoded data may hold the old missing value, so these frames are re-encoded.
+
+        std::map<size_t, double> changedMissing;
+        for (const auto& kv : missingValues)
+        {
+            size_t index = md.columnIndex(kv.first);
+            double v (StringTool::translate(kv.second));
+            if (v != md[index]->missingValue()) changedMissing[index] = v;
+        }
+
+        for (const auto& kv : renames)
+        {
+            md[md.columnIndex(kv.first)]->name(kv.second);
+        }
+
+        if (!constants.empty() || !changedMissing.empty())
+        {
+            Log::info() << "MDSetTool::run: re-encoding frame at " << it->startPosition() << std::endl;
+            eckit::Buffer encoded(reencode(*it, md, constants, changedMissing));
+            out.write(encoded, encoded.size());
+            ++reencodedFrames;
+            continue;
+        }
+
         size_t sizeOfEncodedData = it->encodedDataSize();
-        eckit::Buffer encodedData(it->readEncodedData());
-        ASSERT(encodedData.size() == sizeOfEncodedData);
 
 	    // See if the file was created on a different order architecture
-        if (it->byteOrder() == BYTE_ORDER_INDICATOR)
-		{
-			Log::info() << "MDSetTool::run: SAME ORDER " << sizeOfEncodedData << std::endl;
-
-            auto encodedHeader = core::Header::serializeHeader(sizeOfEncodedData,
-                                                               md.rowsNumber(),
-                                                               it->properties(),
-                                                               md);
-            outHandle->write(encodedHeader.first, encodedHeader.second);
-		}
-		else
-		{
-			Log::info() << "MDSetTool::run: OTHER ORDER " << sizeOfEncodedData << std::endl;
-			
-            auto encodedHeader = core::Header::serializeHeaderOtherByteOrder(
-                                                               sizeOfEncodedData,
-                                                               md.rowsNumber(),
-                                                               it->properties(),
-                                                               md);
-            outHandle->write(encodedHeader.first, encodedHeader.second);
-		}
-        outHandle->write(encodedData.data(), sizeOfEncodedData);
+        auto encodedHeader = (it->byteOrder() == BYTE_ORDER_INDICATOR)
+            ? core::Header::serializeHeader(sizeOfEncodedData, md.rowsNumber(), it->properties(), md)
+            : core::Header::serializeHeaderOtherByteOrder(sizeOfEncodedData, md.rowsNumber(), it->properties(), md);
+
+        out.write(encodedHeader.first, encodedHeader.second);
+        out.copy(inFile, Offset(static_cast<long long>(it->nextPosition()) - sizeOfEncodedData), sizeOfEncodedData);
+        ++rewrittenFrames;
 	}
+
+    out.close();
+
+    Log::info() << "MDSetTool::run: rewrote the headers of " << rewrittenFrames << " frames, re-encoded "
+                << reencodedFrames << " frames" << std::endl;
 }
 
 // 
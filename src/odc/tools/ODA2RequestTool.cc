@@ -8,18 +8,25 @@
  * does it submit to any jurisdiction.
  */
 
+#include <algorithm>
 #include <fstream>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #include "eckit/config/Resource.h"
 #include "eckit/filesystem/PathName.h"
 #include "eckit/log/Log.h"
 #include "eckit/utils/StringTools.h"
 #include "eckit/utils/Tokenizer.h"
+#include "eckit/utils/Translator.h"
 
-#include "odc/FastODA2Request.h"
-#include "odc/GribCodes.h"
+#include "odc/core/Span.h"
+#include "odc/core/Table.h"
+#include "odc/core/TablesReader.h"
 #include "odc/LibOdc.h"
-#include "odc/Select.h"
+#include "odc/ODBAPISettings.h"
 #include "odc/tools/ODA2RequestTool.h"
 
 using namespace std;
@@ -34,14 +41,14 @@ ODA2RequestTool::ODA2RequestTool(int argc, char **argv)
 : Tool(argc, argv)
 {
 	registerOptionWithArgument("-c");
-	readConfig();
+	registerOptionWithArgument("-nthreads");
 }
 
 ODA2RequestTool::ODA2RequestTool()
 : Tool(1, static_argv)
 {
 	registerOptionWithArgument("-c");
-	readConfig();
+	registerOptionWithArgument("-nthreads");
 }
 
 ODA2RequestTool::~ODA2RequestTool() {}
@@ -50,7 +57,11 @@ void ODA2RequestTool::help(std::ostream &o) { o << "Creates MARS ARCHIVE request
 
 void ODA2RequestTool::usage(const std::string& name, std::ostream &o)
 {
-	o << name << " [-c configFile] [-q] <input-file.odb> [<output-file>]";
+	o << name << " [-c configFile] [-nthreads <n>] <input-file.odb> [<output-file>]" << std::endl
+	  << std::endl
+	  << "\tThe values of the request keys are taken from the frame headers where the columns are constant," << std::endl
+	  << "\tand otherwise by decoding only those columns. Frames are processed on up to <n> threads" << std::endl
+	  << "\t(default: number of cores)." << std::endl;
 }
 
 void ODA2RequestTool::run()
@@ -69,13 +80,15 @@ void ODA2RequestTool::run()
 			Log::error() << "Usage: ";
 			usage(parameters(0), Log::error());
 			Log::error() << std::endl;
-			return;// 1;
-			break;
+			throw UserError("Expected 2 or 3 command line parameters");
 	}
 
+	long nthreads = optionArgument("-nthreads", long(std::max(1u, std::thread::hardware_concurrency())));
+	if (nthreads <= 0) throw UserError("-nthreads must be a positive number");
+
 	readConfig();
 
-	string request = generateMarsRequest(inputFile, optionIsSet("-q"));
+	string request = generateMarsRequest(inputFile, nthreads);
 
 	if (outputFile.size() == 0)
 		std::cout << request << std::endl;
@@ -129,63 +142,105 @@ void ODA2RequestTool::parseConfig(const std::string& s)
 	}
 }
 
-inline string int_as_double2string(double v)
-{
-	stringstream s;
-	s.precision(0);
-	s << fixed << v;
-	return s.str();
-}
+namespace {
+
+/// Collects the values of the request keys from a Span, in the order of the configured columns
+
+class SpanValues {
+public:
+	SpanValues(const std::vector<std::string>& columns, std::vector<std::set<std::string>>& values)
+	: columns_(columns), values_(values) {}
+
+	void operator()(const std::string& column, const std::set<long>& vals) {
+		for (long v : vals) values(column).insert(Translator<long, std::string>()(v));
+	}
+
+	void operator()(const std::string& column, const std::set<double>& vals) {
+		for (double v : vals) values(column).insert(Translator<double, std::string>()(v));
+	}
+
+	void operator()(const std::string& column, const std::set<std::string>& vals) {
+		for (const std::string& v : vals) values(column).insert(StringTools::trim(v));
+	}
+
+private:
+	std::set<std::string>& values(const std::string& column) {
+		auto it = std::find(columns_.begin(), columns_.end(), column);
+		ASSERT(it != columns_.end());
+		return values_[it - columns_.begin()];
+	}
+
+	const std::vector<std::string>& columns_;
+	std::vector<std::set<std::string>>& values_;
+};
 
-string ODA2RequestTool::gatherStatsFast(const PathName& inputFile)
-{
-	FastODA2Request<ODA2RequestClientTraits> o;
-	o.parseConfig(readFile(config()));
-	o.scanFile(inputFile);
-	return o.genRequest();
 }
 
-void ODA2RequestTool::gatherStats(const PathName& inputFile)
+/// The request keys are nearly always constant in each frame, and are then available from the
+/// frame headers. Only the frames (and columns) where they are not need to be decoded.
+
+void ODA2RequestTool::gatherStats(const PathName& inputFile, size_t nthreads)
 {
-	size_t n = columnName2requestKey_.size();
-	values_ = vector<Values>(n);
+	std::vector<std::string> columns;
+	for (const auto& kv : columnName2requestKey_) columns.push_back(kv.first);
 
-	string columnList;
-	for (std::map<string, string>::iterator it = columnName2requestKey_.begin();
-		 it != columnName2requestKey_.end();
-		 ++it)
-	{
-		if (it != columnName2requestKey_.begin())
-			columnList += ", ";
-		columnList += it->first;
+	std::vector<core::Table> tables;
+	core::TablesReader reader(inputFile);
+	for (auto it = reader.begin(); it != reader.end(); ++it) tables.emplace_back(*it);
+
+	std::vector<std::unique_ptr<core::Span>> spans(tables.size());
+
+	const bool integersAsDoubles = ODBAPISettings::instance().integersAsDoubles();
+
+	std::mutex guard_mutex;
+	std::vector<std::future<void>> threads;
+	size_t next_frame = 0;
+
+	nthreads = std::max<size_t>(1, std::min(nthreads, tables.size()));
+	for (size_t i = 0; i < nthreads; i++) {
+		threads.emplace_back(std::async(std::launch::async, [&] {
+
+			// Settings are thread specific
+			ODBAPISettings::instance().treatIntegersAsDoubles(integersAsDoubles);
+
+			while (true) {
+				size_t frame;
+
+				{
+					std::lock_guard<std::mutex> guard(guard_mutex);
+					if (next_frame < tables.size()) {
+						frame = next_frame++;
+					} else {
+						return;
+					}
+				}
+
+				spans[frame].reset(new core::Span(tables[frame].span(columns, false)));
+			}
+		}));
 	}
-	
-	const string select = std::string("select ") + columnList + " from \"" + inputFile + "\";";
-	Log::info() << "Executing '" << select << "'" << std::endl;
-
-	Translator<double, string> double2string;
-	odc::Select oda(select, inputFile);
-	odc::Select::iterator end = oda.end();
-	for (odc::Select::iterator row = oda.begin(); row != end; ++row) 
-		for (size_t i = 0; i < n; ++i)
-		{
-            odc::api::ColumnType type = row->columns()[i]->type();
-            Value v = type == odc::api::STRING ? (*row).string(i)
-                    : type == odc::api::INTEGER ? int_as_double2string((*row)[i])
-					: double2string((*row)[i]);
-			values_[i].insert(v);
-		}
+
+	// Waits for the threads. If any exceptions have been thrown, they get thrown into
+	// the main thread here.
+	for (auto& thread : threads) {
+		thread.get();
+	}
+
+	values_ = vector<Values>(columns.size());
+	if (spans.empty()) return;
+
+	for (size_t i = 1; i < spans.size(); ++i) spans[0]->extend(*spans[i]);
+
+	SpanValues visitor(columns, values_);
+	spans[0]->visit(visitor);
 }
 
-string ODA2RequestTool::generateMarsRequest(const PathName& inputFile, bool fast)
+string ODA2RequestTool::generateMarsRequest(const PathName& inputFile, size_t nthreads)
 {
 	stringstream request;
 
-	if (fast)
-		request << gatherStatsFast(inputFile);
-	else
 	{
-		gatherStats(inputFile);
+		gatherStats(inputFile, nthreads);
 
 		size_t i = 0;
 		std::map<string, string>::iterator end = columnName2requestKey_.end();
@@ -208,12 +263,10 @@ string ODA2RequestTool::generateMarsRequest(const PathName& inputFile, bool fast
 				if (k == "CLASS" || k == "TYPE" || k == "STREAM")
 				{
 					LOG_DEBUG_LIB(LibOdc) << "ODA2RequestTool::genRequest: checking if '" << v << "' is numeric" << std::endl;
+					// n.b. Numeric codes are not translated, as the GRIB code tables are not available here
 					if (StringTool::check(v, isdigit))
 					{
 						v = StringTools::trim(v);
-						LOG_DEBUG_LIB(LibOdc) << "ODA2RequestTool::genRequest: replacing " << v << " with ";
-						v = GribCodes::alphanumeric(StringTools::lower(key), v);
-						LOG_DEBUG_LIB(LibOdc) << v << std::endl;
 					}
 					v = StringTools::upper(v);
 				}
@@ -34,13 +34,12 @@ public:
 	void readConfig(const eckit::PathName&);
 	void parseConfig(const std::string&);
 
-    std::string generateMarsRequest(const eckit::PathName& inputFile, bool fast = false);
+    std::string generateMarsRequest(const eckit::PathName& inputFile, size_t nthreads = 1);
 
 protected:
 	std::vector<Values>& values() { return values_; }
 
-	void gatherStats(const eckit::PathName& inputFile);
-	std::string gatherStatsFast(const eckit::PathName& inputFile);
+	void gatherStats(const eckit::PathName& inputFile, size_t nthreads);
 
 	eckit::PathName config();
 
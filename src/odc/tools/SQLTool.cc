@@ -25,7 +25,9 @@
 #include "eckit/sql/SQLStatement.h"
 #include "eckit/types/Types.h"
 
+#include "odc/api/Odb.h"
 #include "odc/sql/SQLOutputConfig.h"
+#include "odc/sql/TablePredicate.h"
 #include "odc/sql/TODATable.h"
 #include "odc/tools/SQLTool.h"
 
@@ -106,6 +108,25 @@ void SQLTool::run()
                 : StringTool::readFile(params[0] == "-" ? "/dev/tty" : params[0]) + ";");
 
 
+    // Simple filters from one ODB file into another can copy (or skip) whole frames without decoding
+    // them, where the column ranges in the frame headers permit.
+
+    if (sqlOutputConfig_->outputFormat() == "odb" && !inputFile_.empty() &&
+            inputFile_ != "/dev/stdin" && inputFile_ != "stdin" && odc::sql::TablePredicate::parse(sql)) {
+
+        std::string outputFile = optionArgument("-o", std::string(""));
+        FileHandle out(outputFile == "-" ? "/dev/stdout" : outputFile);
+
+        if (offset_ == eckit::Offset(0)) {
+            odc::api::filter(sql, inputFile_, out);
+        } else {
+            PartFileHandle in(inputFile_, offset_, length_);
+            odc::api::filter(sql, in, out);
+        }
+        out.close();
+        return;
+    }
+
     std::unique_ptr<std::ofstream> outStream;
     if (optionIsSet("-o") && sqlOutputConfig_->outputFormat() != "odb") {
         outStream.reset(new std::ofstream(optionArgument("-o", std::string("")).c_str()));
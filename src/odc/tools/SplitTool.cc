@@ -10,20 +10,30 @@
 
 #include "SplitTool.h"
 
+#include <algorithm>
+#include <future>
 #include <ostream>
+#include <thread>
 
 #include "eckit/exception/Exceptions.h"
 #include "eckit/filesystem/PathName.h"
+#include "eckit/io/Buffer.h"
+#include "eckit/io/MemoryHandle.h"
 #include "eckit/io/PartFileHandle.h"
 #include "eckit/log/Log.h"
 #include "eckit/types/Types.h"
 
+#include "odc/core/Codec.h"
+#include "odc/core/Column.h"
 #include "odc/core/TablesReader.h"
 #include "odc/DispatchingWriter.h"
+#include "odc/ExternalSorter.h"
 #include "odc/LibOdc.h"
+#include "odc/ODBAPISettings.h"
 #include "odc/Reader.h"
 #include "odc/Select.h"
 #include "odc/TemplateParameters.h"
+#include "odc/Writer.h"
 
 using namespace eckit;
 using namespace std;
@@ -33,10 +43,16 @@ namespace tool {
 
 SplitTool::SplitTool (int argc, char *argv[])
 : Tool(argc, argv),
+  maxOpenFiles_(200),
   sort_(false),
-  maxOpenFiles_(200)
+  partitions_(0),
+  sortMemory_(512),
+  tmpDir_()
 {
 	registerOptionWithArgument("-maxopenfiles");
+	registerOptionWithArgument("-partitions");
+	registerOptionWithArgument("-sortmemory");
+	registerOptionWithArgument("-tmpdir");
 }
 
 void SplitTool::run()
@@ -56,11 +72,21 @@ void SplitTool::run()
 	maxOpenFiles_ = optionArgument("-maxopenfiles", maxOpenFiles_);
 	LOG_DEBUG_LIB(LibOdc) << "SplitTool: maxOpenFiles_ = " << maxOpenFiles_ << endl;
 
+	sortMemory_ = optionArgument("-sortmemory", sortMemory_);
+	tmpDir_ = optionArgument("-tmpdir", tmpDir_);
+	if (sortMemory_ <= 0) throw UserError("-sortmemory must be a positive number of megabytes");
+
+	partitions_ = optionArgument("-partitions", partitions_);
+	if (partitions_ < 0) throw UserError("-partitions must be a positive number");
+	if (partitions_ && sort_) throw UserError("-partitions and -sort are mutually exclusive");
+
 	PathName inFile (parameters(1));
 	string outFileTemplate (parameters(2));
 
 	if (sort_)
-		presortAndSplit(inFile, outFileTemplate);
+		presortAndSplit(inFile, outFileTemplate, size_t(sortMemory_) * 1024 * 1024, tmpDir_);
+	else if (partitions_)
+		partitionedSplit(inFile, outFileTemplate, partitions_, size_t(sortMemory_) * 1024 * 1024, tmpDir_);
 	else
 		split(inFile, outFileTemplate, maxOpenFiles_, !optionIsSet("-no_verification"));
 }
@@ -107,49 +133,210 @@ vector<pair<Offset,Length> > SplitTool::getChunks(const PathName& inFile, size_t
 	return r;
 }
 
-std::string SplitTool::genOrderBySelect(const std::string& inFile, const std::string& outFileTemplate)
+std::vector<std::string> SplitTool::sortKeys(const PathName& inFile, const std::string& outFileTemplate)
 {
     core::TablesReader reader(inFile);
     auto it = reader.begin();
     TemplateParameters templateParameters;
     TemplateParameters::parse(outFileTemplate, templateParameters, it->columns());
-    std::stringstream ss;
-	ss << "select * order by ";
+
+    std::vector<std::string> keys;
 	for (size_t i = 0; i < templateParameters.size(); ++i)
-	{
-		if (i) ss << ",";
-		ss << templateParameters[i]->name;
-	}
-	std::string sql (ss.str());
-	Log::info() << "SplitTool::genOrderBySelect: sql: '" << sql << "'" << endl;
-	return sql;
+		keys.push_back(templateParameters[i]->name);
+
+	Log::info() << "SplitTool::sortKeys: " << keys << endl;
+	return keys;
 }
 
-void SplitTool::presortAndSplit(const PathName& inFile, const std::string& outFileTemplate)
+/// Sort the input by the values that determine the output file, so that each output file is
+/// written in one pass, and only one file need be open at a time. The sort uses bounded memory,
+/// spilling sorted runs to temporary files in tmpDir.
+
+void SplitTool::presortAndSplit(const PathName& inFile, const std::string& outFileTemplate, size_t maxMemory, const PathName& tmpDir)
 {
 	odc::DispatchingWriter out(outFileTemplate, 1); 
 	odc::DispatchingWriter::iterator outIt (out.begin());
 
-	string sql(genOrderBySelect(inFile, outFileTemplate));
-	
-    vector<std::pair<Offset,Length> > chunks(getChunks(inFile));
-    for(size_t i=0; i < chunks.size(); ++i)
-    {   
-		PartFileHandle h(inFile, chunks[i].first, chunks[i].second);
-		h.openForRead();
-		AutoClose closer(h);
-		odc::Select in(sql, h);
-		outIt->pass1(in.begin(), in.end());
-    } 
+	odc::ExternalSorter sorter(sortKeys(inFile, outFileTemplate), maxMemory, tmpDir);
+	sorter.sort(inFile);
+	outIt->pass1(sorter.begin(), sorter.end());
 }
 
+/// Split into a large number of outputs, without holding each of them open.
+///
+/// i) The rows are distributed between a fixed number of temporary partition files, according to a
+///    hash of the values that determine the output file. All the rows for a given output end up in
+///    the same partition.
+///
+/// ii) The partitions are processed in parallel. Each is sorted by the output file values (using a
+///     bounded amount of memory), so that every output file is written exactly once, in large frames.
+
+void SplitTool::partitionedSplit(const PathName& inFile, const std::string& outFileTemplate, size_t partitions,
+                                 size_t maxMemory, const PathName& tmpDir)
+{
+    ASSERT(partitions > 0);
+
+    std::vector<std::string> keys(sortKeys(inFile, outFileTemplate));
+
+    std::string tmp(tmpDir);
+    if (tmp.empty()) {
+        const char* env = ::getenv("TMPDIR");
+        tmp = (env && *env) ? env : "/tmp";
+    }
+
+    std::vector<PathName> partitionFiles;
+    for (size_t i = 0; i < partitions; ++i) {
+        partitionFiles.push_back(PathName::unique(PathName(tmp) / "odc-split-partition") + ".odb");
+    }
+
+    struct RemoveFiles {
+        const std::vector<PathName>& files;
+        ~RemoveFiles() { for (const PathName& f : files) if (f.exists()) f.unlink(); }
+    } removeFiles{partitionFiles};
+
+    // Distribute the rows between the partitions
+
+    unsigned long long inputRows = 0;
+
+    {
+        std::vector<std::unique_ptr<odc::Writer<>>> writers;
+        std::vector<odc::Writer<>::iterator> outputs;
+        for (const PathName& path : partitionFiles) {
+            writers.emplace_back(new odc::Writer<>(path));
+            writers.back()->frameIndex(false); // n.b. temporary
+            outputs.push_back(writers.back()->begin());
+        }
+
+        odc::Reader in(inFile);
+        odc::Reader::iterator it(in.begin());
+        odc::Reader::iterator end(in.end());
+
+        core::MetaData columns;
+        TemplateParameters templateParameters;
+        DispatchValuesHash hasher;
+        std::vector<double> values(keys.size());
+
+        for (; it != end; ++it, ++inputRows) {
+
+            if (inputRows == 0 || (it->isNewDataset() && columns != it->columns())) {
+                columns = it->columns();
+                templateParameters.reset();
+                TemplateParameters::parse(outFileTemplate, templateParameters, columns);
+                ASSERT(templateParameters.size() == keys.size());
+                for (auto& out : outputs) {
+                    if (inputRows != 0) (**out).flush();
+                    (**out).columns(columns);
+                    (**out).writeHeader();
+                }
+            }
+
+            // n.b. Dispatch on exactly the values used by WriterDispatchingIterator
+
+            const double* data = it->data();
+            for (size_t i = 0; i < templateParameters.size(); ++i) {
+                values[i] = data[templateParameters[i]->columnIndex];
+            }
+
+            size_t partition = hasher(values) % partitions;
+            (**outputs[partition]).writeRow(data, columns.size());
+        }
+    }
+
+    Log::info() << "SplitTool::partitionedSplit: distributed " << inputRows << " rows into "
+                << partitions << " partitions" << endl;
+
+    // Sort and write out the partitions in parallel
+
+    const bool integersAsDoubles = ODBAPISettings::instance().integersAsDoubles();
+    const size_t nthreads = std::max<size_t>(1, std::min<size_t>(partitions, std::thread::hardware_concurrency()));
+
+    auto processPartition = [&](size_t i) -> unsigned long long {
+
+        // Settings are thread specific
+        ODBAPISettings::instance().treatIntegersAsDoubles(integersAsDoubles);
+
+        // The partitions are already sorted in parallel, so each sorter uses one sorting thread
+
+        const size_t maxFanIn = 64;
+        const size_t sortThreads = 1;
+        odc::ExternalSorter sorter(keys, std::max<size_t>(maxMemory / nthreads, 1024 * 1024), tmp, maxFanIn, sortThreads);
+        sorter.sort(partitionFiles[i]);
+        if (sorter.rowCount() == 0) return 0;
+
+        odc::DispatchingWriter out(outFileTemplate, 1);
+        odc::DispatchingWriter::iterator outIt(out.begin());
+        return outIt->pass1(sorter.begin(), sorter.end());
+    };
+
+    unsigned long long outputRows = 0;
+    for (size_t start = 0; start < partitions; start += nthreads) {
+        std::vector<std::future<unsigned long long>> results;
+        for (size_t i = start; i < std::min(start + nthreads, partitions); ++i) {
+            results.emplace_back(std::async(std::launch::async, processPartition, i));
+        }
+        for (auto& r : results) outputRows += r.get();
+    }
+
+    if (outputRows != inputRows) {
+        std::ostringstream ss;
+        ss << "Split wrote " << outputRows << " rows, but " << inputRows << " were read";
+        throw SeriousBug(ss.str(), Here());
+    }
+}
+
+/// Frames in which all the columns that determine the output file are constant can be appended to
+/// that file as they are, without being decoded. Only frames with mixed values are decoded and
+/// dispatched row by row.
+
 void SplitTool::split(const PathName& inFile, const std::string& outFileTemplate, size_t maxOpenFiles, bool verify)
 {
-	odc::Reader in(inFile);
 	odc::DispatchingWriter out(outFileTemplate, maxOpenFiles);
-
 	odc::DispatchingWriter::iterator outIt (out.begin());
-	outIt->pass1(in.begin(), in.end());
+
+	size_t copiedFrames = 0;
+	size_t decodedFrames = 0;
+
+	core::TablesReader reader(inFile);
+	for (core::Table& table : reader)
+	{
+		if (table.rowCount() == 0) continue;
+
+		const core::MetaData& columns (table.columns());
+		(**outIt).resetColumns(columns);
+
+		// Obtain the dispatch values exactly as they would be decoded
+
+		TemplateParameters& templateParameters ((**outIt).templateParameters());
+		std::vector<double> values(columns.size());
+		bool constant = true;
+		for (size_t i = 0; constant && i < templateParameters.size(); ++i)
+		{
+			core::Column& column (*columns[templateParameters[i]->columnIndex]);
+			constant = column.isConstant();
+			if (constant) column.coder().decode(&values[templateParameters[i]->columnIndex]);
+		}
+
+		const Buffer encoded (table.readEncodedData(true));
+
+		if (constant)
+		{
+			(**outIt).writeEncoded(&values[0], values.size(), encoded, encoded.size(), table.rowCount());
+			++copiedFrames;
+		}
+		else
+		{
+			MemoryHandle dh(encoded);
+			odc::Reader in(dh);
+			odc::Reader::iterator it (in.begin());
+			odc::Reader::iterator end (in.end());
+			for (; it != end; ++it)
+				ASSERT((**outIt).writeRow(it->data(), it->columns().size()) == 0);
+			++decodedFrames;
+		}
+	}
+
+	LOG_DEBUG_LIB(LibOdc) << "SplitTool::split: copied " << copiedFrames << " frame(s), decoded "
+	                      << decodedFrames << " frame(s)" << endl;
 
 	odc::Reader input(inFile);
 	odc::Reader::iterator begin(input.begin());
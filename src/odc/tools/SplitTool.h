@@ -35,11 +35,12 @@ public:
 
 	static void usage(const std::string& name, std::ostream &o)
 	{
-		o << name << " [-no_verification] [-maxopenfiles <N>] <input.odb> <output_template.odb>";
+		o << name << " [-no_verification] [-maxopenfiles <N>] [-sort | -partitions <N>] [-sortmemory <MB>] [-tmpdir <dir>] <input.odb> <output_template.odb>";
 	}
 
 	static void split(const eckit::PathName&, const std::string&, size_t, bool verify=true);
-	static void presortAndSplit(const eckit::PathName&, const std::string&);
+	static void presortAndSplit(const eckit::PathName&, const std::string&, size_t maxMemory, const eckit::PathName& tmpDir);
+	static void partitionedSplit(const eckit::PathName&, const std::string&, size_t partitions, size_t maxMemory, const eckit::PathName& tmpDir);
 
     static std::vector<std::pair<eckit::Offset,eckit::Length> > getChunks(const eckit::PathName&, size_t maxExpandedSize = 100*1024*1024);
 private:
@@ -47,10 +48,13 @@ private:
     SplitTool(const SplitTool&);
     SplitTool& operator=(const SplitTool&);
 
-	static std::string genOrderBySelect(const std::string&, const std::string&);
+	static std::vector<std::string> sortKeys(const eckit::PathName&, const std::string&);
 
 	long maxOpenFiles_;
 	bool sort_;
+	long partitions_;
+	long sortMemory_;
+	std::string tmpDir_;
 };
 
 } // namespace tool 
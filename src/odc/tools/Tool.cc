@@ -16,15 +16,18 @@
 
 #include <ostream>
 
+#include "odc/tools/CatTool.h"
 #include "odc/tools/CompactTool.h"
 #include "odc/tools/CompareTool.h"
 #include "odc/tools/CountTool.h"
+#include "odc/tools/ExtractTool.h"
 #include "odc/tools/IndexTool.h"
 #include "odc/tools/FixedSizeRowTool.h"
 #include "odc/tools/ImportTool.h"
 #include "odc/tools/LSTool.h"
 #include "odc/tools/MDSetTool.h"
 #include "odc/tools/MergeTool.h"
+#include "odc/tools/ODA2RequestTool.h"
 #include "odc/tools/ODAHeaderTool.h"
 #include "odc/tools/SQLTool.h"
 #include "odc/tools/SetTool.h"
@@ -47,15 +50,18 @@ Tool::Tool(const CommandLineParser& clp)
 
 void Tool::registerTools()
 {
+	static ToolFactory<CatTool> cat("cat");
 	static ToolFactory<CompactTool> compact("compact");
 	static ToolFactory<CompareTool> compare("compare");
 	static ToolFactory<CountTool> countTool("count");
+	static ToolFactory<ExtractTool> extract("extract");
 	static ToolFactory<IndexTool> indexTool("index");
 	static ToolFactory<FixedSizeRowTool> fixedSizeRow("fixrowsize");
     static ToolFactory<ImportTool> import("import");
 	static ToolFactory<LSTool> lsTool("ls");
 	static ToolFactory<MDSetTool> mdset("mdset");
 	static ToolFactory<MergeTool> mergeTool("merge");
+	static ToolFactory<ODA2RequestTool> oda2request("oda2request");
 	static ToolFactory<HeaderTool> odaHeader("header");
 	static ToolFactory<SQLTool> sqlTool("sql");
 	static ToolFactory<SetTool> set("set");
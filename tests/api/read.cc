@@ -8,14 +8,19 @@
  * does it submit to any jurisdiction.
  */
 
+#include <cstring>
 #include <fstream>
+#include <limits>
 #include <memory>
 
+#include "eckit/exception/Exceptions.h"
 #include "eckit/io/FileHandle.h"
 #include "eckit/testing/Test.h"
 
 #include "odc/api/odc.h"
 #include "odc/api/Odb.h"
+#include "odc/core/Exceptions.h"
+#include "odc/Select.h"
 
 using namespace eckit::testing;
 
@@ -1160,6 +1165,109 @@ CASE("Where Span interface is used to read values without decoding") {
     }
 }
 
+CASE("Where Span interface is used with dictionary encoded strings") {
+
+    // Define row count
+    const size_t nrows = 12;
+
+    char data0[nrows][16];
+    int64_t data1[nrows];
+
+    const char* statids[] = {"stat1", "station02", "stat1", "s3"};
+
+    for (size_t i = 0; i < nrows; i++) {
+        snprintf(data0[i], 16, "%s", statids[i % 4]);
+        data1[i] = 20210527;
+    }
+
+    std::vector<odc::api::ColumnInfo> columns = {
+        {std::string("statid@hdr"), odc::api::ColumnType(odc::api::STRING), 16},
+        {std::string("date@hdr"), odc::api::ColumnType(odc::api::INTEGER), sizeof(int64_t)},
+    };
+
+    std::vector<odc::api::ConstStridedData> strides {
+        {data0, nrows, 16, 16},
+        {data1, nrows, sizeof(int64_t), sizeof(int64_t)},
+    };
+
+    {
+        eckit::FileHandle fh("span-strings.odb");
+        fh.openForWrite(0);
+        eckit::AutoClose closer(fh);
+        encode(fh, columns, strides);
+    }
+
+    odc::api::Reader reader("span-strings.odb", false);
+    odc::api::Frame frame = reader.next();
+    EXPECT(frame);
+
+    odc::api::Span span = frame.span({"statid@hdr"}, false);
+    std::set<std::string> expected {"stat1", "station02", "s3"};
+    EXPECT(span.getStringValues("statid@hdr") == expected);
+}
+
+CASE("Where Span interface is used on the frames of an aggregated frame in parallel") {
+
+    odc::api::Settings::treatIntegersAsDoubles(false);
+
+    // Three frames of four rows
+
+    const size_t nrows = 12;
+
+    int64_t data0[nrows];
+    double data1[nrows];
+    char data2[nrows][8];
+
+    const char* statids[] = {"stat1", "stat2", "stat3"};
+
+    std::set<long> expectedIntegers;
+    std::set<double> expectedReals;
+    std::set<std::string> expectedStrings;
+
+    for (size_t i = 0; i < nrows; i++) {
+        data0[i] = 20210527 + (i % 5);
+        data1[i] = 0.5 * (i % 3);
+        snprintf(data2[i], 8, "%s", statids[i % 3]);
+        expectedIntegers.insert(data0[i]);
+        expectedReals.insert(data1[i]);
+        expectedStrings.insert(statids[i % 3]);
+    }
+
+    std::vector<odc::api::ColumnInfo> columns = {
+        {std::string("date@hdr"), odc::api::ColumnType(odc::api::INTEGER), sizeof(int64_t)},
+        {std::string("obsvalue@body"), odc::api::ColumnType(odc::api::REAL), sizeof(double)},
+        {std::string("statid@hdr"), odc::api::ColumnType(odc::api::STRING), 8},
+    };
+
+    std::vector<odc::api::ConstStridedData> strides {
+        {data0, nrows, sizeof(int64_t), sizeof(int64_t)},
+        {data1, nrows, sizeof(double), sizeof(double)},
+        {data2, nrows, 8, 8},
+    };
+
+    {
+        eckit::FileHandle fh("span-parallel.odb");
+        fh.openForWrite(0);
+        eckit::AutoClose closer(fh);
+        encode(fh, columns, strides, {}, 4);
+    }
+
+    odc::api::Reader reader("span-parallel.odb");
+    odc::api::Frame frame = reader.next();
+    EXPECT(frame.rowCount() == nrows);
+
+    std::vector<std::string> cols {"date@hdr", "obsvalue@body", "statid@hdr"};
+
+    odc::api::Span span = frame.span(cols, false, 4);
+    EXPECT(span == frame.span(cols, false));
+    EXPECT(span.offset() == frame.offset());
+    EXPECT(span.length() == frame.length());
+
+    EXPECT(span.getIntegerValues("date@hdr") == expectedIntegers);
+    EXPECT(span.getRealValues("obsvalue@body") == expectedReals);
+    EXPECT(span.getStringValues("statid@hdr") == expectedStrings);
+}
+
 // ------------------------------------------------------------------------------------------------------
 
 CASE("Filter a subset of ODB-2 data") {
@@ -1235,6 +1343,807 @@ CASE("Filter a subset of ODB-2 data") {
 
 // ------------------------------------------------------------------------------------------------------
 
+CASE("Decode columns into narrower output types") {
+
+    odc::api::Settings::treatIntegersAsDoubles(false);
+
+    odc::api::Reader reader("../2000010106-reduced.odb", false);
+    odc::api::Frame frame = reader.next();
+    size_t nrows = frame.rowCount();
+
+    std::vector<std::string> columns {"varno@body", "date@hdr", "obsvalue@body", "lat@hdr"};
+
+    // Decode the default 8-byte representation
+
+    std::vector<int64_t> varno(nrows);
+    std::vector<int64_t> date(nrows);
+    std::vector<double> obsvalue(nrows);
+    std::vector<double> lat(nrows);
+
+    std::vector<odc::api::StridedData> strides {
+        {&varno[0], nrows, sizeof(int64_t), sizeof(int64_t)},
+        {&date[0], nrows, sizeof(int64_t), sizeof(int64_t)},
+        {&obsvalue[0], nrows, sizeof(double), sizeof(double)},
+        {&lat[0], nrows, sizeof(double), sizeof(double)},
+    };
+
+    odc::api::Decoder(columns, strides).decode(frame);
+
+    // And the same columns as narrower types
+
+    std::vector<int16_t> varno16(nrows);
+    std::vector<int32_t> date32(nrows);
+    std::vector<float> obsvalue32(nrows);
+    std::vector<double> lat64(nrows);
+
+    std::vector<odc::api::StridedData> typedStrides {
+        {&varno16[0], nrows, sizeof(int16_t), sizeof(int16_t)},
+        {&date32[0], nrows, sizeof(int32_t), sizeof(int32_t)},
+        {&obsvalue32[0], nrows, sizeof(float), sizeof(float)},
+        {&lat64[0], nrows, sizeof(double), sizeof(double)},
+    };
+
+    odc::api::Decoder decoder(columns, typedStrides);
+    decoder.setType(0, odc::api::DECODE_INT16);
+    decoder.setType(1, odc::api::DECODE_INT32);
+    decoder.setType(2, odc::api::DECODE_FLOAT32);
+    decoder.setType(3, odc::api::DECODE_FLOAT64);
+    decoder.decode(frame);
+
+    // Missing integers don't fit into 16 bits
+
+    const long missing = odc::api::Settings::integerMissingValue();
+    auto narrowed = [missing](int64_t v) { return (v == missing) ? std::numeric_limits<int16_t>::max() : v; };
+
+    for (size_t i = 0; i < nrows; ++i) {
+        EXPECT(varno16[i] == narrowed(varno[i]));
+        EXPECT(date32[i] == date[i]);
+        EXPECT(obsvalue32[i] == static_cast<float>(obsvalue[i]));
+        EXPECT(lat64[i] == lat[i]);
+    }
+
+    // The types also apply to ranges of rows
+
+    odc::api::Decoder rangeDecoder(columns, typedStrides);
+    rangeDecoder.setType(0, odc::api::DECODE_INT16);
+    rangeDecoder.setType(1, odc::api::DECODE_INT32);
+    rangeDecoder.setType(2, odc::api::DECODE_FLOAT32);
+    rangeDecoder.setType(3, odc::api::DECODE_FLOAT64);
+    rangeDecoder.decode(frame, 2000, 100, 3);
+
+    for (size_t i = 0; i < 100; ++i) {
+        EXPECT(varno16[i] == narrowed(varno[2000 + 3 * i]));
+        EXPECT(date32[i] == date[2000 + 3 * i]);
+    }
+
+    // Values that don't fit, and real values into integers, are rejected
+
+    std::vector<int16_t> date16(nrows);
+    std::vector<odc::api::StridedData> badStrides {{&date16[0], nrows, sizeof(int16_t), sizeof(int16_t)}};
+
+    odc::api::Decoder narrowDecoder({"date@hdr"}, badStrides);
+    narrowDecoder.setType(0, odc::api::DECODE_INT16);
+    EXPECT_THROWS_AS(narrowDecoder.decode(frame), odc::core::ODBDecodeError);
+
+    odc::api::Decoder realDecoder({"obsvalue@body"}, badStrides);
+    realDecoder.setType(0, odc::api::DECODE_INT16);
+    EXPECT_THROWS_AS(realDecoder.decode(frame), odc::core::ODBDecodeError);
+}
+
+CASE("Decode string columns as dictionary codes") {
+
+    for (bool aggregated : {false, true}) {
+        for (size_t nthreads : {1, 3}) {
+
+            odc::api::Reader reader("../2000010106-reduced.odb", aggregated);
+            odc::api::Frame frame = reader.next();
+            size_t nrows = frame.rowCount();
+
+            std::vector<std::string> columns {"statid@hdr", "expver@desc"};
+
+            size_t width = 0;
+            for (const auto& col : frame.columnInfo()) {
+                if (col.name == "statid@hdr") width = col.decodedSize;
+            }
+            EXPECT(width >= 8);
+
+            // Decode the strings, and then the codes
+
+            std::vector<char> statid(nrows * width);
+            std::vector<char> expver(nrows * 8);
+            std::vector<odc::api::StridedData> strides {
+                {&statid[0], nrows, width, width},
+                {&expver[0], nrows, 8, 8},
+            };
+            odc::api::Decoder(columns, strides).decode(frame, nthreads);
+
+            std::vector<int64_t> statidCodes(nrows);
+            std::vector<int16_t> expverCodes(nrows);
+            std::vector<odc::api::StridedData> codeStrides {
+                {&statidCodes[0], nrows, sizeof(int64_t), sizeof(int64_t)},
+                {&expverCodes[0], nrows, sizeof(int16_t), sizeof(int16_t)},
+            };
+
+            odc::api::Decoder decoder(columns, codeStrides);
+            decoder.decodeCodes(0);
+            decoder.decodeCodes(1);
+            decoder.setType(1, odc::api::DECODE_INT16);
+            decoder.decode(frame, nthreads);
+
+            const std::vector<std::string>& statids(decoder.dictionary(0));
+            const std::vector<std::string>& expvers(decoder.dictionary(1));
+
+            EXPECT(statids.size() > 1);
+            EXPECT(!expvers.empty());
+
+            for (size_t i = 0; i < nrows; ++i) {
+                const char* s = &statid[i * width];
+                EXPECT(statids.at(statidCodes[i]) == std::string(s, ::strnlen(s, width)));
+                s = &expver[i * 8];
+                EXPECT(expvers.at(expverCodes[i]) == std::string(s, ::strnlen(s, 8)));
+            }
+
+            // Numerical columns have no dictionary
+
+            std::vector<int64_t> dates(nrows);
+            std::vector<odc::api::StridedData> dateStrides {{&dates[0], nrows, sizeof(int64_t), sizeof(int64_t)}};
+            odc::api::Decoder dateDecoder({"date@hdr"}, dateStrides);
+            dateDecoder.decodeCodes(0);
+            EXPECT_THROWS_AS(dateDecoder.decode(frame), odc::core::ODBDecodeError);
+        }
+    }
+}
+
+CASE("Dictionary codes of constant and dictionary encoded strings do not depend on the threads") {
+
+    // Frames of 5 rows alternate between a constant string (constant_string) and several
+    // strings (int8_string). Some of the constants first appear in the frame that follows them.
+
+    const size_t nrows = 40;
+    const char* constants[] {"first", "shared", "third", "last"};
+    std::vector<char> strings(nrows * 8, 0);
+
+    for (size_t i = 0; i < nrows; ++i) {
+        size_t frame = i / 5;
+        std::string value;
+        if (frame % 2 == 0) {
+            value = constants[frame / 2];
+        } else {
+            value = (i % 2 == 0) ? constants[(frame / 2 + 1) % 4] : ("v" + std::to_string(i % 3));
+        }
+        ::memcpy(&strings[i * 8], value.c_str(), value.size());
+    }
+
+    std::vector<odc::api::ColumnInfo> columns = {
+        {std::string("strings"), odc::api::ColumnType(odc::api::STRING), 8},
+    };
+    std::vector<odc::api::ConstStridedData> strides {{&strings[0], nrows, 8, 8}};
+
+    {
+        eckit::FileHandle fh("mixed-strings.odb");
+        fh.openForWrite(0);
+        eckit::AutoClose closer(fh);
+        encode(fh, columns, strides, {}, 5);
+    }
+
+    std::vector<std::vector<int64_t>> codes;
+    std::vector<std::vector<std::string>> dictionaries;
+
+    for (size_t nthreads : {1, 4}) {
+
+        odc::api::Reader reader("mixed-strings.odb", true);
+        odc::api::Frame frame = reader.next();
+        EXPECT(frame.rowCount() == nrows);
+
+        codes.emplace_back(nrows);
+        std::vector<odc::api::StridedData> codeStrides {{&codes.back()[0], nrows, sizeof(int64_t), sizeof(int64_t)}};
+        odc::api::Decoder decoder({"strings"}, codeStrides);
+        decoder.decodeCodes(0);
+        decoder.decode(frame, nthreads);
+        dictionaries.push_back(decoder.dictionary(0));
+
+        for (size_t i = 0; i < nrows; ++i) {
+            const char* s = &strings[i * 8];
+            EXPECT(dictionaries.back().at(codes.back()[i]) == std::string(s, ::strnlen(s, 8)));
+        }
+    }
+
+    EXPECT(codes[0] == codes[1]);
+    EXPECT(dictionaries[0] == dictionaries[1]);
+}
+
+CASE("Encode and decode validity bitmaps in place of missing values") {
+
+    odc::api::Settings::treatIntegersAsDoubles(false);
+
+    // Every third row of the integers, and every fourth of the reals, is missing. The data in
+    // those rows is not used.
+
+    const size_t nrows = 21;
+    int64_t ints[nrows];
+    double reals[nrows];
+    unsigned char intValidity[(nrows + 7) / 8] = {0};
+    unsigned char realValidity[(nrows + 7) / 8] = {0};
+
+    for (size_t i = 0; i < nrows; ++i) {
+        ints[i] = i;
+        reals[i] = 0.5 * i;
+        if (i % 3 != 0) intValidity[i / 8] |= (1 << (i % 8));
+        if (i % 4 != 0) realValidity[i / 8] |= (1 << (i % 8));
+    }
+
+    std::vector<odc::api::ColumnInfo> columns = {
+        {std::string("ints"), odc::api::ColumnType(odc::api::INTEGER), sizeof(int64_t)},
+        {std::string("reals"), odc::api::ColumnType(odc::api::DOUBLE), sizeof(double)},
+    };
+
+    std::vector<odc::api::ConstStridedData> strides {
+        {ints, nrows, sizeof(int64_t), sizeof(int64_t)},
+        {reals, nrows, sizeof(double), sizeof(double)},
+    };
+
+    {
+        eckit::FileHandle fh("validity.odb");
+        fh.openForWrite(0);
+        eckit::AutoClose closer(fh);
+        encode(fh, columns, strides, {}, 5, {odc::api::ConstValidityBitmap(intValidity),
+                                             odc::api::ConstValidityBitmap(realValidity)});
+    }
+
+    // Frames of 5 rows don't align with the bytes of the bitmaps
+
+    for (size_t nthreads : {1, 3}) {
+
+        odc::api::Reader reader("validity.odb", true);
+        odc::api::Frame frame = reader.next();
+        EXPECT(frame.rowCount() == nrows);
+
+        std::vector<int64_t> outInts(nrows);
+        std::vector<double> outReals(nrows);
+        std::vector<unsigned char> outIntValidity((nrows + 7) / 8, 0xff);
+        std::vector<unsigned char> outRealValidity((nrows + 7) / 8, 0);
+
+        std::vector<odc::api::StridedData> outStrides {
+            {&outInts[0], nrows, sizeof(int64_t), sizeof(int64_t)},
+            {&outReals[0], nrows, sizeof(double), sizeof(double)},
+        };
+
+        odc::api::Decoder decoder({"ints", "reals"}, outStrides);
+        decoder.setValidity(0, odc::api::ValidityBitmap(&outIntValidity[0]));
+        decoder.setValidity(1, odc::api::ValidityBitmap(&outRealValidity[0]));
+        decoder.decode(frame, nthreads);
+
+        odc::api::ConstValidityBitmap intBits(&outIntValidity[0]);
+        odc::api::ConstValidityBitmap realBits(&outRealValidity[0]);
+
+        for (size_t i = 0; i < nrows; ++i) {
+            EXPECT(intBits.valid(i) == (i % 3 != 0));
+            EXPECT(realBits.valid(i) == (i % 4 != 0));
+            EXPECT(outInts[i] == ((i % 3 != 0) ? int64_t(i) : odc::api::Settings::integerMissingValue()));
+            EXPECT(outReals[i] == ((i % 4 != 0) ? 0.5 * i : odc::api::Settings::doubleMissingValue()));
+        }
+
+        // And for a range of rows
+
+        std::fill(outIntValidity.begin(), outIntValidity.end(), 0);
+        decoder.decode(frame, 4, 6, 2);
+        for (size_t i = 0; i < 6; ++i) {
+            EXPECT(intBits.valid(i) == ((4 + 2 * i) % 3 != 0));
+        }
+    }
+}
+
+CASE("Export frames to, and encode them from, the Arrow C data interface") {
+
+    odc::api::Settings::treatIntegersAsDoubles(false);
+
+    // Every third integer is missing. The strings repeat, so are dictionary encoded.
+
+    const size_t nrows = 10;
+    int64_t ints[nrows];
+    double reals[nrows];
+    char strings[nrows][8];
+    unsigned char intValidity[(nrows + 7) / 8] = {0};
+    const char* names[] = {"abc", "defghijk", "lm"};
+
+    for (size_t i = 0; i < nrows; ++i) {
+        ints[i] = 10 * i;
+        reals[i] = 0.25 * i;
+        ::strncpy(strings[i], names[i % 3], 8);
+        if (i % 3 != 0) intValidity[i / 8] |= (1 << (i % 8));
+    }
+
+    std::vector<odc::api::ColumnInfo> columns = {
+        {std::string("ints@hdr"), odc::api::ColumnType(odc::api::INTEGER), sizeof(int64_t)},
+        {std::string("reals@body"), odc::api::ColumnType(odc::api::DOUBLE), sizeof(double)},
+        {std::string("strings@hdr"), odc::api::ColumnType(odc::api::STRING), 8},
+    };
+
+    std::vector<odc::api::ConstStridedData> strides {
+        {ints, nrows, sizeof(int64_t), sizeof(int64_t)},
+        {reals, nrows, sizeof(double), sizeof(double)},
+        {strings, nrows, 8, 8},
+    };
+
+    {
+        eckit::FileHandle fh("arrow.odb");
+        fh.openForWrite(0);
+        eckit::AutoClose closer(fh);
+        encode(fh, columns, strides, {{"origin", "arrow-test"}}, 4,
+               {odc::api::ConstValidityBitmap(intValidity), odc::api::ConstValidityBitmap(), odc::api::ConstValidityBitmap()});
+    }
+
+    odc::api::Reader reader("arrow.odb", true);
+    odc::api::Frame frame = reader.next();
+    EXPECT(frame.rowCount() == nrows);
+
+    ArrowSchema schema;
+    ArrowArray array;
+    frame.exportArrow(&schema, &array, {}, 2);
+
+    EXPECT(std::string(schema.format) == "+s");
+    EXPECT(schema.n_children == 3);
+    EXPECT(array.n_children == 3);
+    EXPECT(array.length == nrows);
+
+    EXPECT(std::string(schema.children[0]->name) == "ints@hdr");
+    EXPECT(std::string(schema.children[0]->format) == "l");
+    EXPECT(std::string(schema.children[1]->format) == "g");
+    EXPECT(std::string(schema.children[2]->format) == "i");
+    EXPECT(std::string(schema.children[2]->dictionary->format) == "u");
+
+    const ArrowArray& intArray(*array.children[0]);
+    const ArrowArray& realArray(*array.children[1]);
+    const ArrowArray& stringArray(*array.children[2]);
+    EXPECT(intArray.null_count == 4);
+    EXPECT(realArray.null_count == 0);
+
+    odc::api::ConstValidityBitmap exportedValidity(intArray.buffers[0]);
+    const int64_t* exportedInts = static_cast<const int64_t*>(intArray.buffers[1]);
+    const double* exportedReals = static_cast<const double*>(realArray.buffers[1]);
+    const int32_t* codes = static_cast<const int32_t*>(stringArray.buffers[1]);
+    const int32_t* offsets = static_cast<const int32_t*>(stringArray.dictionary->buffers[1]);
+    const char* chars = static_cast<const char*>(stringArray.dictionary->buffers[2]);
+    EXPECT(stringArray.dictionary->length == 3);
+
+    for (size_t i = 0; i < nrows; ++i) {
+        EXPECT(exportedValidity.valid(i) == (i % 3 != 0));
+        if (i % 3 != 0) EXPECT(exportedInts[i] == int64_t(10 * i));
+        EXPECT(exportedReals[i] == 0.25 * i);
+        std::string s(&chars[offsets[codes[i]]], offsets[codes[i] + 1] - offsets[codes[i]]);
+        EXPECT(s == names[i % 3]);
+    }
+
+    // Encoding the arrays reproduces the data, missing values and properties
+
+    {
+        eckit::FileHandle fh("arrow2.odb");
+        fh.openForWrite(0);
+        eckit::AutoClose closer(fh);
+        odc::api::encodeArrow(fh, schema, array, {}, 3);
+    }
+
+    schema.release(&schema);
+    array.release(&array);
+    EXPECT(!schema.release);
+    EXPECT(!array.release);
+
+    odc::api::Reader reader2("arrow2.odb", true);
+    odc::api::Frame frame2 = reader2.next();
+    EXPECT(frame2.rowCount() == nrows);
+    EXPECT(frame2.properties().at("origin") == "arrow-test");
+
+    std::vector<int64_t> outInts(nrows);
+    std::vector<double> outReals(nrows);
+    std::vector<char> outStrings(nrows * 8);
+    std::vector<odc::api::StridedData> outStrides {
+        {&outInts[0], nrows, sizeof(int64_t), sizeof(int64_t)},
+        {&outReals[0], nrows, sizeof(double), sizeof(double)},
+        {&outStrings[0], nrows, 8, 8},
+    };
+    odc::api::Decoder({"ints", "reals", "strings"}, outStrides).decode(frame2);
+
+    for (size_t i = 0; i < nrows; ++i) {
+        EXPECT(outInts[i] == ((i % 3 != 0) ? int64_t(10 * i) : odc::api::Settings::integerMissingValue()));
+        EXPECT(outReals[i] == 0.25 * i);
+        EXPECT(std::string(&outStrings[i * 8], ::strnlen(&outStrings[i * 8], 8)) == names[i % 3]);
+    }
+
+    // A subset of the columns, selected without their table names
+
+    frame.exportArrow(&schema, &array, {"reals"});
+    EXPECT(schema.n_children == 1);
+    EXPECT(std::string(schema.children[0]->name) == "reals@body");
+    schema.release(&schema);
+    array.release(&array);
+
+    EXPECT_THROWS_AS(frame.exportArrow(&schema, &array, {"absent"}), eckit::UserError);
+}
+
+CASE("Filter frames accepted or rejected wholesale by their column ranges") {
+
+    // Three frames of four rows. The first is entirely accepted by the filter, the second entirely
+    // rejected, and the third needs to be filtered row by row.
+
+    const size_t nrows = 12;
+    int64_t data0[nrows];
+    double data1[nrows];
+
+    for (size_t i = 0; i < nrows; i++) {
+        data0[i] = (i < 4) ? 20210527 : (i < 8 ? 20210528 : 20210527 + (i % 2));
+        data1[i] = 1.5 * i;
+    }
+
+    std::vector<odc::api::ColumnInfo> columns = {
+        {std::string("date@hdr"), odc::api::ColumnType(odc::api::INTEGER), sizeof(int64_t)},
+        {std::string("obsvalue@body"), odc::api::ColumnType(odc::api::DOUBLE), sizeof(double)},
+    };
+
+    std::vector<odc::api::ConstStridedData> strides {
+        {data0, nrows, sizeof(int64_t), sizeof(int64_t)},
+        {data1, nrows, sizeof(double), sizeof(double)},
+    };
+
+    {
+        eckit::FileHandle fh("filter-frames.odb");
+        fh.openForWrite(0);
+        eckit::AutoClose closer(fh);
+        encode(fh, columns, strides, {}, 4);
+    }
+
+    {
+        eckit::FileHandle in("filter-frames.odb");
+        eckit::FileHandle out("filter-frames-filtered.odb");
+        EXPECT(odc::api::filter("select * where date@hdr = 20210527", in, out) == 6);
+    }
+
+    odc::api::Reader reader("filter-frames-filtered.odb", false);
+
+    std::vector<double> obsvalues;
+    while (odc::api::Frame frame = reader.next()) {
+
+        std::vector<int64_t> dates(frame.rowCount());
+        std::vector<double> values(frame.rowCount());
+        std::vector<odc::api::StridedData> outStrides {
+            {&dates[0], dates.size(), sizeof(int64_t), sizeof(int64_t)},
+            {&values[0], values.size(), sizeof(double), sizeof(double)},
+        };
+
+        odc::api::Decoder decoder({"date@hdr", "obsvalue@body"}, outStrides);
+        decoder.decode(frame);
+
+        for (size_t i = 0; i < dates.size(); ++i) {
+            EXPECT(dates[i] == 20210527);
+            obsvalues.push_back(values[i]);
+        }
+    }
+
+    std::vector<double> expected {0.0, 1.5, 3.0, 4.5, 12.0, 15.0};
+    EXPECT(obsvalues == expected);
+
+    // The same result is obtained when filtering a Frame
+
+    odc::api::Reader frameReader("filter-frames.odb");
+    odc::api::Frame frame = frameReader.next();
+    EXPECT(frame.rowCount() == 12);
+    EXPECT(frame.filter("select * where date@hdr = 20210527").rowCount() == 6);
+    EXPECT(frame.filter("select * where date@hdr >= 20210527").rowCount() == 12);
+}
+
+CASE("Filtered frames decode as their encoded data would") {
+
+    odc::api::Settings::treatIntegersAsDoubles(false);
+
+    // Decode a range of rows of all the columns of a frame into row-major buffers
+
+    auto decodeRows = [](odc::api::Frame& frame, size_t firstRow, size_t stride) {
+
+        size_t rowSize = 0;
+        std::vector<std::string> columns;
+        for (const auto& col : frame.columnInfo()) {
+            columns.push_back(col.name);
+            rowSize += col.decodedSize;
+        }
+
+        size_t nrows = (frame.rowCount() - firstRow + stride - 1) / stride;
+        std::vector<char> buffer(nrows * rowSize, 0);
+
+        std::vector<odc::api::StridedData> strides;
+        size_t offset = 0;
+        for (const auto& col : frame.columnInfo()) {
+            strides.emplace_back(&buffer[offset], nrows, col.decodedSize, rowSize);
+            offset += col.decodedSize;
+        }
+
+        odc::api::Decoder decoder(columns, strides);
+        if (firstRow == 0 && stride == 1) {
+            decoder.decode(frame);
+        } else {
+            decoder.decode(frame, firstRow, nrows, stride);
+        }
+        return buffer;
+    };
+
+    auto sameColumns = [](const std::vector<odc::api::ColumnInfo>& lhs, const std::vector<odc::api::ColumnInfo>& rhs) {
+        if (lhs.size() != rhs.size()) return false;
+        for (size_t i = 0; i < lhs.size(); ++i) {
+            if (lhs[i].name != rhs[i].name || lhs[i].type != rhs[i].type ||
+                lhs[i].decodedSize != rhs[i].decodedSize || lhs[i].bitfield.size() != rhs[i].bitfield.size()) return false;
+            for (size_t b = 0; b < lhs[i].bitfield.size(); ++b) {
+                if (lhs[i].bitfield[b].name != rhs[i].bitfield[b].name ||
+                    lhs[i].bitfield[b].size != rhs[i].bitfield[b].size ||
+                    lhs[i].bitfield[b].offset != rhs[i].bitfield[b].offset) return false;
+            }
+        }
+        return true;
+    };
+
+    odc::api::Reader reader("../2000010106-reduced.odb");
+    odc::api::Frame frame = reader.next();
+
+    // Queries handled by the table predicates (including on strings), and by the SQL engine
+
+    for (const char* sql : {"select * where obsvalue > 250",
+                            "select * where obsvalue > 250 and statid@hdr <> 'nostat'",
+                            "select * where obsvalue > 250 or obsvalue < 200",
+                            "select lat, lon, expver, obsvalue where obsvalue < 250"}) {
+
+        odc::api::Frame filtered = frame.filter(sql);
+        EXPECT(filtered.rowCount() > 0);
+
+        std::vector<odc::api::ColumnInfo> columns = filtered.columnInfo();
+        std::vector<char> decoded = decodeRows(filtered, 0, 1);
+        std::vector<char> strided = decodeRows(filtered, 1, 3);
+
+        // The encoded form of the filtered frame is only produced on request
+
+        {
+            eckit::Buffer encoded = filtered.encodedData();
+            eckit::FileHandle fh("filter-columns.odb");
+            fh.openForWrite(0);
+            eckit::AutoClose closer(fh);
+            EXPECT(fh.write(encoded, encoded.size()) == long(encoded.size()));
+        }
+
+        odc::api::Reader encodedReader("filter-columns.odb");
+        odc::api::Frame encodedFrame = encodedReader.next();
+        EXPECT(!encodedReader.next());
+
+        EXPECT(encodedFrame.rowCount() == filtered.rowCount());
+        EXPECT(encodedFrame.columnCount() == filtered.columnCount());
+        EXPECT(sameColumns(encodedFrame.columnInfo(), columns));
+        EXPECT(decodeRows(encodedFrame, 0, 1) == decoded);
+        EXPECT(decodeRows(encodedFrame, 1, 3) == strided);
+
+        // Once encoded, the filtered frame decodes from the encoded data, with the same columns
+
+        EXPECT(sameColumns(filtered.columnInfo(), columns));
+        EXPECT(decodeRows(filtered, 0, 1) == decoded);
+    }
+}
+
+CASE("Filter on dictionary encoded strings by their codes") {
+
+    odc::api::Settings::treatIntegersAsDoubles(false);
+
+    // Three frames of four rows. The first has a constant string, the second never matches, and in
+    // the third the rows are selected by their dictionary codes.
+
+    const size_t nrows = 12;
+
+    char data0[nrows][8];
+    int64_t data1[nrows];
+
+    const char* statids[] = {"stat1", "stat1", "stat1", "stat1",
+                             "stat2", "stat3", "stat2", "stat3",
+                             "stat1", "stat2", "stat3", "stat1"};
+
+    for (size_t i = 0; i < nrows; i++) {
+        snprintf(data0[i], 8, "%s", statids[i]);
+        data1[i] = i;
+    }
+
+    std::vector<odc::api::ColumnInfo> columns = {
+        {std::string("statid@hdr"), odc::api::ColumnType(odc::api::STRING), 8},
+        {std::string("seqno@hdr"), odc::api::ColumnType(odc::api::INTEGER), sizeof(int64_t)},
+    };
+
+    std::vector<odc::api::ConstStridedData> strides {
+        {data0, nrows, 8, 8},
+        {data1, nrows, sizeof(int64_t), sizeof(int64_t)},
+    };
+
+    {
+        eckit::FileHandle fh("filter-dictionary.odb");
+        fh.openForWrite(0);
+        eckit::AutoClose closer(fh);
+        encode(fh, columns, strides, {}, 4);
+    }
+
+    odc::api::Reader reader("filter-dictionary.odb");
+    odc::api::Frame frame = reader.next();
+
+    std::vector<std::pair<std::string, std::vector<int64_t>>> queries {
+        {"where statid@hdr = 'stat1'", {0, 1, 2, 3, 8, 11}},
+        {"where statid@hdr <> 'stat1'", {4, 5, 6, 7, 9, 10}},
+        {"where statid@hdr in ('stat2', 'stat3') and seqno@hdr > 5", {6, 7, 9, 10}},
+        {"where statid@hdr like 'at[13]'", {0, 1, 2, 3, 5, 7, 8, 10, 11}},
+    };
+
+    for (const auto& query : queries) {
+
+        odc::api::Frame filtered = frame.filter("select * " + query.first);
+        EXPECT(filtered.rowCount() == query.second.size());
+
+        std::vector<int64_t> seqnos(filtered.rowCount());
+        std::vector<odc::api::StridedData> outStrides {
+            {&seqnos[0], seqnos.size(), sizeof(int64_t), sizeof(int64_t)},
+        };
+
+        odc::api::Decoder decoder({"seqno@hdr"}, outStrides);
+        decoder.decode(filtered);
+        EXPECT(seqnos == query.second);
+
+        // The same rows are selected by the SQL engine from the encoded data
+
+        std::vector<int64_t> selected;
+        odc::Select select("select seqno@hdr from \"filter-dictionary.odb\" " + query.first + ";");
+        for (odc::Select::iterator it = select.begin(); it != select.end(); ++it) {
+            selected.push_back(static_cast<int64_t>((*it)[0]));
+        }
+        EXPECT(selected == query.second);
+    }
+}
+
+CASE("Column statistics are combined from the headers of the frames") {
+
+    odc::api::Settings::treatIntegersAsDoubles(false);
+
+    // Two frames of four rows
+
+    const size_t nrows = 8;
+    const double missing = odc::api::Settings::doubleMissingValue();
+
+    int64_t data0[nrows];
+    int64_t data1[nrows];
+    double data2[nrows];
+    char data3[nrows][8];
+
+    for (size_t i = 0; i < nrows; i++) {
+        data0[i] = 20210527;
+        data1[i] = (i < 4) ? 1 : 2;
+        data2[i] = (i == 5) ? missing : 0.1 * i;
+        ::strncpy(data3[i], "abc", 8);
+    }
+
+    std::vector<odc::api::ColumnInfo> columns = {
+        {std::string("date@hdr"), odc::api::ColumnType(odc::api::INTEGER), sizeof(int64_t)},
+        {std::string("level@body"), odc::api::ColumnType(odc::api::INTEGER), sizeof(int64_t)},
+        {std::string("obsvalue@body"), odc::api::ColumnType(odc::api::REAL), sizeof(double)},
+        {std::string("statid@hdr"), odc::api::ColumnType(odc::api::STRING), 8},
+    };
+
+    std::vector<odc::api::ConstStridedData> strides {
+        {data0, nrows, sizeof(int64_t), sizeof(int64_t)},
+        {data1, nrows, sizeof(int64_t), sizeof(int64_t)},
+        {data2, nrows, sizeof(double), sizeof(double)},
+        {data3, nrows, 8, 8},
+    };
+
+    {
+        eckit::FileHandle fh("column-statistics.odb");
+        fh.openForWrite(0);
+        eckit::AutoClose closer(fh);
+        encode(fh, columns, strides, {}, 4);
+    }
+
+    // The statistics of the first frame only
+
+    {
+        odc::api::Reader reader("column-statistics.odb", false);
+        odc::api::Frame frame = reader.next();
+        const auto& stats(frame.columnStatistics());
+        EXPECT(stats.size() == 4);
+
+        EXPECT(stats[1].name == "level@body");
+        EXPECT(stats[1].isConstant);
+        EXPECT(stats[1].min == 1 && stats[1].max == 1);
+
+        EXPECT(!stats[2].hasMissing);
+        EXPECT(stats[2].min == 0.0);
+        EXPECT(stats[2].max == double(static_cast<float>(0.1 * 3)));
+    }
+
+    // And combined across an aggregated frame
+
+    odc::api::Reader reader("column-statistics.odb");
+    odc::api::Frame frame = reader.next();
+    EXPECT(frame.rowCount() == nrows);
+
+    const auto& stats(frame.columnStatistics());
+    EXPECT(stats.size() == 4);
+
+    EXPECT(stats[0].name == "date@hdr");
+    EXPECT(stats[0].type == odc::api::INTEGER);
+    EXPECT(stats[0].isConstant);
+    EXPECT(!stats[0].hasMissing);
+    EXPECT(stats[0].min == 20210527 && stats[0].max == 20210527);
+
+    EXPECT(!stats[1].isConstant);
+    EXPECT(stats[1].min == 1 && stats[1].max == 2);
+
+    // The real values are decoded in single precision
+
+    EXPECT(stats[2].type == odc::api::REAL);
+    EXPECT(!stats[2].isConstant);
+    EXPECT(stats[2].hasMissing);
+    EXPECT(stats[2].missingValue == missing);
+    EXPECT(stats[2].min == 0.0);
+    EXPECT(stats[2].max == double(static_cast<float>(0.1 * 7)));
+
+    EXPECT(stats[3].isConstant);
+    EXPECT(::strncmp(reinterpret_cast<const char*>(&stats[3].min), "abc", 8) == 0);
+}
+
+CASE("Decode ranges and strides of rows") {
+
+    odc::api::Settings::treatIntegersAsDoubles(false);
+
+    for (bool aggregated : {false, true}) {
+
+        odc::api::Reader reader("../2000010106-reduced.odb", aggregated);
+        odc::api::Frame frame = reader.next();
+
+        size_t nrows = frame.rowCount();
+        const auto& columnInfo = frame.columnInfo();
+
+        std::vector<std::string> columns;
+        for (const auto& col : columnInfo) columns.push_back(col.name);
+
+        // Decode the specified rows into column-major buffers
+
+        auto decodeRows = [&](size_t firstRow, size_t count, size_t stride) {
+            std::vector<std::vector<char>> buffers;
+            std::vector<odc::api::StridedData> strides;
+            for (const auto& col : columnInfo) {
+                buffers.emplace_back(count * col.decodedSize);
+                strides.emplace_back(odc::api::StridedData{&buffers.back()[0], count, col.decodedSize, col.decodedSize});
+            }
+            odc::api::Decoder decoder(columns, strides);
+            if (firstRow == 0 && count == nrows && stride == 1) {
+                decoder.decode(frame);
+            } else {
+                decoder.decode(frame, firstRow, count, stride);
+            }
+            return buffers;
+        };
+
+        std::vector<std::vector<char>> all = decodeRows(0, nrows, 1);
+
+        auto check = [&](size_t firstRow, size_t count, size_t stride) {
+            std::vector<std::vector<char>> subset = decodeRows(firstRow, count, stride);
+            for (size_t c = 0; c < columnInfo.size(); ++c) {
+                size_t sz = columnInfo[c].decodedSize;
+                for (size_t r = 0; r < count; ++r) {
+                    EXPECT(::memcmp(&subset[c][r * sz], &all[c][(firstRow + r * stride) * sz], sz) == 0);
+                }
+            }
+        };
+
+        // The later ranges start from the checkpoints recorded by the earlier ones
+
+        check(4000, 1000, 1);
+        check(3, (nrows - 4) / 97, 97);
+        check(0, 10, 1);
+        check(nrows - 10, 10, 1);
+        check(5000, 1, 1);
+
+        EXPECT_THROWS_AS(decodeRows(nrows - 1, 2, 1), eckit::UserError);
+    }
+}
+
+// ------------------------------------------------------------------------------------------------------
+
 //CASE("Decode an entire ODB file") {
 //
 //    odc::api::Odb o("../2000010106-reduced.odb");
@@ -253,6 +253,45 @@ CASE("Check column details in an existing ODB file") {
     }
 }
 
+CASE("Retrieve column ranges without decoding") {
+
+    test_generate_odb("test-column-range.odb", 0);
+
+    odc_reader_t* reader = nullptr;
+    CHECK_RETURN(odc_open_path(&reader, "test-column-range.odb"));
+    std::unique_ptr<odc_reader_t> reader_deleter(reader);
+
+    odc_frame_t* frame = nullptr;
+    CHECK_RETURN(odc_new_frame(&frame, reader));
+    std::unique_ptr<odc_frame_t> frame_deleter(frame);
+
+    // Both of the frames, aggregated
+    CHECK_RETURN(odc_next_frame_aggregated(frame, 1000000));
+
+    double min;
+    double max;
+    bool has_missing;
+    bool is_constant;
+
+    // expver
+    CHECK_RETURN(odc_frame_column_range(frame, 0, nullptr, nullptr, &has_missing, nullptr));
+    EXPECT(!has_missing);
+
+    // date@hdr
+    CHECK_RETURN(odc_frame_column_range(frame, 1, &min, &max, &has_missing, &is_constant));
+    EXPECT(min == 20210527);
+    EXPECT(max == 20210527);
+    EXPECT(!has_missing);
+    EXPECT(is_constant);
+
+    // obsvalue@body
+    CHECK_RETURN(odc_frame_column_range(frame, 2, &min, &max, &has_missing, &is_constant));
+    EXPECT(min == 0);
+    EXPECT(max == double(static_cast<float>(12.3456 * 9)));
+    EXPECT(!has_missing);
+    EXPECT(!is_constant);
+}
+
 CASE("Decode data in an existing ODB file") {
 
     CHECK_RETURN(odc_integer_behaviour(ODC_INTEGERS_AS_LONGS));
@@ -0,0 +1,131 @@
+/*
+ * (C) Copyright 1996-2018 ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "eckit/testing/Test.h"
+
+#include "odc/ODBAPISettings.h"
+#include "odc/Writer.h"
+#include "odc/core/FrameIndex.h"
+#include "odc/sql/TablePredicate.h"
+
+#include "TemporaryFiles.h"
+
+using namespace eckit::testing;
+using odc::core::FrameIndex;
+using odc::sql::TablePredicate;
+
+// ------------------------------------------------------------------------------------------------------
+
+CASE("Bloom filters written alongside integers that are not treated as doubles") {
+
+    // Integers are written (and indexed) as int64_t values, but the filters are probed by value
+
+    odc::ODBAPISettings::instance().treatIntegersAsDoubles(false);
+    ::setenv("ODC_FRAME_INDEX_BLOOM_COLUMNS", "intcol", 1);
+
+    TemporaryFile tmp;
+    const int64_t values[] {1234, -56, 7890123};
+
+    {
+        odc::Writer<> oda(tmp.path());
+        oda.frameIndex(true);
+        odc::Writer<>::iterator writer = oda.begin();
+
+        writer->setNumberOfColumns(2);
+        writer->setColumn(0, "intcol", odc::api::INTEGER);
+        writer->setColumn(1, "realcol", odc::api::REAL);
+        writer->writeHeader();
+
+        for (int64_t v : values) {
+            reinterpret_cast<int64_t&>((*writer)[0]) = v;
+            (*writer)[1] = 1.5;
+            ++writer;
+        }
+    }
+
+    ::unsetenv("ODC_FRAME_INDEX_BLOOM_COLUMNS");
+    odc::ODBAPISettings::instance().treatIntegersAsDoubles(true);
+
+    FrameIndex index;
+    EXPECT(FrameIndex::find(tmp.path(), index));
+    EXPECT(index.frames().size() == 1);
+
+    const FrameIndex::ColumnStatistics* stats = index.frames()[0].column("intcol");
+    EXPECT(stats != nullptr);
+    EXPECT(!stats->bloom.empty());
+
+    for (int64_t v : values) {
+        EXPECT(stats->bloom.mayContain(FrameIndex::BloomFilter::hash(double(v))));
+    }
+
+    FrameIndex::indexPath(tmp.path()).unlink();
+}
+
+CASE("Frames are skipped for values absent from their Bloom filters") {
+
+    // The values are within the range of the column, so only the Bloom filter can exclude them
+
+    ::setenv("ODC_FRAME_INDEX_BLOOM_COLUMNS", "intcol", 1);
+    ::setenv("ODC_FRAME_INDEX_BLOOM_FPR", "0.000001", 1);
+
+    TemporaryFile tmp;
+
+    {
+        odc::Writer<> oda(tmp.path());
+        oda.frameIndex(true);
+        odc::Writer<>::iterator writer = oda.begin();
+
+        writer->setNumberOfColumns(1);
+        writer->setColumn(0, "intcol", odc::api::INTEGER);
+        writer->writeHeader();
+
+        for (double v : {10, 20, 30, 40}) {
+            (*writer)[0] = v;
+            ++writer;
+        }
+    }
+
+    ::unsetenv("ODC_FRAME_INDEX_BLOOM_COLUMNS");
+    ::unsetenv("ODC_FRAME_INDEX_BLOOM_FPR");
+
+    FrameIndex index;
+    EXPECT(FrameIndex::find(tmp.path(), index));
+    EXPECT(index.frames().size() == 1);
+    const FrameIndex::Frame& frame(index.frames()[0]);
+
+    std::vector<std::pair<std::string, TablePredicate::Match>> queries {
+        {"intcol = 25", TablePredicate::NONE},
+        {"intcol in (15, 25, 35)", TablePredicate::NONE},
+        {"intcol = 20", TablePredicate::SOME},
+        {"intcol in (15, 30)", TablePredicate::SOME},
+        {"intcol >= 10", TablePredicate::ALL},
+        {"intcol < 50", TablePredicate::ALL},
+    };
+
+    for (const auto& query : queries) {
+        std::unique_ptr<TablePredicate> predicate(TablePredicate::parse("select * where " + query.first + ";"));
+        EXPECT(predicate);
+        EXPECT(predicate->evaluate(frame) == query.second);
+    }
+
+    FrameIndex::indexPath(tmp.path()).unlink();
+}
+
+// ------------------------------------------------------------------------------------------------------
+
+int main(int argc, char* argv[]) {
+    return run_tests(argc, argv);
+}
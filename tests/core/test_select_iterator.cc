@@ -14,6 +14,7 @@
 #include "eckit/config/Resource.h"
 #include "eckit/system/SystemInfo.h"
 #include "eckit/filesystem/PathName.h"
+#include "eckit/io/FileHandle.h"
 #include "eckit/testing/Test.h"
 
 #include "odc/Select.h"
@@ -22,6 +23,9 @@
 #include "TemporaryFiles.h"
 
 #include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
 
 using namespace eckit::testing;
 
@@ -217,6 +221,179 @@ CASE("Test bugfix 02, quote <<UnitTest problem fixed with p4 change 23687>>") {
     EXPECT(count == 3);
 }
 
+CASE("Projections copied from the source rows match evaluated output") {
+
+    // Two frames, with the columns in different orders, and a non-default missing value
+
+    class TemporaryODB : public TemporaryFile {
+    public:
+        TemporaryODB(bool reversed) {
+            odc::Writer<> oda(path());
+            odc::Writer<>::iterator writer = oda.begin();
+
+            size_t a = reversed ? 2 : 0;
+            size_t c = reversed ? 0 : 2;
+
+            writer->setNumberOfColumns(4);
+            writer->setColumn(a, "a", odc::api::INTEGER);
+            writer->setColumn(1, "b", odc::api::REAL);
+            writer->setColumn(c, "c", odc::api::INTEGER);
+            writer->setColumn(3, "s", odc::api::STRING);
+            writer->missingValue(a, -5);
+            writer->writeHeader();
+
+            for (size_t i = 0; i < 10; ++i) {
+                (*writer)[a] = (i % 3 == 0) ? -5 : i;
+                (*writer)[1] = i * 0.5;
+                (*writer)[c] = 100 + i;
+                ::strncpy(reinterpret_cast<char*>(&(*writer)[3]), "abcd", sizeof(double));
+                ++writer;
+            }
+        }
+    };
+
+    TemporaryODB first(false);
+    TemporaryODB second(true);
+    TemporaryFile combined;
+    {
+        std::ofstream out(combined.path().asString().c_str(), std::ios::binary);
+        std::ifstream in1(first.path().asString().c_str(), std::ios::binary);
+        std::ifstream in2(second.path().asString().c_str(), std::ios::binary);
+        out << in1.rdbuf() << in2.rdbuf();
+    }
+
+    for (const std::string& columns : {std::string("*"), std::string("a, b, c"), std::string("c, a, s, b")}) {
+
+        // The path is only supplied in the FROM clause of the reference, so it is evaluated as normal
+
+        odc::Select copied("select " + columns + ";", combined.path());
+        odc::Select evaluated("select " + columns + " from \"" + combined.path() + "\";");
+
+        odc::Select::iterator it = copied.begin();
+        odc::Select::iterator ref = evaluated.begin();
+
+        size_t count = 0;
+        size_t missing = 0;
+        for (; it != copied.end() && ref != evaluated.end(); ++it, ++ref, ++count) {
+            EXPECT(it->columns().size() == ref->columns().size());
+            EXPECT(it->columns().size() == (columns == "a, b, c" ? 3 : 4));
+            for (size_t i = 0; i < it->columns().size(); ++i) {
+                EXPECT(it->columns()[i]->name() == ref->columns()[i]->name());
+                EXPECT((*it)[i] == (*ref)[i]);
+                if (it->columns()[i]->name() == "a" && (*it)[i] == it->columns()[i]->missingValue()) {
+                    ++missing;
+                }
+                EXPECT(!(it->columns()[i]->name() == "a" && (*it)[i] == -5));
+            }
+        }
+
+        EXPECT(count == 20);
+        EXPECT(missing == 8);
+        EXPECT(!(it != copied.end()));
+        EXPECT(!(ref != evaluated.end()));
+    }
+}
+
+
+/// Ten rows of integer columns, where b is 100 more than the other columns
+
+class TemporaryODB : public TemporaryFile {
+public:
+    TemporaryODB(const std::vector<std::string>& columns, double offset) {
+        odc::Writer<> oda(path());
+        odc::Writer<>::iterator writer = oda.begin();
+
+        writer->setNumberOfColumns(columns.size());
+        for (size_t i = 0; i < columns.size(); ++i) {
+            writer->setColumn(i, columns[i], odc::api::INTEGER);
+        }
+        writer->writeHeader();
+
+        for (size_t i = 0; i < 10; i++) {
+            for (size_t j = 0; j < columns.size(); ++j) {
+                (*writer)[j] = offset + i + (columns[j] == "b" ? 100 : 0);
+            }
+            ++writer;
+        }
+    }
+};
+
+CASE("The same select runs over several inputs") {
+
+    // The second and third inputs are compatible with the first (the third only by name). The last
+    // is not, and needs the statement to be parsed again.
+
+    std::vector<std::pair<std::unique_ptr<TemporaryODB>, double>> inputs;
+    inputs.emplace_back(new TemporaryODB({"a", "b"}, 0), 0);
+    inputs.emplace_back(new TemporaryODB({"a", "b"}, 1000), 1000);
+    inputs.emplace_back(new TemporaryODB({"b", "a"}, 2000), 2000);
+    inputs.emplace_back(new TemporaryODB({"a", "c", "b"}, 3000), 3000);
+
+    std::vector<std::unique_ptr<eckit::DataHandle>> handles;
+    odc::Select sel("select b, a where b - a = 100;", inputs.front().first->path());
+
+    for (size_t n = 0; n < inputs.size(); ++n) {
+
+        if (n % 2 == 0) {
+            sel.bind(inputs[n].first->path());
+        } else {
+            handles.emplace_back(new eckit::FileHandle(inputs[n].first->path()));
+            sel.bind(*handles.back());
+        }
+
+        double offset = inputs[n].second;
+        size_t count = 0;
+        for (odc::Select::iterator it = sel.begin(); it != sel.end(); ++it, ++count) {
+            EXPECT(it->columns().size() == 2);
+            EXPECT(it->columns()[0]->name() == "b");
+            EXPECT((*it)[0] == offset + count + 100);
+            EXPECT((*it)[1] == offset + count);
+        }
+        EXPECT(count == 10);
+    }
+
+    sel.bind(inputs.front().first->path());
+    for (auto& dh : handles) dh->close();
+}
+
+CASE("A select rebound part of the way through an input runs in full over the next") {
+
+    TemporaryODB first({"a", "b"}, 0);
+    TemporaryODB second({"a", "b"}, 1000);
+    TemporaryODB third({"a", "c", "b"}, 2000);
+
+    odc::Select sel("select b, a where b - a = 100;", first.path());
+
+    // The second input reuses the statement left part of the way through the first. The third is
+    // not compatible, so replaces the session that the partly used iterator belonged to.
+
+    std::vector<std::pair<const TemporaryODB*, double>> inputs {{&second, 1000}, {&third, 2000}};
+
+    for (const auto& input : inputs) {
+
+        sel.bind(first.path());
+
+        {
+            size_t count = 0;
+            for (odc::Select::iterator it = sel.begin(); it != sel.end() && count < 3; ++it, ++count) {
+                EXPECT((*it)[0] == count + 100);
+                EXPECT((*it)[1] == count);
+            }
+            EXPECT(count == 3);
+        }
+
+        sel.bind(input.first->path());
+
+        double offset = input.second;
+        size_t count = 0;
+        for (odc::Select::iterator it = sel.begin(); it != sel.end(); ++it, ++count) {
+            EXPECT((*it)[0] == offset + count + 100);
+            EXPECT((*it)[1] == offset + count);
+        }
+        EXPECT(count == 10);
+    }
+}
+
 // ------------------------------------------------------------------------------------------------------
 
 int main(int argc, char* argv[]) {
@@ -10,7 +10,10 @@
 
 #include <string>
 #include <cmath>
+#include <cstring>
 #include <algorithm>
+#include <sstream>
+#include <vector>
 
 #include "eckit/testing/Test.h"
 
@@ -19,6 +22,71 @@
 
 using namespace eckit::testing;
 
+namespace {
+
+// As in TextReaderIterator.cc. The text is parsed in blocks, which are split into parts.
+const size_t TEXT_BLOCK_SIZE = 8 * 1024 * 1024;
+const size_t MIN_PART_SIZE = 512 * 1024;
+
+const std::string LARGE_HEADER = "i:INTEGER,s:STRING\n";
+
+/// The (unquoted) string value of row k. The rows vary in length, so that they fall across the
+/// block and part boundaries at different places.
+std::string largeString(size_t k) {
+    return "s" + std::to_string(k) + "-" + std::string(k % 23, char('a' + k % 26));
+}
+
+std::vector<std::string> largeRows(size_t nrows) {
+    std::vector<std::string> rows;
+    rows.reserve(nrows);
+    for (size_t k = 0; k < nrows; ++k) {
+        rows.push_back(std::to_string(k) + ",'" + largeString(k) + "'\n");
+    }
+    return rows;
+}
+
+/// The row that holds the last byte of the first block
+size_t rowAtBlockBoundary(const std::vector<std::string>& rows) {
+    size_t offset = 0;
+    for (size_t k = 0; k < rows.size(); ++k) {
+        offset += rows[k].size();
+        if (offset >= TEXT_BLOCK_SIZE) return k;
+    }
+    ASSERT(false);
+    return 0;
+}
+
+std::string join(const std::vector<std::string>& rows) {
+    std::string text(LARGE_HEADER);
+    for (const std::string& row : rows) text += row;
+    return text;
+}
+
+/// Read the rows until an error is thrown, which should name the given line
+void expectErrorAtLine(const std::string& text, size_t badRow) {
+
+    std::stringstream data(text);
+    odc::TextReader reader(data, ",");
+    odc::TextReader::iterator it = reader.begin();
+
+    size_t count = 0;
+    std::string message;
+    try {
+        for (; it != reader.end(); ++it) {
+            EXPECT(it->data(0) == count);
+            ++count;
+        }
+    } catch (const eckit::UserError& e) {
+        message = e.what();
+    }
+
+    // n.b. The header is the first line
+    EXPECT(count == badRow);
+    EXPECT(message.find("at line " + std::to_string(badRow + 2) + " ") != std::string::npos);
+}
+
+}
+
 
 // ------------------------------------------------------------------------------------------------------
 
@@ -151,6 +219,77 @@ CASE("Test parsing bitfields - 32bit limit") {
     EXPECT_THROWS_AS(odc::TextReaderIterator::parseBitfields(bitfieldDefinition), eckit::UserError);
 }
 
+CASE("Read CSV lines that straddle the boundaries of the parsed blocks and parts") {
+
+    std::vector<std::string> rows(largeRows(800000));
+    std::string text(join(rows));
+    EXPECT(text.size() > 2 * TEXT_BLOCK_SIZE + MIN_PART_SIZE);
+
+    std::stringstream data(text);
+    odc::TextReader reader(data, ",");
+    odc::TextReader::iterator it = reader.begin();
+
+    size_t count = 0;
+    for (; it != reader.end(); ++it) {
+        const std::string expected(largeString(count));
+        EXPECT(it->data(0) == count);
+        EXPECT(it->dataSizeDoubles(1) * sizeof(double) >= expected.size());
+        EXPECT(::strncmp(expected.c_str(), (char*)&it->data(1), it->dataSizeDoubles(1) * sizeof(double)) == 0);
+        ++count;
+    }
+
+    EXPECT(count == rows.size());
+}
+
+CASE("Read a CSV line that is longer than a block") {
+
+    const std::string longString(TEXT_BLOCK_SIZE + TEXT_BLOCK_SIZE / 2, 'y');
+
+    std::stringstream data;
+    data << LARGE_HEADER;
+    data << "0,short\n";
+    data << "1,'" << longString << "'\n";
+    data << "2,short\n";
+
+    odc::TextReader reader(data, ",");
+    odc::TextReader::iterator it = reader.begin();
+
+    size_t count = 0;
+    for (; it != reader.end(); ++it) {
+        EXPECT(it->data(0) == count);
+        const char* s = (char*)&it->data(1);
+        if (count == 1) {
+            EXPECT(it->dataSizeDoubles(1) == longString.size() / sizeof(double));
+            EXPECT(::memcmp(s, longString.c_str(), longString.size()) == 0);
+        } else {
+            EXPECT(::strncmp(s, "short", it->dataSizeDoubles(1) * sizeof(double)) == 0);
+        }
+        ++count;
+    }
+
+    EXPECT(count == 3);
+}
+
+CASE("A quoted delimiter at the end of a block is split, as by StringTools::split") {
+
+    // n.b. Quotes are only removed from the fields once the line has been split
+
+    std::vector<std::string> rows(largeRows(400000));
+    size_t badRow = rowAtBlockBoundary(rows);
+    rows[badRow] = std::to_string(badRow) + ",'a,b'\n";
+
+    expectErrorAtLine(join(rows), badRow);
+}
+
+CASE("A CSV parse error in a later part of a later block is reported at its line") {
+
+    std::vector<std::string> rows(largeRows(800000));
+    size_t badRow = rowAtBlockBoundary(rows) + (rows.size() - rowAtBlockBoundary(rows)) / 2;
+    rows[badRow] = std::to_string(badRow) + ",'x',extra\n";
+
+    expectErrorAtLine(join(rows), badRow);
+}
+
 // ------------------------------------------------------------------------------------------------------
 
 int main(int argc, char* argv[]) {
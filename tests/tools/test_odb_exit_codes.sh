@@ -30,6 +30,9 @@ odc import data-1-2.csv data-2.odb
 [[ $(odc count data-1.odb) -eq 5 ]] || (echo "Unexpected number of rows in ODB data-1.odb" ; false)
 [[ $(odc count data-2.odb) -eq 5 ]] || (echo "Unexpected number of rows in ODB data-2.odb" ; false)
 
+sed 's/^321,0.0,0.0,123,777,0$/321,0.0,0.0,124,777,0/' data-1-2.csv > data-4.csv
+odc import data-4.csv data-4.odb
+
 cat > data-3.csv <<EOF
 date@hdr:INTEGER,lat@hdr:REAL,lon@hdr:REAL,obsvalue@body:REAL
 20210401,38.560001,-121.300003,101340.000000
@@ -62,6 +65,10 @@ expect_success () {
 odc compact || exit_code=$? ; expect_error
 odc compact data-1.odb || exit_code=$? ; expect_error
 odc compact data-1.odb data-compacted.odb && exit_code=$? ; expect_success
+odc compact -checksum -nthreads 2 data-1.odb data-compacted.odb && exit_code=$? ; expect_success
+odc compact -rowsperframe 2 data-1.odb data-compacted.odb && exit_code=$? ; expect_success
+odc compare data-1.odb data-compacted.odb && exit_code=$? ; expect_success
+odc compact -nthreads 0 data-1.odb data-compacted.odb || exit_code=$? ; expect_error
 odc compact data-1.odb data-compacted.odb foobar || exit_code=$? ; expect_error
 odc compact foobar data-compacted.odb || exit_code=$? ; expect_error
 odc help compact && exit_code=$? ; expect_success
@@ -72,6 +79,9 @@ odc compare || exit_code=$? ; expect_error
 odc compare data-1.odb || exit_code=$? ; expect_error
 odc compare data-1.odb data-2.odb && exit_code=$? ; expect_success
 odc compare -dontCheckMissing data-1.odb data-2.odb && exit_code=$? ; expect_success
+odc compare -nthreads 1 data-1.odb data-2.odb && exit_code=$? ; expect_success
+odc compare data-1.odb data-4.odb || exit_code=$? ; expect_error
+odc compare -nthreads 2 data-4.odb data-1.odb || exit_code=$? ; expect_error
 odc compare data-1.odb data-2.odb foobar || exit_code=$? ; expect_error
 odc compare foobar data-2.odb || exit_code=$? ; expect_error
 odc compare data-1.odb foobar || exit_code=$? ; expect_error
@@ -83,17 +93,73 @@ odc count || exit_code=$? ; expect_error
 odc count data-1.odb && exit_code=$? ; expect_success
 odc count foobar || exit_code=$? ; expect_error
 odc count data-1.odb foobar || exit_code=$? ; expect_error
+odc count -noverify -nthreads 2 data-1.odb data-2.odb && exit_code=$? ; expect_success
+[[ $(odc count -noverify data-1.odb data-2.odb data-3.odb) -eq 15 ]] || (echo "Unexpected header-only row count" ; false)
+[[ $(odc count -perfile data-1.odb data-2.odb | wc -l) -eq 3 ]] || (echo "Unexpected per-file count output" ; false)
+odc count -noverify data-1.odb foobar || exit_code=$? ; expect_error
 odc help count && exit_code=$? ; expect_success
 
+# Cat tool
+
+odc cat || exit_code=$? ; expect_error
+odc cat data-1.odb || exit_code=$? ; expect_error
+odc cat -o data-cat.odb data-1.odb data-2.odb && exit_code=$? ; expect_success
+[[ $(odc count data-cat.odb) -eq 10 ]] || (echo "Unexpected number of rows in ODB data-cat.odb" ; false)
+cat data-1.odb data-2.odb | cmp - data-cat.odb || (echo "Concatenated frames differ" ; false)
+odc cat -append -o data-cat.odb data-3.odb && exit_code=$? ; expect_success
+[[ $(odc count data-cat.odb) -eq 15 ]] || (echo "Unexpected number of rows in ODB data-cat.odb" ; false)
+odc cat -o data-cat.odb data-1.odb foobar || exit_code=$? ; expect_error
+odc help cat && exit_code=$? ; expect_success
+
+# Extract tool
+
+odc cat -o data-cat.odb data-1.odb data-3.odb data-2.odb && exit_code=$? ; expect_success
+odc extract || exit_code=$? ; expect_error
+odc extract -frames 1:1 -o data-extracted.odb data-cat.odb && exit_code=$? ; expect_success
+cmp data-extracted.odb data-3.odb || (echo "Unexpected frame extracted" ; false)
+odc extract -rows 6 -o data-extracted.odb data-cat.odb && exit_code=$? ; expect_success
+[[ $(odc count data-extracted.odb) -eq 10 ]] || (echo "Unexpected number of rows extracted" ; false)
+odc extract -span date@hdr=20210401/20210402 -o data-extracted.odb data-cat.odb data-1.odb && exit_code=$? ; expect_success
+cmp data-extracted.odb data-3.odb || (echo "Unexpected frame extracted" ; false)
+odc extract -span col1=321 -o data-extracted.odb data-1.odb data-2.odb && exit_code=$? ; expect_success
+[[ $(odc count data-extracted.odb) -eq 10 ]] || (echo "Unexpected number of rows extracted" ; false)
+odc extract -span obsvalue@body=290.2 -o data-extracted.odb data-cat.odb && exit_code=$? ; expect_success
+cmp data-extracted.odb data-3.odb || (echo "Unexpected frame extracted by a REAL value" ; false)
+odc extract -frames x -o data-extracted.odb data-cat.odb || exit_code=$? ; expect_error
+odc extract -span col1=abc -o data-extracted.odb data-1.odb || exit_code=$? ; expect_error
+odc help extract && exit_code=$? ; expect_success
+
 # Index tool
 
 odc index || exit_code=$? ; expect_error
-#
-# TODO: Check why this command does not work
-#
-# odc index data-3.odb && exit_code=$? ; expect_success
-# odc index data-3.odb data-3.odb.idx && exit_code=$? ; expect_success
-#
+cat > data-seqno.csv <<EOF
+seqno:INTEGER,obsvalue:REAL
+1,1.5
+1,2.5
+2,3.5
+EOF
+odc import data-seqno.csv data-seqno.odb
+odc index data-seqno.odb && exit_code=$? ; expect_success
+odc index -seqno data-seqno.odb data-seqno-2.odb.idx && exit_code=$? ; expect_success
+odc compare data-seqno.odb.idx data-seqno-2.odb.idx && exit_code=$? ; expect_success
+[[ $(odc count data-seqno.odb.idx) -eq 2 ]] || (echo "Unexpected number of entries in the seqno index" ; false)
+rm data-seqno.odb.idx data-seqno-2.odb.idx
+odc index -seqno -frames data-seqno.odb || exit_code=$? ; expect_error
+odc index -frames -nodistinct -nthreads 2 data-3.odb data-3.odb.idx && exit_code=$? ; expect_success
+odc index -frames data-3.odb && exit_code=$? ; expect_success
+odc sql -i data-3.odb -f odb -o data-3-indexed.odb "select * where date@hdr = 20210401" && exit_code=$? ; expect_success
+[[ $(odc count data-3-indexed.odb) -eq 5 ]] || (echo "Unexpected number of rows selected with frame index" ; false)
+odc compare data-3.odb data-3-indexed.odb && exit_code=$? ; expect_success
+odc sql -i data-3.odb -f odb -o data-3-indexed.odb "select * where date@hdr > 20210401" && exit_code=$? ; expect_success
+[[ $(odc count data-3-indexed.odb) -eq 0 ]] || (echo "Unexpected number of rows selected with frame index" ; false)
+rm data-3.odb.idx
+odc index -frames -bloom col1,col4 -fpr 0.001 data-1.odb && exit_code=$? ; expect_success
+odc sql -i data-1.odb -f odb -o data-1-bloom.odb "select * where col1 = 5" && exit_code=$? ; expect_success
+[[ $(odc count data-1-bloom.odb) -eq 0 ]] || (echo "Unexpected number of rows selected with Bloom filter" ; false)
+odc sql -i data-1.odb -f odb -o data-1-bloom.odb "select * where col1 in (1, 321) and col4 > 0" && exit_code=$? ; expect_success
+[[ $(odc count data-1-bloom.odb) -eq 2 ]] || (echo "Unexpected number of rows selected with Bloom filter" ; false)
+odc index -frames -bloom col1 -fpr 2 data-1.odb || exit_code=$? ; expect_error
+rm data-1.odb.idx
 odc index data-3.odb data-3.odb.idx foobar || exit_code=$? ; expect_error
 odc index foobar || exit_code=$? ; expect_error
 odc help index && exit_code=$? ; expect_success
@@ -123,6 +189,10 @@ odc ls || exit_code=$? ; expect_error
 odc ls data-1.odb && exit_code=$? ; expect_success
 odc ls data-1.odb foobar || exit_code=$? ; expect_error
 odc ls -o data-1.txt data-1.odb && exit_code=$? ; expect_success
+odc cat -o data-cat.odb data-1.odb data-3.odb data-1.odb && exit_code=$? ; expect_success
+odc ls -nthreads 1 -o data-cat-1.txt data-cat.odb && exit_code=$? ; expect_success
+odc ls -nthreads 3 -o data-cat-3.txt data-cat.odb && exit_code=$? ; expect_success
+cmp data-cat-1.txt data-cat-3.txt || (echo "Unexpected output from concurrent formatting" ; false)
 odc ls foobar || exit_code=$? ; expect_error
 odc help ls && exit_code=$? ; expect_success
 
@@ -133,6 +203,19 @@ odc mdset "col6:INTEGER=1" || exit_code=$? ; expect_error
 odc mdset "col6:INTEGER=1" data-1.odb || exit_code=$? ; expect_error
 odc mdset "col6:INTEGER=1" data-1.odb data-set.odb && exit_code=$? ; expect_success
 odc mdset "col6:INTEGER=1" data-1.odb data-set.odb foobar || exit_code=$? ; expect_error
+[[ $(odc sql -T -i data-set.odb "select count(*) where col6 = 1") -eq 5 ]] || (echo "Constant value not set" ; false)
+odc mdset -rename col6=col7 -missing col2=-1 "col6:INTEGER=2" data-1.odb data-set.odb && exit_code=$? ; expect_success
+[[ $(odc sql -T -i data-set.odb "select count(*) where col7 = 2") -eq 5 ]] || (echo "Column not renamed" ; false)
+printf 'col1:INTEGER,col2:REAL\n1,NULL\n2,3.25\n3,NULL\n4,0.5\n' > data-missing.csv
+odc import data-missing.csv data-missing.odb
+odc mdset -missing col2=-1 "col1" data-missing.odb data-set.odb && exit_code=$? ; expect_success
+[[ $(odc sql -T -i data-set.odb "select count(*) where col2 is null") -eq 2 ]] || (echo "Missing values not replaced" ; false)
+[[ $(odc sql -T -i data-set.odb "select count(*) where col2 = 3.25 or col2 = 0.5") -eq 2 ]] || (echo "Values changed with missing value" ; false)
+odc mdset "col6:INTEGER=1" data-1.odb data-1.odb || exit_code=$? ; expect_error
+[[ $(odc count data-1.odb) -eq 5 ]] || (echo "In-place mdset damaged its input" ; false)
+odc mdset "col1=5" data-1.odb data-set.odb && exit_code=$? ; expect_success
+[[ $(odc sql -T -i data-set.odb "select count(*) where col1 = 5") -eq 5 ]] || (echo "Non-constant column not re-encoded" ; false)
+odc mdset -rename foobar=col7 "col6:INTEGER=2" data-1.odb data-set.odb || exit_code=$? ; expect_error
 odc mdset "col6:INTEGER=1" foobar data-set.odb || exit_code=$? ; expect_error
 odc help mdset && exit_code=$? ; expect_success
 
@@ -147,6 +230,17 @@ odc merge -o data-merged.odb foobar data-3.odb || exit_code=$? ; expect_error
 odc merge data-1.odb data-3.odb && exit_code=$? ; expect_success
 odc help merge && exit_code=$? ; expect_success
 
+# Oda2request tool
+
+echo "DATE : date@hdr" > data-request.cfg
+odc oda2request || exit_code=$? ; expect_error
+odc oda2request -c data-request.cfg data-3.odb && exit_code=$? ; expect_success
+odc oda2request -c data-request.cfg -nthreads 2 data-3.odb data-3.req && exit_code=$? ; expect_success
+grep -q "DATE = 20210401" data-3.req || (echo "Unexpected request generated" ; false)
+odc oda2request -c data-request.cfg data-3.odb data-3.req foobar || exit_code=$? ; expect_error
+odc oda2request -c data-request.cfg foobar || exit_code=$? ; expect_error
+odc help oda2request && exit_code=$? ; expect_success
+
 # Header tool
 
 odc header || exit_code=$? ; expect_error
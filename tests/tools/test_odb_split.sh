@@ -36,6 +36,96 @@ for i in 1,9 2,183 3,2415 4,2415 9,119 110,9 112,119 119,44519 123,119 206,93; d
 done
 ls -lh
 
+# Every frame of the split output has a constant varno, so splitting their concatenation again copies
+# the frames without decoding them. The results should match.
+
+mkdir -p resplit
+cat 2000010106_varno_*.odb > resplit/all.odb
+cd resplit
+odc split all.odb "2000010106_varno_{varno}.odb"
+
+for i in 1,9 2,183 3,2415 4,2415 9,119 110,9 112,119 119,44519 123,119 206,93; do
+
+    IFS=","
+    set $i
+    nrows=$(odc count 2000010106_varno_$1.odb)
+    if [[ $nrows -ne $2 ]]; then
+        echo "Mismatched odb size from re-split. Got $nrows rows, expected $2"
+        exit -1;
+    fi
+    cmp 2000010106_varno_$1.odb ../2000010106_varno_$1.odb
+    unset IFS
+
+done
+cd ..
+rm -rf resplit
+
+# Split again, pre-sorting the data using a small memory limit so that the sort must spill to
+# (and merge from) multiple temporary files. The results should match.
+
+rm *.odb || true
+mkdir -p tmp
+
+odc split -sort -sortmemory 1 -tmpdir tmp ../../2000010106-reduced.odb "2000010106_varno_{varno}.odb"
+
+nfiles=$(ls -lh *.odb | wc -l)
+
+if [[ $nfiles -ne 10 ]]; then
+    echo "Got $nfiles output files from sorted split. Expected 10"
+    exit -1
+fi
+
+for i in 1,9 2,183 3,2415 4,2415 9,119 110,9 112,119 119,44519 123,119 206,93; do
+
+    IFS=","
+    set $i
+    nrows=$(odc count 2000010106_varno_$1.odb)
+    if [[ $nrows -ne $2 ]]; then
+        echo "Mismatched odb size from sorted split. Got $nrows rows, expected $2"
+        exit -1;
+    fi
+    unset IFS
+
+done
+
+ntmp=$(ls tmp | wc -l)
+if [[ $ntmp -ne 0 ]]; then
+    echo "Temporary sort files not cleaned up"
+    exit -1
+fi
+
+# And using hash partitioned temporary files
+
+rm *.odb || true
+
+odc split -partitions 4 -tmpdir tmp ../../2000010106-reduced.odb "2000010106_varno_{varno}.odb"
+
+nfiles=$(ls -lh *.odb | wc -l)
+
+if [[ $nfiles -ne 10 ]]; then
+    echo "Got $nfiles output files from partitioned split. Expected 10"
+    exit -1
+fi
+
+for i in 1,9 2,183 3,2415 4,2415 9,119 110,9 112,119 119,44519 123,119 206,93; do
+
+    IFS=","
+    set $i
+    nrows=$(odc count 2000010106_varno_$1.odb)
+    if [[ $nrows -ne $2 ]]; then
+        echo "Mismatched odb size from partitioned split. Got $nrows rows, expected $2"
+        exit -1;
+    fi
+    unset IFS
+
+done
+
+ntmp=$(ls tmp | wc -l)
+if [[ $ntmp -ne 0 ]]; then
+    echo "Temporary partition files not cleaned up"
+    exit -1
+fi
+
 # Clean up
 
 cd ${wd}